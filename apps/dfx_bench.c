@@ -0,0 +1,659 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+/* End-to-end benchmark of the libdfx init/load/remove/destroy paths.
+ *
+ * The library is pointed (dfx_set_root()) at a generated directory tree
+ * that mimics the fpga_manager class, the FPGA device nodes, the configfs
+ * overlay directory and a dma-heap, so the benchmark runs on any Linux
+ * host without FPGA hardware. The packages use DFX_BUFFER_MEMFD buffers,
+ * the heap node of the tree is a regular file.
+ *
+ * For every combination of image size, package count and thread count the
+ * packages are spread over the threads, each thread bound to its own FPGA
+ * manager, and every operation is timed. Results are written as JSON.
+ *
+ * --ktrace-check instead runs one load with the kernel trace mode enabled
+ * on a fake tracefs. Kernel events with known timestamps are appended to
+ * its `trace` file from inside the load, through the log sink, and the
+ * kernel phase durations of the load record are compared with them.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "libdfx.h"
+#include "dfx_fake_tree.h"
+
+#define BENCH_MAX_LIST		16
+#define BENCH_PATH_LEN		512
+#define BENCH_CHUNK		(1UL << 20)
+#define NSEC_PER_SEC		1000000000ULL
+
+enum bench_op {
+	OP_INIT = 0,
+	OP_LOAD,
+	OP_REMOVE,
+	OP_DESTROY,
+	OP_MAX
+};
+
+static const char *const op_names[OP_MAX] = {
+	"init", "load", "remove", "destroy"
+};
+
+struct bench_list {
+	unsigned long long val[BENCH_MAX_LIST];
+	int count;
+};
+
+struct op_result {
+	unsigned long long *lat_ns;
+	unsigned long long wall_ns;
+	int count;
+	int errors;
+};
+
+struct bench_run {
+	const char *root;
+	char image[BENCH_PATH_LEN];
+	char dtbo[BENCH_PATH_LEN];
+	int packages;
+	int threads;
+	int iterations;
+	int *ids;
+	struct op_result res[OP_MAX];
+};
+
+struct ktrace_check {
+	char trace[BENCH_PATH_LEN];
+	long tid;
+	int armed;
+	int verbose;
+	unsigned long long expect_ns[DFX_KPHASE_MAX];
+};
+
+struct bench_worker {
+	struct bench_run *run;
+	enum bench_op op;
+	int index;
+	int iteration;
+	pthread_t thread;
+};
+
+static unsigned long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static int write_image(const char *path, unsigned long long size)
+{
+	unsigned long long left = size;
+	unsigned char *chunk;
+	size_t len, i;
+	FILE *fp;
+	int ret = 0;
+
+	chunk = malloc(BENCH_CHUNK);
+	if (chunk == NULL)
+		return -1;
+	for (i = 0; i < BENCH_CHUNK; i++)
+		chunk[i] = (unsigned char)(i * 2654435761U >> 24);
+
+	fp = fopen(path, "wb");
+	if (fp == NULL) {
+		fprintf(stderr, "dfx_bench: cannot create `%s`: %s\n", path,
+			strerror(errno));
+		free(chunk);
+		return -1;
+	}
+
+	while (left) {
+		len = left < BENCH_CHUNK ? left : BENCH_CHUNK;
+		if (fwrite(chunk, 1, len, fp) != len) {
+			fprintf(stderr, "dfx_bench: short write to `%s`\n", path);
+			ret = -1;
+			break;
+		}
+		left -= len;
+	}
+
+	fclose(fp);
+	free(chunk);
+	return ret;
+}
+
+static void ktrace_event(FILE *fp, long tid, const char *name,
+			 const char *symbol, unsigned long long ts)
+{
+	fprintf(fp, "       dfx_bench-%ld    [000] .....  %llu.%09llu: %s: "
+		"(%s+0x0/0x0)\n", tid, ts / NSEC_PER_SEC, ts % NSEC_PER_SEC,
+		name, symbol);
+}
+
+/*
+ * Log sink of --ktrace-check. The first dfx_cfg_load() message of the
+ * armed thread comes after dfx_ktrace_begin(), so the events appended
+ * here are inside the traced window. A pair from another task checks
+ * that the library only attributes events of the loading thread.
+ */
+static void ktrace_check_sink(enum dfx_log_level level, const char *msg,
+			      void *arg)
+{
+	struct ktrace_check *kc = arg;
+	struct timespec delay = { 0, 1000000 };
+	unsigned long long t0, t1, q;
+	FILE *fp;
+
+	if (kc->verbose)
+		dfx_log_stderr_sink(level, msg, NULL);
+	if (!kc->armed || syscall(SYS_gettid) != kc->tid ||
+	    strncmp(msg, "dfx_cfg_load:", strlen("dfx_cfg_load:")))
+		return;
+	kc->armed = 0;
+
+	fp = fopen(kc->trace, "a");
+	if (fp == NULL)
+		return;
+
+	t0 = now_ns();
+	nanosleep(&delay, NULL);
+	t1 = now_ns();
+	q = (t1 - t0) / 4;
+
+	ktrace_event(fp, kc->tid, "overlay_apply_enter",
+		     "of_overlay_fdt_apply", t0);
+	ktrace_event(fp, kc->tid, "mgr_load_enter", "fpga_mgr_load", t0 + q);
+	ktrace_event(fp, kc->tid + 1, "mgr_load_enter", "fpga_mgr_load", t0);
+	ktrace_event(fp, kc->tid, "fw_request_enter", "_request_firmware",
+		     t0 + q);
+	ktrace_event(fp, kc->tid, "fw_request_exit", "_request_firmware",
+		     t0 + 2 * q);
+	ktrace_event(fp, kc->tid + 1, "mgr_load_exit", "fpga_mgr_load", t1);
+	ktrace_event(fp, kc->tid, "mgr_load_exit", "fpga_mgr_load", t0 + 3 * q);
+	ktrace_event(fp, kc->tid, "overlay_apply_exit",
+		     "of_overlay_fdt_apply", t1);
+	fclose(fp);
+
+	kc->expect_ns[DFX_KPHASE_FIRMWARE] = q;
+	kc->expect_ns[DFX_KPHASE_FPGA_MGR_LOAD] = 2 * q;
+	kc->expect_ns[DFX_KPHASE_OVERLAY_APPLY] = t1 - t0;
+}
+
+/* Loads one package on a fake tracefs and checks the kernel phases */
+static int ktrace_check(const char *root, const char *dtbo, int verbose)
+{
+	static const char *const kphase_names[DFX_KPHASE_MAX] = {
+		"firmware", "fpga_mgr_load", "overlay_apply"
+	};
+	static struct ktrace_check kc;
+	char dir[BENCH_PATH_LEN];
+	char image[BENCH_PATH_LEN];
+	struct dfx_stats stats;
+	int id, k, ret = -1;
+
+	snprintf(image, sizeof(image), "%s/images/ktrace.bin", root);
+	if (write_image(image, 1024) || dfx_fake_tracefs_build(root))
+		return -1;
+	snprintf(dir, sizeof(dir), "%s/tracing", root);
+	snprintf(kc.trace, sizeof(kc.trace), "%s/trace", dir);
+	kc.tid = syscall(SYS_gettid);
+	kc.verbose = verbose;
+	dfx_set_log_sink(ktrace_check_sink, &kc);
+
+	if (dfx_ktrace_enable(dir)) {
+		fprintf(stderr, "dfx_bench: dfx_ktrace_enable() failed\n");
+		goto END;
+	}
+
+	id = dfx_cfg_init_file(image, dtbo, NULL, NULL, "fpga0",
+			       DFX_BUFFER_MEMFD, NULL);
+	if (id < 0) {
+		fprintf(stderr, "dfx_bench: init failed: %d\n", id);
+		goto DISABLE;
+	}
+
+	kc.armed = 1;
+	ret = dfx_cfg_load(id);
+	if (ret == 0 && kc.armed) {
+		fprintf(stderr, "dfx_bench: no dfx_cfg_load() message to "
+			"inject the kernel events from\n");
+		ret = -1;
+	}
+	kc.armed = 0;
+	if (ret == 0)
+		ret = dfx_get_stats(id, &stats);
+	if (ret) {
+		fprintf(stderr, "dfx_bench: load failed: %d\n", ret);
+		goto DESTROY;
+	}
+
+	for (k = 0; k < DFX_KPHASE_MAX; k++) {
+		int seen = !!(stats.last_load.kphase_mask & (1U << k));
+
+		printf("%-14s %s %llu ns, expected %llu ns\n", kphase_names[k],
+		       seen ? "seen" : "missing", stats.last_load.kphase_ns[k],
+		       kc.expect_ns[k]);
+		if (!seen || stats.last_load.kphase_ns[k] != kc.expect_ns[k])
+			ret = -1;
+	}
+	printf("ktrace check: %s\n", ret ? "FAILED" : "ok");
+
+	dfx_cfg_remove(id);
+DESTROY:
+	dfx_cfg_destroy(id);
+DISABLE:
+	dfx_ktrace_disable();
+END:
+	dfx_set_log_sink(verbose ? dfx_log_stderr_sink : NULL, NULL);
+	return ret;
+}
+
+static void *bench_worker_fn(void *arg)
+{
+	struct bench_worker *w = arg;
+	struct bench_run *run = w->run;
+	struct op_result *res = &run->res[w->op];
+	unsigned long long t0;
+	char devpath[32];
+	int pkg, ret, slot;
+
+	snprintf(devpath, sizeof(devpath), "fpga%d", w->index);
+
+	for (pkg = w->index; pkg < run->packages; pkg += run->threads) {
+		slot = w->iteration * run->packages + pkg;
+
+		if (w->op != OP_INIT && run->ids[pkg] < 0) {
+			res->lat_ns[slot] = 0;
+			continue;
+		}
+
+		t0 = now_ns();
+		switch (w->op) {
+		case OP_INIT:
+			ret = dfx_cfg_init_file(run->image, run->dtbo, NULL,
+						NULL, devpath, DFX_BUFFER_MEMFD,
+						NULL);
+			run->ids[pkg] = ret;
+			break;
+		case OP_LOAD:
+			ret = dfx_cfg_load(run->ids[pkg]);
+			break;
+		case OP_REMOVE:
+			ret = dfx_cfg_remove(run->ids[pkg]);
+			break;
+		default:
+			ret = dfx_cfg_destroy(run->ids[pkg]);
+			run->ids[pkg] = -1;
+			break;
+		}
+		res->lat_ns[slot] = now_ns() - t0;
+
+		if (ret < 0)
+			__atomic_fetch_add(&res->errors, 1, __ATOMIC_RELAXED);
+	}
+
+	return NULL;
+}
+
+/* Runs one operation over all packages on all threads and times it */
+static void bench_phase(struct bench_run *run, enum bench_op op, int iteration)
+{
+	struct bench_worker *workers;
+	unsigned long long t0;
+	int i;
+
+	workers = calloc(run->threads, sizeof(*workers));
+	if (workers == NULL)
+		return;
+
+	t0 = now_ns();
+	for (i = 0; i < run->threads; i++) {
+		workers[i].run = run;
+		workers[i].op = op;
+		workers[i].index = i;
+		workers[i].iteration = iteration;
+		pthread_create(&workers[i].thread, NULL, bench_worker_fn,
+			       &workers[i]);
+	}
+	for (i = 0; i < run->threads; i++)
+		pthread_join(workers[i].thread, NULL);
+
+	run->res[op].wall_ns += now_ns() - t0;
+	run->res[op].count += run->packages;
+	free(workers);
+}
+
+static int cmp_ull(const void *a, const void *b)
+{
+	unsigned long long x = *(const unsigned long long *)a;
+	unsigned long long y = *(const unsigned long long *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static double percentile_us(const unsigned long long *sorted, int count,
+			    double p)
+{
+	int idx;
+
+	if (count == 0)
+		return 0;
+
+	idx = (int)(p / 100.0 * count + 0.999999) - 1;
+	if (idx < 0)
+		idx = 0;
+	if (idx >= count)
+		idx = count - 1;
+
+	return sorted[idx] / 1000.0;
+}
+
+static void print_op(FILE *out, enum bench_op op, struct op_result *res,
+		     int last)
+{
+	double wall = res->wall_ns / 1e9;
+
+	qsort(res->lat_ns, res->count, sizeof(*res->lat_ns), cmp_ull);
+	fprintf(out, "        \"%s\": {\"count\": %d, \"errors\": %d, "
+		"\"wall_s\": %.6f, \"ops_per_s\": %.1f, "
+		"\"p50_us\": %.1f, \"p90_us\": %.1f, \"p99_us\": %.1f, "
+		"\"max_us\": %.1f}%s\n",
+		op_names[op], res->count, res->errors, wall,
+		wall > 0 ? res->count / wall : 0.0,
+		percentile_us(res->lat_ns, res->count, 50),
+		percentile_us(res->lat_ns, res->count, 90),
+		percentile_us(res->lat_ns, res->count, 99),
+		res->count ? res->lat_ns[res->count - 1] / 1000.0 : 0.0,
+		last ? "" : ",");
+}
+
+static int bench_config(FILE *out, const char *root, const char *image,
+			unsigned long long size, int packages, int threads,
+			int iterations, int first)
+{
+	struct bench_run run;
+	int i, op, ret = -1;
+
+	memset(&run, 0, sizeof(run));
+	run.root = root;
+	run.packages = packages;
+	run.threads = threads;
+	run.iterations = iterations;
+	strncpy(run.image, image, sizeof(run.image) - 1);
+	snprintf(run.dtbo, sizeof(run.dtbo), "%s/images/bench.dtbo", root);
+
+	run.ids = malloc(packages * sizeof(*run.ids));
+	if (run.ids == NULL)
+		goto END;
+	for (op = 0; op < OP_MAX; op++) {
+		int slots = packages;
+
+		if (op == OP_LOAD || op == OP_REMOVE)
+			slots *= iterations;
+		run.res[op].lat_ns = calloc(slots, sizeof(unsigned long long));
+		if (run.res[op].lat_ns == NULL)
+			goto END;
+	}
+
+	bench_phase(&run, OP_INIT, 0);
+	for (i = 0; i < iterations; i++) {
+		bench_phase(&run, OP_LOAD, i);
+		bench_phase(&run, OP_REMOVE, i);
+	}
+	bench_phase(&run, OP_DESTROY, 0);
+
+	fprintf(out, "%s    {\"image_size\": %llu, \"packages\": %d, "
+		"\"threads\": %d, \"iterations\": %d,\n      \"ops\": {\n",
+		first ? "" : ",\n", size, packages, threads, iterations);
+	for (op = 0; op < OP_MAX; op++)
+		print_op(out, op, &run.res[op], op == OP_MAX - 1);
+	fprintf(out, "      }}");
+	ret = 0;
+
+END:
+	for (op = 0; op < OP_MAX; op++)
+		free(run.res[op].lat_ns);
+	free(run.ids);
+	return ret;
+}
+
+static int parse_size(const char *str, unsigned long long *val)
+{
+	char *end;
+
+	*val = strtoull(str, &end, 0);
+	switch (*end) {
+	case 'G': case 'g':
+		*val <<= 10;
+		/* fall through */
+	case 'M': case 'm':
+		*val <<= 10;
+		/* fall through */
+	case 'K': case 'k':
+		*val <<= 10;
+		end++;
+		break;
+	}
+
+	return (end == str || *end != '\0' || *val == 0) ? -1 : 0;
+}
+
+static int parse_list(const char *str, struct bench_list *list)
+{
+	char *copy, *tok, *save;
+	int ret = 0;
+
+	copy = strdup(str);
+	if (copy == NULL)
+		return -1;
+
+	list->count = 0;
+	for (tok = strtok_r(copy, ",", &save); tok != NULL;
+	     tok = strtok_r(NULL, ",", &save)) {
+		if (list->count == BENCH_MAX_LIST ||
+		    parse_size(tok, &list->val[list->count])) {
+			ret = -1;
+			break;
+		}
+		list->count++;
+	}
+
+	free(copy);
+	return (ret || list->count == 0) ? -1 : 0;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -s, --sizes LIST         image sizes (default 1M,16M,128M,512M)\n"
+		"  -p, --packages LIST      package counts (default 1,100,1000,10000)\n"
+		"  -t, --threads LIST       thread counts (default 1,4)\n"
+		"  -n, --iterations N       load/remove cycles per package (default 3)\n"
+		"  -m, --max-resident SIZE  skip runs holding more image data (default 1G)\n"
+		"  -r, --root DIR           build the fake tree in DIR and keep it\n"
+		"  -o, --output FILE        write the JSON report to FILE (default stdout)\n"
+		"  -v, --verbose            print the library messages to stderr\n"
+		"  -k, --ktrace-check       check the kernel trace mode on a fake\n"
+		"                           tracefs instead of benchmarking\n"
+		"Sizes accept K, M and G suffixes.\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+	static const struct option opts[] = {
+		{ "sizes", required_argument, NULL, 's' },
+		{ "packages", required_argument, NULL, 'p' },
+		{ "threads", required_argument, NULL, 't' },
+		{ "iterations", required_argument, NULL, 'n' },
+		{ "max-resident", required_argument, NULL, 'm' },
+		{ "root", required_argument, NULL, 'r' },
+		{ "output", required_argument, NULL, 'o' },
+		{ "verbose", no_argument, NULL, 'v' },
+		{ "ktrace-check", no_argument, NULL, 'k' },
+		{ "help", no_argument, NULL, 'h' },
+		{ NULL, 0, NULL, 0 },
+	};
+	struct bench_list sizes, packages, threads;
+	unsigned long long max_resident = 1ULL << 30;
+	char root[BENCH_PATH_LEN] = "";
+	char image[BENCH_PATH_LEN];
+	const char *output = NULL;
+	int iterations = 3, verbose = 0, keep = 0, first = 1, kcheck = 0;
+	int max_threads = 1, c, si, pi, ti, ret = 1;
+	struct rlimit rl;
+	FILE *out;
+
+	parse_list("1M,16M,128M,512M", &sizes);
+	parse_list("1,100,1000,10000", &packages);
+	parse_list("1,4", &threads);
+
+	while ((c = getopt_long(argc, argv, "s:p:t:n:m:r:o:vkh", opts,
+				NULL)) != -1) {
+		switch (c) {
+		case 's':
+			if (parse_list(optarg, &sizes))
+				goto bad_arg;
+			break;
+		case 'p':
+			if (parse_list(optarg, &packages))
+				goto bad_arg;
+			break;
+		case 't':
+			if (parse_list(optarg, &threads))
+				goto bad_arg;
+			break;
+		case 'n':
+			iterations = atoi(optarg);
+			if (iterations <= 0)
+				goto bad_arg;
+			break;
+		case 'm':
+			if (parse_size(optarg, &max_resident))
+				goto bad_arg;
+			break;
+		case 'r':
+			strncpy(root, optarg, sizeof(root) - 1);
+			keep = 1;
+			break;
+		case 'o':
+			output = optarg;
+			break;
+		case 'v':
+			verbose = 1;
+			break;
+		case 'k':
+			kcheck = 1;
+			break;
+		case 'h':
+			usage(argv[0]);
+			return 0;
+		default:
+			goto bad_arg;
+		}
+	}
+
+	for (ti = 0; ti < threads.count; ti++) {
+		if ((int)threads.val[ti] > max_threads)
+			max_threads = threads.val[ti];
+	}
+
+	/* Every package holds a heap device fd and a buffer fd */
+	if (!getrlimit(RLIMIT_NOFILE, &rl)) {
+		rl.rlim_cur = rl.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &rl);
+	}
+
+	if (root[0] == '\0') {
+		snprintf(root, sizeof(root), "/tmp/dfx_bench.XXXXXX");
+		if (mkdtemp(root) == NULL) {
+			perror("dfx_bench: mkdtemp");
+			return 1;
+		}
+	} else if (mkdir(root, 0755) && errno != EEXIST) {
+		perror("dfx_bench: mkdir");
+		return 1;
+	}
+
+	if (dfx_fake_tree_build(root, max_threads))
+		goto cleanup;
+	snprintf(image, sizeof(image), "%s/images/bench.dtbo", root);
+	if (write_image(image, 1024))
+		goto cleanup;
+
+	if (kcheck) {
+		ret = ktrace_check(root, image, verbose) ? 1 : 0;
+		goto cleanup;
+	}
+
+	if (verbose)
+		dfx_set_log_sink(dfx_log_stderr_sink, NULL);
+
+	out = output != NULL ? fopen(output, "w") : stdout;
+	if (out == NULL) {
+		perror("dfx_bench: output");
+		goto cleanup;
+	}
+
+	fprintf(out, "{\n  \"benchmark\": \"dfx_bench\",\n"
+		"  \"root\": \"%s\",\n  \"results\": [\n", root);
+
+	for (si = 0; si < sizes.count; si++) {
+		snprintf(image, sizeof(image), "%s/images/image_%llu.bin",
+			 root, sizes.val[si]);
+		if (write_image(image, sizes.val[si]))
+			break;
+
+		for (pi = 0; pi < packages.count; pi++) {
+			for (ti = 0; ti < threads.count; ti++) {
+				if (sizes.val[si] * packages.val[pi] > max_resident) {
+					fprintf(out, "%s    {\"image_size\": %llu, "
+						"\"packages\": %llu, \"threads\": %llu, "
+						"\"skipped\": \"max-resident\"}",
+						first ? "" : ",\n", sizes.val[si],
+						packages.val[pi], threads.val[ti]);
+				} else {
+					bench_config(out, root, image,
+						     sizes.val[si],
+						     packages.val[pi],
+						     threads.val[ti],
+						     iterations, first);
+				}
+				first = 0;
+				fflush(out);
+			}
+		}
+
+		unlink(image);
+	}
+
+	fprintf(out, "\n  ]\n}\n");
+	if (out != stdout)
+		fclose(out);
+	ret = 0;
+
+cleanup:
+	if (!keep)
+		dfx_fake_tree_remove(root);
+	return ret;
+
+bad_arg:
+	usage(argv[0]);
+	return 1;
+}
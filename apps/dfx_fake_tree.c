@@ -0,0 +1,154 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <ftw.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "libdfx.h"
+#include "dfx_fake_tree.h"
+
+#define FAKE_PATH_LEN	512
+
+static int write_file(const char *dir, const char *name, const char *src)
+{
+	char path[FAKE_PATH_LEN];
+	FILE *fp;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	fp = fopen(path, "w");
+	if (fp == NULL) {
+		fprintf(stderr, "dfx_fake_tree: cannot create `%s`: %s\n", path,
+			strerror(errno));
+		return -1;
+	}
+	fputs(src, fp);
+	fclose(fp);
+
+	return 0;
+}
+
+static int make_dir(const char *root, const char *name)
+{
+	char path[FAKE_PATH_LEN];
+
+	snprintf(path, sizeof(path), "%s/%s", root, name);
+	if (mkdir(path, 0755) && errno != EEXIST) {
+		fprintf(stderr, "dfx_fake_tree: cannot create `%s`: %s\n", path,
+			strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * dfx_fake_tree_build() - generate the fake kernel interfaces under @root
+ *
+ * @root:	directory to populate
+ * @managers:	number of FPGA managers (fpga0 .. fpgaN-1) to create
+ *
+ * Return:	0 on success, -1 on failure
+ */
+int dfx_fake_tree_build(const char *root, int managers)
+{
+	static const char *const dirs[] = {
+		"fpga_manager", "dev", "overlays", "dma_heap", "devicetree",
+		"firmware", "images",
+	};
+	char path[FAKE_PATH_LEN];
+	char name[32];
+	size_t i;
+	int mgr;
+
+	for (i = 0; i < sizeof(dirs) / sizeof(dirs[0]); i++) {
+		if (make_dir(root, dirs[i]))
+			return -1;
+	}
+
+	for (mgr = 0; mgr < managers; mgr++) {
+		snprintf(name, sizeof(name), "fpga_manager/fpga%d", mgr);
+		if (make_dir(root, name))
+			return -1;
+		snprintf(path, sizeof(path), "%s/%s", root, name);
+		if (write_file(path, "name", "Xilinx Versal FPGA Manager\n") ||
+		    write_file(path, "state", "operating\n") ||
+		    write_file(path, "flags", "0\n") ||
+		    write_file(path, "key", "") ||
+		    write_file(path, "firmware", ""))
+			return -1;
+
+		snprintf(name, sizeof(name), "dev/fpga%d", mgr);
+		if (write_file(root, name, ""))
+			return -1;
+	}
+
+	if (write_file(root, "dma_heap/reserved", "") ||
+	    write_file(root, "firmware/uid-read", "") ||
+	    write_file(root, "fw_search_path", ""))
+		return -1;
+
+	snprintf(path, sizeof(path), "%s/fpga_manager", root);
+	dfx_set_root(DFX_ROOT_FPGA_MGR, path);
+	snprintf(path, sizeof(path), "%s/dev", root);
+	dfx_set_root(DFX_ROOT_DEV, path);
+	snprintf(path, sizeof(path), "%s/overlays", root);
+	dfx_set_root(DFX_ROOT_OVERLAYS, path);
+	snprintf(path, sizeof(path), "%s/dma_heap", root);
+	dfx_set_root(DFX_ROOT_DMA_HEAP, path);
+	snprintf(path, sizeof(path), "%s/devicetree", root);
+	dfx_set_root(DFX_ROOT_DEVICETREE, path);
+	snprintf(path, sizeof(path), "%s/fw_search_path", root);
+	dfx_set_root(DFX_ROOT_FW_SEARCH_PATH, path);
+	snprintf(path, sizeof(path), "%s/firmware", root);
+	dfx_set_root(DFX_ROOT_VERSAL_FW, path);
+
+	return 0;
+}
+
+/**
+ * dfx_fake_tracefs_build() - generate a fake tracefs under @root/tracing
+ *
+ * @root:	directory holding the fake tree
+ *
+ * Return:	0 on success, -1 on failure
+ */
+int dfx_fake_tracefs_build(const char *root)
+{
+	char path[FAKE_PATH_LEN];
+
+	if (make_dir(root, "tracing") ||
+	    make_dir(root, "tracing/events") ||
+	    make_dir(root, "tracing/events/libdfx"))
+		return -1;
+
+	snprintf(path, sizeof(path), "%s/tracing", root);
+	if (write_file(path, "kprobe_events", "") ||
+	    write_file(path, "trace_clock", "[local] global mono\n") ||
+	    write_file(path, "tracing_on", "0\n") ||
+	    write_file(path, "trace", "") ||
+	    write_file(path, "events/libdfx/enable", "0\n"))
+		return -1;
+
+	return 0;
+}
+
+static int remove_entry(const char *path, const struct stat *st, int flag,
+			struct FTW *ftw)
+{
+	(void)st;
+	(void)flag;
+	(void)ftw;
+
+	return remove(path);
+}
+
+void dfx_fake_tree_remove(const char *root)
+{
+	nftw(root, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
@@ -0,0 +1,32 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#ifndef __DFX_FAKE_TREE_H
+#define __DFX_FAKE_TREE_H
+
+/* Generates a directory tree under @root that mimics the fpga_manager
+ * class with @managers managers (fpga0 .. fpgaN-1), their device nodes,
+ * the configfs overlay directory and a dma-heap, and points the library at
+ * it with dfx_set_root(). The heap node is a regular file the library
+ * cannot allocate from, packages must be initialized with DFX_BUFFER_MEMFD.
+ * @root/images is left for the caller's image files.
+ *
+ * Return: 0 on success, -1 on failure.
+ */
+int dfx_fake_tree_build(const char *root, int managers);
+
+/* Generates a tracefs mount point at @root/tracing for
+ * dfx_ktrace_enable(), without instances: the kprobe_events, trace_clock,
+ * tracing_on and trace files and the events/libdfx/enable switch. Nothing
+ * writes kernel events, the caller appends its own lines to `trace`.
+ *
+ * Return: 0 on success, -1 on failure.
+ */
+int dfx_fake_tracefs_build(const char *root);
+
+/* Removes @root and everything below it */
+void dfx_fake_tree_remove(const char *root);
+
+#endif
@@ -0,0 +1,430 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+/* Packs a package folder, or files named on the command line, into a
+ * single .dfxpkg container (see dfx_pkg_format.h) that dfx_cfg_init()
+ * accepts in place of the folder.
+ *
+ * Folder contents are picked up by the same suffix rules as dfx_cfg_init():
+ * .pdi, .bin or .bit for the image, _i.dtbo or .dtbo for the image overlay,
+ * _d.dtbo for the driver overlay and .nky for the key. The key itself is
+ * not packed, only its file name, which is resolved next to the container.
+ */
+
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <endian.h>
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#include "dfx_digest.h"
+#include "dfx_pkg_format.h"
+
+#define PACK_PATH_LEN		512
+#define PACK_META_LEN		4096
+#define PACK_CHUNK		(1U << 20)
+
+struct pack_input {
+	const char *label;
+	char path[PACK_PATH_LEN];	/* source file, empty if absent */
+	const void *data;		/* inline payload, used if path is empty */
+	size_t size;
+};
+
+static struct pack_input inputs[DFX_PKG_ENTRY_MAX] = {
+	[DFX_PKG_ENTRY_IMAGE] = { .label = "image" },
+	[DFX_PKG_ENTRY_IMAGE_DTBO] = { .label = "image dtbo" },
+	[DFX_PKG_ENTRY_DRIVERS_DTBO] = { .label = "drivers dtbo" },
+	[DFX_PKG_ENTRY_KEY_REF] = { .label = "key reference" },
+	[DFX_PKG_ENTRY_META] = { .label = "metadata" },
+};
+
+static char key_ref[PACK_PATH_LEN];
+static char meta[PACK_META_LEN];
+static size_t meta_len;
+
+static int has_suffix(const char *name, const char *suffix)
+{
+	size_t len = strlen(name), n = strlen(suffix);
+
+	return len > n && !strcasecmp(name + len - n, suffix);
+}
+
+static const char *base_name(const char *path)
+{
+	const char *slash = strrchr(path, '/');
+
+	return slash ? slash + 1 : path;
+}
+
+static int set_input(int type, const char *dir, const char *name)
+{
+	struct pack_input *in = &inputs[type];
+
+	if (in->path[0] != '\0') {
+		fprintf(stderr, "dfx_pack: more than one %s: `%s` and `%s`\n",
+			in->label, base_name(in->path), name);
+		return -1;
+	}
+	snprintf(in->path, sizeof(in->path), "%s%s%s", dir ? dir : "",
+		 dir ? "/" : "", name);
+
+	return 0;
+}
+
+/* Picks the package files out of @dir, unless given explicitly */
+static int scan_folder(const char *dir)
+{
+	struct dirent *ent;
+	int type, ret = 0;
+	DIR *d;
+
+	d = opendir(dir);
+	if (d == NULL) {
+		fprintf(stderr, "dfx_pack: cannot open `%s`: %s\n", dir,
+			strerror(errno));
+		return -1;
+	}
+
+	while (ret == 0 && (ent = readdir(d)) != NULL) {
+		if (has_suffix(ent->d_name, ".pdi") ||
+		    has_suffix(ent->d_name, ".bin") ||
+		    has_suffix(ent->d_name, ".bit"))
+			type = DFX_PKG_ENTRY_IMAGE;
+		else if (has_suffix(ent->d_name, "_d.dtbo"))
+			type = DFX_PKG_ENTRY_DRIVERS_DTBO;
+		else if (has_suffix(ent->d_name, ".dtbo"))
+			type = DFX_PKG_ENTRY_IMAGE_DTBO;
+		else if (has_suffix(ent->d_name, ".nky"))
+			type = DFX_PKG_ENTRY_KEY_REF;
+		else
+			continue;
+
+		if (type == DFX_PKG_ENTRY_KEY_REF) {
+			if (key_ref[0] == '\0')
+				snprintf(key_ref, sizeof(key_ref), "%s",
+					 ent->d_name);
+			continue;
+		}
+		ret = set_input(type, dir, ent->d_name);
+	}
+	closedir(d);
+
+	return ret;
+}
+
+static int add_meta(const char *line)
+{
+	size_t len = strlen(line);
+
+	if (strchr(line, '=') == NULL || strchr(line, '\n') != NULL ||
+	    meta_len + len + 1 >= sizeof(meta)) {
+		fprintf(stderr, "dfx_pack: bad metadata `%s`\n", line);
+		return -1;
+	}
+	memcpy(meta + meta_len, line, len);
+	meta_len += len;
+	meta[meta_len++] = '\n';
+
+	return 0;
+}
+
+static int write_zeroes(FILE *out, size_t len)
+{
+	static const char zero[256];
+	size_t n;
+
+	for (; len > 0; len -= n) {
+		n = len < sizeof(zero) ? len : sizeof(zero);
+		if (fwrite(zero, 1, n, out) != n)
+			return -1;
+	}
+
+	return 0;
+}
+
+/* Appends one payload at @offset, filling in its entry */
+static int write_payload(FILE *out, struct pack_input *in, uint64_t offset,
+			 struct dfx_pkg_entry *ent, char *buf)
+{
+	uint32_t crc = 0;
+	uint64_t size = 0;
+	size_t n;
+	FILE *fp;
+
+	if (in->path[0] == '\0') {
+		crc = dfx_crc32c(0, in->data, in->size);
+		if (fwrite(in->data, 1, in->size, out) != in->size)
+			return -1;
+		size = in->size;
+	} else {
+		fp = fopen(in->path, "rb");
+		if (fp == NULL) {
+			fprintf(stderr, "dfx_pack: cannot open `%s`: %s\n",
+				in->path, strerror(errno));
+			return -1;
+		}
+		while ((n = fread(buf, 1, PACK_CHUNK, fp)) > 0) {
+			crc = dfx_crc32c(crc, buf, n);
+			if (fwrite(buf, 1, n, out) != n) {
+				fclose(fp);
+				return -1;
+			}
+			size += n;
+		}
+		fclose(fp);
+	}
+
+	ent->crc32c = htole32(crc);
+	ent->offset = htole64(offset);
+	ent->size = htole64(size);
+
+	return 0;
+}
+
+static int write_container(const char *output, const char *name)
+{
+	struct dfx_pkg_entry ents[DFX_PKG_ENTRY_MAX];
+	char tmp[PACK_PATH_LEN + 8];
+	struct dfx_pkg_header hdr;
+	uint64_t offset;
+	unsigned int n = 0;
+	int type, ret = -1;
+	char *buf;
+	FILE *out;
+
+	buf = malloc(PACK_CHUNK);
+	if (buf == NULL)
+		return -1;
+
+	/* Written under a temporary name so readers never see half of it */
+	snprintf(tmp, sizeof(tmp), "%s.tmp", output);
+	out = fopen(tmp, "wb");
+	if (out == NULL) {
+		fprintf(stderr, "dfx_pack: cannot create `%s`: %s\n", tmp,
+			strerror(errno));
+		free(buf);
+		return -1;
+	}
+
+	memset(ents, 0, sizeof(ents));
+	for (type = 1; type < DFX_PKG_ENTRY_MAX; type++) {
+		if (inputs[type].path[0] != '\0' || inputs[type].data != NULL)
+			n++;
+	}
+
+	offset = sizeof(hdr) + n * sizeof(ents[0]);
+	n = 0;
+	for (type = 1; type < DFX_PKG_ENTRY_MAX; type++) {
+		struct pack_input *in = &inputs[type];
+		long pos;
+
+		if (in->path[0] == '\0' && in->data == NULL)
+			continue;
+
+		offset = (offset + DFX_PKG_ALIGN - 1) & ~(uint64_t)(DFX_PKG_ALIGN - 1);
+		pos = ftell(out);
+		if (pos < 0 || write_zeroes(out, offset - pos))
+			goto END;
+		ents[n].type = htole32(type);
+		snprintf(ents[n].name, sizeof(ents[n].name), "%s",
+			 in->path[0] ? base_name(in->path) : in->label);
+		if (write_payload(out, in, offset, &ents[n], buf))
+			goto END;
+		offset += le64toh(ents[n].size);
+		n++;
+	}
+
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, DFX_PKG_MAGIC, sizeof(hdr.magic));
+	hdr.version = htole32(DFX_PKG_VERSION);
+	hdr.num_entries = htole32(n);
+	snprintf(hdr.name, sizeof(hdr.name), "%s", name);
+	if (fseek(out, 0, SEEK_SET) ||
+	    fwrite(&hdr, sizeof(hdr), 1, out) != 1 ||
+	    fwrite(ents, sizeof(ents[0]), n, out) != n)
+		goto END;
+	ret = 0;
+END:
+	if (fclose(out) || ret) {
+		fprintf(stderr, "dfx_pack: cannot write `%s`\n", tmp);
+		remove(tmp);
+		ret = -1;
+	} else if (rename(tmp, output)) {
+		fprintf(stderr, "dfx_pack: cannot rename `%s`: %s\n", tmp,
+			strerror(errno));
+		remove(tmp);
+		ret = -1;
+	}
+	free(buf);
+
+	return ret;
+}
+
+static int list_container(const char *path)
+{
+	static const char *const types[DFX_PKG_ENTRY_MAX] = {
+		[DFX_PKG_ENTRY_IMAGE] = "image",
+		[DFX_PKG_ENTRY_IMAGE_DTBO] = "image_dtbo",
+		[DFX_PKG_ENTRY_DRIVERS_DTBO] = "drivers_dtbo",
+		[DFX_PKG_ENTRY_KEY_REF] = "key_ref",
+		[DFX_PKG_ENTRY_META] = "meta",
+	};
+	struct dfx_pkg_header hdr;
+	struct dfx_pkg_entry ent;
+	uint32_t i, type;
+	FILE *fp;
+
+	fp = fopen(path, "rb");
+	if (fp == NULL) {
+		fprintf(stderr, "dfx_pack: cannot open `%s`: %s\n", path,
+			strerror(errno));
+		return -1;
+	}
+	if (fread(&hdr, sizeof(hdr), 1, fp) != 1 ||
+	    memcmp(hdr.magic, DFX_PKG_MAGIC, sizeof(hdr.magic))) {
+		fprintf(stderr, "dfx_pack: `%s` is not a package container\n",
+			path);
+		fclose(fp);
+		return -1;
+	}
+
+	hdr.name[sizeof(hdr.name) - 1] = '\0';
+	printf("package %s, version %u, %u entries\n", hdr.name,
+	       le32toh(hdr.version), le32toh(hdr.num_entries));
+	for (i = 0; i < le32toh(hdr.num_entries); i++) {
+		if (fread(&ent, sizeof(ent), 1, fp) != 1)
+			break;
+		type = le32toh(ent.type);
+		ent.name[sizeof(ent.name) - 1] = '\0';
+		printf("  %-13s %-32s offset %10llu size %10llu crc32c %08x\n",
+		       type < DFX_PKG_ENTRY_MAX && types[type] ? types[type] : "?",
+		       ent.name, (unsigned long long)le64toh(ent.offset),
+		       (unsigned long long)le64toh(ent.size),
+		       le32toh(ent.crc32c));
+	}
+	fclose(fp);
+
+	return 0;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"Usage: %s [options] -o OUTPUT%s [PACKAGE_DIR]\n"
+		"       %s -l CONTAINER\n"
+		"  -o, --output FILE    container to write\n"
+		"  -n, --name NAME      package name (default: the folder name)\n"
+		"  -i, --image FILE     image (.pdi, .bin or .bit)\n"
+		"  -t, --dtbo FILE      image overlay\n"
+		"  -d, --drivers FILE   driver overlay\n"
+		"  -k, --key PATH       .nky file, relative to the container\n"
+		"  -m, --meta KEY=VALUE add a metadata line, may be repeated\n"
+		"  -l, --list FILE      print the entries of a container\n",
+		prog, DFX_PKG_SUFFIX, prog);
+}
+
+int main(int argc, char **argv)
+{
+	static const struct option opts[] = {
+		{ "output", required_argument, NULL, 'o' },
+		{ "name", required_argument, NULL, 'n' },
+		{ "image", required_argument, NULL, 'i' },
+		{ "dtbo", required_argument, NULL, 't' },
+		{ "drivers", required_argument, NULL, 'd' },
+		{ "key", required_argument, NULL, 'k' },
+		{ "meta", required_argument, NULL, 'm' },
+		{ "list", required_argument, NULL, 'l' },
+		{ "help", no_argument, NULL, 'h' },
+		{ NULL, 0, NULL, 0 },
+	};
+	const char *output = NULL, *name = NULL, *dir = NULL;
+	char folder[PACK_PATH_LEN], line[64];
+	time_t now;
+	size_t len;
+	int c;
+
+	while ((c = getopt_long(argc, argv, "o:n:i:t:d:k:m:l:h", opts,
+				NULL)) != -1) {
+		switch (c) {
+		case 'o':
+			output = optarg;
+			break;
+		case 'n':
+			name = optarg;
+			break;
+		case 'i':
+			if (set_input(DFX_PKG_ENTRY_IMAGE, NULL, optarg))
+				return 1;
+			break;
+		case 't':
+			if (set_input(DFX_PKG_ENTRY_IMAGE_DTBO, NULL, optarg))
+				return 1;
+			break;
+		case 'd':
+			if (set_input(DFX_PKG_ENTRY_DRIVERS_DTBO, NULL, optarg))
+				return 1;
+			break;
+		case 'k':
+			snprintf(key_ref, sizeof(key_ref), "%s", optarg);
+			break;
+		case 'm':
+			if (add_meta(optarg))
+				return 1;
+			break;
+		case 'l':
+			return list_container(optarg) ? 1 : 0;
+		case 'h':
+			usage(argv[0]);
+			return 0;
+		default:
+			goto bad_arg;
+		}
+	}
+	if (output == NULL || optind < argc - 1)
+		goto bad_arg;
+
+	if (optind == argc - 1) {
+		snprintf(folder, sizeof(folder), "%s", argv[optind]);
+		len = strlen(folder);
+		while (len > 1 && folder[len - 1] == '/')
+			folder[--len] = '\0';
+		dir = folder;
+		if (scan_folder(dir))
+			return 1;
+	}
+
+	if (inputs[DFX_PKG_ENTRY_IMAGE_DTBO].path[0] == '\0') {
+		fprintf(stderr, "dfx_pack: no image overlay\n");
+		return 1;
+	}
+	if (key_ref[0] != '\0') {
+		inputs[DFX_PKG_ENTRY_KEY_REF].data = key_ref;
+		inputs[DFX_PKG_ENTRY_KEY_REF].size = strlen(key_ref);
+	}
+
+	now = time(NULL);
+	strftime(line, sizeof(line), "created=%Y-%m-%dT%H:%M:%SZ",
+		 gmtime(&now));
+	if (add_meta(line))
+		return 1;
+	inputs[DFX_PKG_ENTRY_META].data = meta;
+	inputs[DFX_PKG_ENTRY_META].size = meta_len;
+
+	/* Overlay directories are named after the package, as for folders */
+	if (name == NULL)
+		name = dir ? base_name(dir) : "";
+
+	return write_container(output, name) ? 1 : 0;
+
+bad_arg:
+	usage(argv[0]);
+	return 1;
+}
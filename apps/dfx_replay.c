@@ -0,0 +1,884 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+/* Replays an API call trace recorded with dfx_trace_start().
+ *
+ * Every thread of the recording gets its own replay thread, which issues
+ * that thread's calls in order at the recorded offsets (scaled by --speed).
+ * Package ids are translated from the recording to the ids returned by the
+ * replayed init calls. The library reuses the id of a destroyed package,
+ * so a call is matched to the init that last returned its id before it;
+ * calls on packages whose init is not part of the trace are skipped.
+ *
+ * With --fake the calls run against a generated fake tree (see
+ * dfx_fake_tree.h), missing image files are replaced by stubs and packages
+ * are initialized with DFX_BUFFER_MEMFD, so field traces can be replayed on
+ * any Linux host. dfx_cfg_init_mem() and dfx_cfg_init_dmabuf() calls are
+ * replayed with zero-filled buffers of the recorded lengths, the latter
+ * from the default dma-heap, or a memfd in fake mode.
+ * dfx_cfg_load_timed() gets the deadline it had left when it was recorded.
+ *
+ * The report compares the recorded and replayed latency of every call type.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <getopt.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "libdfx.h"
+#include "dma-heap.h"
+#include "dfx_trace_format.h"
+#include "dfx_fake_tree.h"
+
+#define REPLAY_PATH_LEN		512
+#define REPLAY_MAX_MAPS		8
+#define REPLAY_MAX_MGRS		64
+#define NSEC_PER_SEC		1000000000ULL
+
+static const char *const op_names[DFX_TRACE_OP_MAX] = {
+	[DFX_TRACE_OP_CFG_INIT] = "cfg_init",
+	[DFX_TRACE_OP_CFG_INIT_FILE] = "cfg_init_file",
+	[DFX_TRACE_OP_CFG_LOAD] = "cfg_load",
+	[DFX_TRACE_OP_CFG_DRIVERS_LOAD] = "cfg_drivers_load",
+	[DFX_TRACE_OP_CFG_REMOVE] = "cfg_remove",
+	[DFX_TRACE_OP_CFG_DESTROY] = "cfg_destroy",
+	[DFX_TRACE_OP_GET_ACTIVE_UID_LIST] = "get_active_uid_list",
+	[DFX_TRACE_OP_GET_META_HEADER] = "get_meta_header",
+	[DFX_TRACE_OP_CFG_INIT_MEM] = "cfg_init_mem",
+	[DFX_TRACE_OP_CFG_INIT_DMABUF] = "cfg_init_dmabuf",
+	[DFX_TRACE_OP_CFG_LOAD_TIMED] = "cfg_load_timed",
+	[DFX_TRACE_OP_CFG_HINT] = "cfg_hint",
+};
+
+enum map_state {
+	MAP_PENDING = 0,	/* the init has not been replayed yet */
+	MAP_READY,
+	MAP_ERROR,
+};
+
+struct replay_call {
+	struct dfx_trace_record rec;
+	const char *strs[DFX_TRACE_MAX_STRS];
+	unsigned long long replay_ns;
+	int replay_result;
+	int replayed;
+	int slot;		/* id map slot of the package init, -1 if none */
+};
+
+struct replay_thread {
+	uint32_t tid;
+	int *calls;
+	int count;
+	int alloc;
+	pthread_t thread;
+};
+
+struct path_map {
+	const char *from;
+	const char *to;
+};
+
+static struct replay_call *calls;
+static int ncalls;
+static struct replay_thread *threads;
+static int nthreads;
+static unsigned long long trace_start_ns;
+static unsigned long long replay_start_ns;
+static double speed = 1.0;
+static int dropped;
+
+static struct path_map maps[REPLAY_MAX_MAPS];
+static int nmaps;
+static const char *fake_root;
+static unsigned long long stub_size = 1ULL << 20;
+static int stub_count;
+
+/* Indexed by slot, one per recorded init that returned a package id */
+static enum map_state *id_state;
+static int *id_map;
+static int id_slots;
+static int id_max;
+static pthread_mutex_t id_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t id_cond = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t stub_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static unsigned long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/* Whether @op returns a package id */
+static int is_init_op(int op)
+{
+	return op == DFX_TRACE_OP_CFG_INIT || op == DFX_TRACE_OP_CFG_INIT_FILE ||
+	       op == DFX_TRACE_OP_CFG_INIT_MEM ||
+	       op == DFX_TRACE_OP_CFG_INIT_DMABUF;
+}
+
+/* Whether @op takes a package id */
+static int is_package_op(int op)
+{
+	return (op >= DFX_TRACE_OP_CFG_LOAD &&
+		op <= DFX_TRACE_OP_CFG_DESTROY) ||
+	       op == DFX_TRACE_OP_CFG_LOAD_TIMED ||
+	       op == DFX_TRACE_OP_CFG_HINT;
+}
+
+/**
+ * alloc_dmabuf() - allocate a buffer for a replayed dfx_cfg_init_dmabuf()
+ *
+ * @len:	recorded image length
+ *
+ * Return:	fd of a zero-filled buffer of @len bytes, -1 on failure
+ */
+static int alloc_dmabuf(size_t len)
+{
+	struct dma_heap_allocation_data alloc = {
+		.len = len,
+		.fd_flags = O_RDWR | O_CLOEXEC,
+	};
+	int fd;
+
+	if (fake_root) {
+		fd = memfd_create("dfx_replay", MFD_CLOEXEC);
+		if (fd >= 0 && ftruncate(fd, len)) {
+			close(fd);
+			fd = -1;
+		}
+		return fd;
+	}
+
+	fd = open("/dev/dma_heap/reserved", O_RDWR | O_CLOEXEC);
+	if (fd < 0)
+		return -1;
+	if (ioctl(fd, DMA_HEAP_IOCTL_ALLOC, &alloc) < 0)
+		alloc.fd = -1;
+	close(fd);
+
+	return alloc.fd;
+}
+
+static int write_stub(const char *path, unsigned long long size)
+{
+	static const unsigned char fill[4096];
+	unsigned long long left = size;
+	size_t len;
+	FILE *fp;
+
+	fp = fopen(path, "wb");
+	if (fp == NULL)
+		return -1;
+	while (left) {
+		len = left < sizeof(fill) ? left : sizeof(fill);
+		if (fwrite(fill, 1, len, fp) != len)
+			break;
+		left -= len;
+	}
+	fclose(fp);
+
+	return left ? -1 : 0;
+}
+
+/**
+ * map_path() - translate a recorded path for the replay host
+ *
+ * @path:	recorded path, may be NULL
+ * @is_dir:	@path is a package directory (dfx_cfg_init())
+ * @buf:	output buffer of REPLAY_PATH_LEN bytes
+ *
+ * Applies the first matching --map prefix substitution. In fake mode a
+ * path that does not exist is replaced by a stub in the fake tree which
+ * keeps the file name, since the library derives names from it.
+ *
+ * Return:	the path to use
+ */
+static const char *map_path(const char *path, int is_dir, char *buf)
+{
+	char stub[REPLAY_PATH_LEN], base[NAME_MAX + 1];
+	const char *name;
+	size_t len;
+	int i;
+
+	if (path == NULL)
+		return NULL;
+
+	snprintf(buf, REPLAY_PATH_LEN, "%s", path);
+	for (i = 0; i < nmaps; i++) {
+		len = strlen(maps[i].from);
+		if (!strncmp(path, maps[i].from, len)) {
+			snprintf(buf, REPLAY_PATH_LEN, "%s%s", maps[i].to,
+				 path + len);
+			break;
+		}
+	}
+
+	if (fake_root == NULL || access(buf, F_OK) == 0)
+		return buf;
+
+	len = strlen(buf);
+	while (len > 1 && buf[len - 1] == '/')
+		buf[--len] = '\0';
+	name = strrchr(buf, '/');
+	snprintf(base, sizeof(base), "%s", name ? name + 1 : buf);
+
+	pthread_mutex_lock(&stub_lock);
+	snprintf(stub, sizeof(stub), "%s/images/%d", fake_root, stub_count++);
+	mkdir(stub, 0755);
+	if (is_dir) {
+		strncat(stub, "/", sizeof(stub) - strlen(stub) - 1);
+		strncat(stub, base, sizeof(stub) - strlen(stub) - 1);
+		mkdir(stub, 0755);
+		snprintf(buf, REPLAY_PATH_LEN, "%s/stub.pdi", stub);
+		write_stub(buf, stub_size);
+		snprintf(buf, REPLAY_PATH_LEN, "%s/stub_i.dtbo", stub);
+		write_stub(buf, 1024);
+		snprintf(buf, REPLAY_PATH_LEN, "%s", stub);
+	} else {
+		snprintf(buf, REPLAY_PATH_LEN, "%s/%s", stub, base);
+		write_stub(buf, strstr(base, ".dtbo") ? 1024 : stub_size);
+	}
+	pthread_mutex_unlock(&stub_lock);
+
+	return buf;
+}
+
+/* Waits for the replayed id of the init in @slot, -1 if there is none */
+static int lookup_id(int slot)
+{
+	int id = -1;
+
+	if (slot < 0)
+		return -1;
+
+	pthread_mutex_lock(&id_lock);
+	while (id_state[slot] == MAP_PENDING)
+		pthread_cond_wait(&id_cond, &id_lock);
+	if (id_state[slot] == MAP_READY)
+		id = id_map[slot];
+	pthread_mutex_unlock(&id_lock);
+
+	return id;
+}
+
+static void publish_id(int slot, int id)
+{
+	if (slot < 0)
+		return;
+
+	pthread_mutex_lock(&id_lock);
+	id_map[slot] = id;
+	id_state[slot] = id > 0 ? MAP_READY : MAP_ERROR;
+	pthread_cond_broadcast(&id_cond);
+	pthread_mutex_unlock(&id_lock);
+}
+
+static void replay_one(struct replay_call *c)
+{
+	char p[DFX_TRACE_MAX_STRS][REPLAY_PATH_LEN];
+	const struct dfx_trace_record *r = &c->rec;
+	const char *s[DFX_TRACE_MAX_STRS];
+	unsigned long long t0;
+	unsigned long flags = r->flags;
+	long long budget = 0;
+	void *mem[3] = { NULL, NULL, NULL };
+	size_t mem_len[3] = { 0, 0, 0 };
+	int id = 0, buffd = -1, ret, i;
+	int *buf = NULL;
+
+	if (is_package_op(r->op)) {
+		id = lookup_id(c->slot);
+		if (id < 0)
+			return;
+	}
+
+	/* Image paths are mapped (and stubbed) outside of the timed call */
+	for (i = 0; i < DFX_TRACE_MAX_STRS; i++)
+		s[i] = c->strs[i];
+	if (r->op == DFX_TRACE_OP_CFG_INIT) {
+		s[0] = map_path(c->strs[0], 1, p[0]);
+		if (fake_root) {
+			s[2] = NULL;
+			flags = (flags & ~DFX_BUFFER_MASK) | DFX_BUFFER_MEMFD;
+		}
+	} else if (r->op == DFX_TRACE_OP_CFG_INIT_FILE) {
+		for (i = 0; i < 4; i++)
+			s[i] = map_path(c->strs[i], 0, p[i]);
+		if (fake_root) {
+			s[5] = NULL;
+			flags = (flags & ~DFX_BUFFER_MASK) | DFX_BUFFER_MEMFD;
+		}
+	} else if (r->op == DFX_TRACE_OP_CFG_INIT_MEM) {
+		for (i = 0; i < 3; i++) {
+			if (c->strs[2 + i] != NULL)
+				mem_len[i] = strtoull(c->strs[2 + i], NULL, 10);
+			if (mem_len[i])
+				mem[i] = calloc(mem_len[i], 1);
+		}
+		if (fake_root) {
+			s[1] = NULL;
+			flags = (flags & ~DFX_BUFFER_MASK) | DFX_BUFFER_MEMFD;
+		}
+	} else if (r->op == DFX_TRACE_OP_CFG_INIT_DMABUF) {
+		for (i = 0; i < 3; i++)
+			s[i] = map_path(c->strs[i], 0, p[i]);
+		if (c->strs[4] != NULL)
+			mem_len[0] = strtoull(c->strs[4], NULL, 10);
+		buffd = alloc_dmabuf(mem_len[0]);
+		if (fake_root)
+			flags = (flags & ~DFX_BUFFER_MASK) | DFX_BUFFER_MEMFD;
+	} else if (r->op == DFX_TRACE_OP_GET_META_HEADER) {
+		s[0] = map_path(c->strs[0], 0, p[0]);
+	} else if (r->op == DFX_TRACE_OP_CFG_LOAD_TIMED &&
+		   c->strs[0] != NULL) {
+		budget = strtoll(c->strs[0], NULL, 10);
+	}
+	if (r->op == DFX_TRACE_OP_GET_ACTIVE_UID_LIST)
+		buf = calloc(r->flags > 4096 * sizeof(int) ? r->flags :
+			     4096 * sizeof(int), 1);
+	else if (r->op == DFX_TRACE_OP_GET_META_HEADER)
+		buf = calloc(r->flags + 1, sizeof(int));
+
+	t0 = now_ns();
+	switch (r->op) {
+	case DFX_TRACE_OP_CFG_INIT:
+		ret = dfx_cfg_init(s[0], s[1], flags, s[2]);
+		break;
+	case DFX_TRACE_OP_CFG_INIT_FILE:
+		ret = dfx_cfg_init_file(s[0], s[1], s[2], s[3], s[4], flags,
+					s[5]);
+		break;
+	case DFX_TRACE_OP_CFG_INIT_MEM:
+		ret = dfx_cfg_init_mem(mem[0], mem_len[0], mem[1], mem_len[1],
+				       mem[2], mem_len[2], s[0], flags, s[1]);
+		break;
+	case DFX_TRACE_OP_CFG_INIT_DMABUF:
+		ret = buffd < 0 ? -1 :
+		      dfx_cfg_init_dmabuf(buffd, mem_len[0], s[0], s[1], s[2],
+					  s[3], flags);
+		break;
+	case DFX_TRACE_OP_CFG_LOAD:
+		ret = dfx_cfg_load(id);
+		break;
+	case DFX_TRACE_OP_CFG_LOAD_TIMED:
+		ret = dfx_cfg_load_timed(id, t0 + budget);
+		break;
+	case DFX_TRACE_OP_CFG_HINT:
+		ret = dfx_cfg_hint(id, r->flags);
+		break;
+	case DFX_TRACE_OP_CFG_DRIVERS_LOAD:
+		ret = dfx_cfg_drivers_load(id);
+		break;
+	case DFX_TRACE_OP_CFG_REMOVE:
+		ret = dfx_cfg_remove(id);
+		break;
+	case DFX_TRACE_OP_CFG_DESTROY:
+		ret = dfx_cfg_destroy(id);
+		break;
+	case DFX_TRACE_OP_GET_ACTIVE_UID_LIST:
+		if (buf == NULL)
+			ret = -1;
+		else if (r->flags)
+			ret = dfx_get_active_uid_list_buf(buf, r->flags);
+		else
+			ret = dfx_get_active_uid_list(buf);
+		break;
+	case DFX_TRACE_OP_GET_META_HEADER:
+		ret = buf ? dfx_get_meta_header((char *)s[0], buf, r->flags) : -1;
+		break;
+	default:
+		return;
+	}
+	c->replay_ns = now_ns() - t0;
+	c->replay_result = ret;
+	c->replayed = 1;
+	free(buf);
+	for (i = 0; i < 3; i++)
+		free(mem[i]);
+	/* The package keeps its own reference on the buffer */
+	if (buffd >= 0)
+		close(buffd);
+
+	if (is_init_op(r->op))
+		publish_id(c->slot, ret);
+}
+
+static void *replay_worker(void *arg)
+{
+	struct replay_thread *t = arg;
+	struct replay_call *c;
+	struct timespec ts;
+	unsigned long long due;
+	int i;
+
+	for (i = 0; i < t->count; i++) {
+		c = &calls[t->calls[i]];
+		if (speed > 0) {
+			due = replay_start_ns +
+			      (unsigned long long)((c->rec.start_ns -
+						    trace_start_ns) / speed);
+			ts.tv_sec = due / NSEC_PER_SEC;
+			ts.tv_nsec = due % NSEC_PER_SEC;
+			while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+					       &ts, NULL) == EINTR)
+				;
+		}
+		replay_one(c);
+	}
+
+	return NULL;
+}
+
+static struct replay_thread *thread_for(uint32_t tid)
+{
+	struct replay_thread *t;
+	int i;
+
+	for (i = 0; i < nthreads; i++) {
+		if (threads[i].tid == tid)
+			return &threads[i];
+	}
+
+	t = realloc(threads, (nthreads + 1) * sizeof(*threads));
+	if (t == NULL)
+		return NULL;
+	threads = t;
+	t = &threads[nthreads++];
+	memset(t, 0, sizeof(*t));
+	t->tid = tid;
+
+	return t;
+}
+
+static int add_call(int index)
+{
+	struct replay_thread *t = thread_for(calls[index].rec.tid);
+	int *n;
+
+	if (t == NULL)
+		return -1;
+	if (t->count == t->alloc) {
+		t->alloc = t->alloc ? t->alloc * 2 : 64;
+		n = realloc(t->calls, t->alloc * sizeof(int));
+		if (n == NULL)
+			return -1;
+		t->calls = n;
+	}
+	t->calls[t->count++] = index;
+
+	return 0;
+}
+
+/**
+ * load_trace() - read a trace file into the call table
+ *
+ * @path:	trace file
+ *
+ * Return:	0 on success, -1 on failure
+ */
+static int load_trace(const char *path)
+{
+	struct dfx_trace_file_header hdr;
+	struct dfx_trace_record rec;
+	struct replay_call *c;
+	char *payload, *s;
+	size_t len;
+	int alloc = 0, i, ret = -1;
+	FILE *fp;
+
+	fp = fopen(path, "rb");
+	if (fp == NULL) {
+		fprintf(stderr, "dfx_replay: cannot open `%s`: %s\n", path,
+			strerror(errno));
+		return -1;
+	}
+
+	if (fread(&hdr, sizeof(hdr), 1, fp) != 1 ||
+	    memcmp(hdr.magic, DFX_TRACE_MAGIC, sizeof(hdr.magic))) {
+		fprintf(stderr, "dfx_replay: `%s` is not a libdfx trace\n", path);
+		goto END;
+	}
+	if (hdr.byte_order != DFX_TRACE_BYTE_ORDER ||
+	    hdr.version != DFX_TRACE_VERSION) {
+		fprintf(stderr, "dfx_replay: unsupported trace version or byte order\n");
+		goto END;
+	}
+	trace_start_ns = hdr.start_ns;
+
+	while (fread(&rec, sizeof(rec), 1, fp) == 1) {
+		if (rec.size < sizeof(rec) || rec.nstr > DFX_TRACE_MAX_STRS) {
+			fprintf(stderr, "dfx_replay: corrupt record at %ld\n",
+				ftell(fp));
+			goto END;
+		}
+
+		len = rec.size - sizeof(rec);
+		payload = NULL;
+		if (len) {
+			payload = malloc(len);
+			if (payload == NULL || fread(payload, len, 1, fp) != 1) {
+				free(payload);
+				fprintf(stderr, "dfx_replay: truncated trace\n");
+				goto END;
+			}
+		}
+
+		if (rec.op == DFX_TRACE_OP_DROPPED) {
+			dropped += rec.result;
+			free(payload);
+			continue;
+		}
+		if (rec.op == DFX_TRACE_OP_PAD || rec.op >= DFX_TRACE_OP_MAX) {
+			free(payload);
+			continue;
+		}
+
+		if (ncalls == alloc) {
+			alloc = alloc ? alloc * 2 : 256;
+			c = realloc(calls, alloc * sizeof(*calls));
+			if (c == NULL) {
+				free(payload);
+				goto END;
+			}
+			calls = c;
+		}
+		c = &calls[ncalls];
+		memset(c, 0, sizeof(*c));
+		c->rec = rec;
+		for (i = 0, s = payload; i < rec.nstr; i++) {
+			if (s == NULL || s >= payload + len)
+				break;
+			c->strs[i] = (rec.null_mask & (1U << i)) ? NULL : s;
+			s += strnlen(s, payload + len - s) + 1;
+		}
+
+		if (is_init_op(rec.op) && rec.result > id_max)
+			id_max = rec.result;
+		ncalls++;
+	}
+
+	ret = 0;
+END:
+	fclose(fp);
+	return ret;
+}
+
+/* An init takes effect when it returns, other calls when they start */
+static unsigned long long call_time(const struct replay_call *c)
+{
+	if (is_init_op(c->rec.op))
+		return c->rec.start_ns + c->rec.duration_ns;
+
+	return c->rec.start_ns;
+}
+
+static int cmp_call_time(const void *a, const void *b)
+{
+	unsigned long long x = call_time(&calls[*(const int *)a]);
+	unsigned long long y = call_time(&calls[*(const int *)b]);
+
+	if (x != y)
+		return x < y ? -1 : 1;
+
+	return *(const int *)a - *(const int *)b;
+}
+
+/**
+ * prepare_ids() - assign the calls to their threads and id map slots
+ *
+ * Every init that returned a package id gets a slot. Walking the calls in
+ * recorded order, a package call takes the slot of the init that returned
+ * its id last; a destroy ends it, as the library may hand the id out again.
+ *
+ * Return:	0 on success, -1 on failure
+ */
+static int prepare_ids(void)
+{
+	int *order, *current, i, pkg, ret = -1;
+	struct replay_call *c;
+
+	order = malloc((ncalls + 1) * sizeof(*order));
+	current = malloc((id_max + 1) * sizeof(*current));
+	if (order == NULL || current == NULL)
+		goto END;
+
+	for (i = 0; i < ncalls; i++) {
+		order[i] = i;
+		calls[i].slot = -1;
+		if (add_call(i))
+			goto END;
+	}
+	for (i = 0; i <= id_max; i++)
+		current[i] = -1;
+	qsort(order, ncalls, sizeof(*order), cmp_call_time);
+
+	for (i = 0; i < ncalls; i++) {
+		c = &calls[order[i]];
+		pkg = is_init_op(c->rec.op) ? c->rec.result :
+		      c->rec.package_id;
+		if (pkg <= 0 || pkg > id_max)
+			continue;
+		if (is_init_op(c->rec.op)) {
+			c->slot = id_slots++;
+			current[pkg] = c->slot;
+			continue;
+		}
+		c->slot = current[pkg];
+		if (c->rec.op == DFX_TRACE_OP_CFG_DESTROY && c->rec.result == 0)
+			current[pkg] = -1;
+	}
+
+	id_state = calloc(id_slots + 1, sizeof(*id_state));
+	id_map = calloc(id_slots + 1, sizeof(*id_map));
+	if (id_state != NULL && id_map != NULL)
+		ret = 0;
+END:
+	free(order);
+	free(current);
+	return ret;
+}
+
+/* Highest fpgaN index named by the recorded devpaths, plus one */
+static int count_managers(void)
+{
+	const char *dev, *base;
+	int i, n, managers = 1;
+
+	for (i = 0; i < ncalls; i++) {
+		if (calls[i].rec.op == DFX_TRACE_OP_CFG_INIT)
+			dev = calls[i].strs[1];
+		else if (calls[i].rec.op == DFX_TRACE_OP_CFG_INIT_FILE)
+			dev = calls[i].strs[4];
+		else if (calls[i].rec.op == DFX_TRACE_OP_CFG_INIT_MEM)
+			dev = calls[i].strs[0];
+		else if (calls[i].rec.op == DFX_TRACE_OP_CFG_INIT_DMABUF)
+			dev = calls[i].strs[3];
+		else
+			continue;
+		if (dev == NULL)
+			continue;
+		base = strrchr(dev, '/');
+		base = base ? base + 1 : dev;
+		if (sscanf(base, "fpga%d", &n) == 1 && n >= managers &&
+		    n < REPLAY_MAX_MGRS)
+			managers = n + 1;
+	}
+
+	return managers;
+}
+
+static int cmp_ull(const void *a, const void *b)
+{
+	unsigned long long x = *(const unsigned long long *)a;
+	unsigned long long y = *(const unsigned long long *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static double pct_us(unsigned long long *v, int n, double p)
+{
+	int idx;
+
+	if (n == 0)
+		return 0;
+	idx = (int)(p / 100.0 * n + 0.999999) - 1;
+	if (idx < 0)
+		idx = 0;
+
+	return v[idx < n ? idx : n - 1] / 1000.0;
+}
+
+static void report(FILE *out, unsigned long long wall_ns)
+{
+	unsigned long long *orig, *repl;
+	int op, i, n, skipped, err_orig, err_repl;
+	double mo, mr;
+
+	orig = malloc((ncalls + 1) * sizeof(*orig));
+	repl = malloc((ncalls + 1) * sizeof(*repl));
+	if (orig == NULL || repl == NULL)
+		goto END;
+
+	fprintf(out, "dfx_replay: %d calls on %d threads, speed %g, %s backend,"
+		" %.3f s\n", ncalls, nthreads, speed,
+		fake_root ? "fake" : "device", wall_ns / 1e9);
+	if (dropped)
+		fprintf(out, "dfx_replay: warning: %d calls were dropped while"
+			" recording\n", dropped);
+	fprintf(out, "%-20s %6s %6s %6s %11s %11s %11s %11s %11s %11s %8s\n",
+		"call", "count", "skip", "errors", "rec_p50_us", "rep_p50_us",
+		"rec_p99_us", "rep_p99_us", "rec_mean", "rep_mean", "delta");
+
+	for (op = 1; op < DFX_TRACE_OP_MAX; op++) {
+		if (op_names[op] == NULL)
+			continue;
+
+		n = skipped = err_orig = err_repl = 0;
+		mo = mr = 0;
+		for (i = 0; i < ncalls; i++) {
+			if (calls[i].rec.op != op)
+				continue;
+			if (!calls[i].replayed) {
+				skipped++;
+				continue;
+			}
+			orig[n] = calls[i].rec.duration_ns;
+			repl[n] = calls[i].replay_ns;
+			mo += orig[n];
+			mr += repl[n];
+			err_orig += calls[i].rec.result < 0;
+			err_repl += calls[i].replay_result < 0;
+			n++;
+		}
+		if (n == 0 && skipped == 0)
+			continue;
+
+		qsort(orig, n, sizeof(*orig), cmp_ull);
+		qsort(repl, n, sizeof(*repl), cmp_ull);
+		mo = n ? mo / n / 1000.0 : 0;
+		mr = n ? mr / n / 1000.0 : 0;
+		fprintf(out, "%-20s %6d %6d %2d/%-3d %11.1f %11.1f %11.1f %11.1f"
+			" %11.1f %11.1f %+7.1f%%\n", op_names[op], n, skipped,
+			err_orig, err_repl, pct_us(orig, n, 50),
+			pct_us(repl, n, 50), pct_us(orig, n, 99),
+			pct_us(repl, n, 99), mo, mr,
+			mo > 0 ? (mr - mo) / mo * 100.0 : 0.0);
+	}
+
+END:
+	free(orig);
+	free(repl);
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"Usage: %s [options] TRACE\n"
+		"  -s, --speed X        time scale, 2 replays twice as fast,\n"
+		"                       0 issues calls back to back (default 1)\n"
+		"  -f, --fake           replay against a generated fake tree\n"
+		"  -r, --root DIR       build the fake tree in DIR and keep it\n"
+		"  -m, --map OLD=NEW    replace the path prefix OLD by NEW\n"
+		"  -z, --stub-size SIZE size of stub images in fake mode (default 1M)\n"
+		"  -v, --verbose        print the library messages to stderr\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+	static const struct option opts[] = {
+		{ "speed", required_argument, NULL, 's' },
+		{ "fake", no_argument, NULL, 'f' },
+		{ "root", required_argument, NULL, 'r' },
+		{ "map", required_argument, NULL, 'm' },
+		{ "stub-size", required_argument, NULL, 'z' },
+		{ "verbose", no_argument, NULL, 'v' },
+		{ "help", no_argument, NULL, 'h' },
+		{ NULL, 0, NULL, 0 },
+	};
+	char root[REPLAY_PATH_LEN] = "";
+	unsigned long long wall;
+	int fake = 0, keep = 0, verbose = 0, c, i;
+	char *eq, *end;
+
+	while ((c = getopt_long(argc, argv, "s:fr:m:z:vh", opts, NULL)) != -1) {
+		switch (c) {
+		case 's':
+			speed = strtod(optarg, &end);
+			if (*end != '\0' || speed < 0)
+				goto bad_arg;
+			break;
+		case 'f':
+			fake = 1;
+			break;
+		case 'r':
+			snprintf(root, sizeof(root), "%s", optarg);
+			fake = 1;
+			keep = 1;
+			break;
+		case 'm':
+			eq = strchr(optarg, '=');
+			if (eq == NULL || nmaps == REPLAY_MAX_MAPS)
+				goto bad_arg;
+			*eq = '\0';
+			maps[nmaps].from = optarg;
+			maps[nmaps].to = eq + 1;
+			nmaps++;
+			break;
+		case 'z':
+			stub_size = strtoull(optarg, &end, 0);
+			if (*end == 'K' || *end == 'k')
+				stub_size <<= 10, end++;
+			else if (*end == 'M' || *end == 'm')
+				stub_size <<= 20, end++;
+			if (*end != '\0' || stub_size == 0)
+				goto bad_arg;
+			break;
+		case 'v':
+			verbose = 1;
+			break;
+		case 'h':
+			usage(argv[0]);
+			return 0;
+		default:
+			goto bad_arg;
+		}
+	}
+	if (optind != argc - 1)
+		goto bad_arg;
+
+	if (load_trace(argv[optind]) || prepare_ids())
+		return 1;
+
+	if (fake) {
+		if (root[0] == '\0') {
+			snprintf(root, sizeof(root), "/tmp/dfx_replay.XXXXXX");
+			if (mkdtemp(root) == NULL) {
+				perror("dfx_replay: mkdtemp");
+				return 1;
+			}
+		} else if (mkdir(root, 0755) && errno != EEXIST) {
+			perror("dfx_replay: mkdir");
+			return 1;
+		}
+		if (dfx_fake_tree_build(root, count_managers()))
+			goto cleanup;
+		fake_root = root;
+	}
+
+	if (verbose)
+		dfx_set_log_sink(dfx_log_stderr_sink, NULL);
+
+	replay_start_ns = now_ns();
+	for (i = 0; i < nthreads; i++)
+		pthread_create(&threads[i].thread, NULL, replay_worker,
+			       &threads[i]);
+	for (i = 0; i < nthreads; i++)
+		pthread_join(threads[i].thread, NULL);
+	wall = now_ns() - replay_start_ns;
+
+	report(stdout, wall);
+
+cleanup:
+	if (fake && !keep)
+		dfx_fake_tree_remove(root);
+	return 0;
+
+bad_arg:
+	usage(argv[0]);
+	return 1;
+}
@@ -29,6 +29,9 @@ int main()
 {
 	int  package_id_full, package_id_pr0_rm0, package_id_pr0_rm1, ret;
 
+	/* Print the library messages on the console */
+	dfx_set_log_sink(dfx_log_stderr_sink, NULL);
+
 	/* package FULL Initilization */
     	package_id_full = dfx_cfg_init("/media/full/", 0, DFX_EXTERNAL_CONFIG_EN);
     	if (package_id_full < 0)
@@ -0,0 +1,191 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "dfx_bitstream.h"
+
+#if defined(__x86_64__)
+#include <tmmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/* Length-prefixed preamble of every .bit file, followed by the 'a' key */
+static const unsigned char bit_preamble[] = {
+	0x00, 0x09, 0x0f, 0xf0, 0x0f, 0xf0, 0x0f, 0xf0, 0x0f, 0xf0, 0x00,
+	0x00, 0x01,
+};
+
+/* The header only holds four short strings, anything longer is garbage */
+#define BIT_FIELD_MAX		1024U
+
+enum dfx_image_format dfx_image_format(const char *path)
+{
+	const char *ext = path ? strrchr(path, '.') : NULL;
+
+	if (ext == NULL)
+		return DFX_IMAGE_UNKNOWN;
+	if (!strcasecmp(ext, ".bit"))
+		return DFX_IMAGE_BIT;
+	if (!strcasecmp(ext, ".bin"))
+		return DFX_IMAGE_BIN;
+	if (!strcasecmp(ext, ".pdi"))
+		return DFX_IMAGE_PDI;
+
+	return DFX_IMAGE_UNKNOWN;
+}
+
+int dfx_bit_is_bit(const void *data, size_t len)
+{
+	return len >= sizeof(bit_preamble) &&
+	       !memcmp(data, bit_preamble, sizeof(bit_preamble));
+}
+
+static void copy_field(char *dst, size_t size, const char *src)
+{
+	size_t len = strlen(src);
+
+	if (len >= size)
+		len = size - 1;
+	memcpy(dst, src, len);
+	dst[len] = '\0';
+}
+
+/* Splits "<design>;UserID=0X...;Version=<tool version>" */
+static void parse_design_field(struct dfx_package_info *info, char *field)
+{
+	char *tok, *save = NULL;
+
+	tok = strtok_r(field, ";", &save);
+	if (tok == NULL)
+		return;
+	copy_field(info->design, sizeof(info->design), tok);
+
+	while ((tok = strtok_r(NULL, ";", &save)) != NULL) {
+		if (!strncasecmp(tok, "UserID=", 7))
+			info->user_id = (unsigned int)strtoul(tok + 7, NULL, 16);
+		else if (!strncasecmp(tok, "Version=", 8))
+			copy_field(info->tool_version,
+				   sizeof(info->tool_version), tok + 8);
+	}
+}
+
+int dfx_bit_parse_header(FILE *fp, struct dfx_package_info *info,
+			 unsigned long *data_len)
+{
+	unsigned char preamble[sizeof(bit_preamble)], raw[4];
+	char field[BIT_FIELD_MAX];
+	unsigned int len;
+	int key;
+
+	if (fread(preamble, 1, sizeof(preamble), fp) != sizeof(preamble) ||
+	    memcmp(preamble, bit_preamble, sizeof(preamble)))
+		return -1;
+
+	for (;;) {
+		key = fgetc(fp);
+		if (key == 'e') {
+			if (fread(raw, 1, 4, fp) != 4)
+				return -1;
+			*data_len = (unsigned long)raw[0] << 24 |
+				    (unsigned long)raw[1] << 16 |
+				    (unsigned long)raw[2] << 8 | raw[3];
+			info->header_size = (unsigned long long)ftell(fp);
+			return 0;
+		}
+		if (key < 'a' || key > 'd')
+			return -1;
+
+		if (fread(raw, 1, 2, fp) != 2)
+			return -1;
+		len = raw[0] << 8 | raw[1];
+		if (len == 0 || len > sizeof(field) ||
+		    fread(field, 1, len, fp) != len)
+			return -1;
+		field[len - 1] = '\0';
+
+		switch (key) {
+		case 'a':
+			parse_design_field(info, field);
+			break;
+		case 'b':
+			copy_field(info->part, sizeof(info->part), field);
+			break;
+		case 'c':
+			copy_field(info->date, sizeof(info->date), field);
+			break;
+		case 'd':
+			copy_field(info->time, sizeof(info->time), field);
+			break;
+		}
+	}
+}
+
+#if defined(__x86_64__)
+__attribute__((target("ssse3")))
+static size_t bswap32_ssse3(unsigned char *p, size_t len)
+{
+	const __m128i mask = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11,
+					  4, 5, 6, 7, 0, 1, 2, 3);
+	size_t off;
+
+	for (off = 0; off + 64 <= len; off += 64) {
+		__m128i a = _mm_loadu_si128((__m128i *)(p + off));
+		__m128i b = _mm_loadu_si128((__m128i *)(p + off + 16));
+		__m128i c = _mm_loadu_si128((__m128i *)(p + off + 32));
+		__m128i d = _mm_loadu_si128((__m128i *)(p + off + 48));
+
+		_mm_storeu_si128((__m128i *)(p + off), _mm_shuffle_epi8(a, mask));
+		_mm_storeu_si128((__m128i *)(p + off + 16), _mm_shuffle_epi8(b, mask));
+		_mm_storeu_si128((__m128i *)(p + off + 32), _mm_shuffle_epi8(c, mask));
+		_mm_storeu_si128((__m128i *)(p + off + 48), _mm_shuffle_epi8(d, mask));
+	}
+
+	return off;
+}
+#elif defined(__aarch64__)
+static size_t bswap32_neon(unsigned char *p, size_t len)
+{
+	uint8x16_t a, b, c, d;
+	size_t off;
+
+	for (off = 0; off + 64 <= len; off += 64) {
+		a = vld1q_u8(p + off);
+		b = vld1q_u8(p + off + 16);
+		c = vld1q_u8(p + off + 32);
+		d = vld1q_u8(p + off + 48);
+		vst1q_u8(p + off, vrev32q_u8(a));
+		vst1q_u8(p + off + 16, vrev32q_u8(b));
+		vst1q_u8(p + off + 32, vrev32q_u8(c));
+		vst1q_u8(p + off + 48, vrev32q_u8(d));
+	}
+
+	return off;
+}
+#endif
+
+void dfx_bswap32_buf(void *buf, size_t len)
+{
+	unsigned char *p = (unsigned char *)buf;
+	size_t off = 0;
+	uint32_t w;
+
+#if defined(__x86_64__)
+	if (__builtin_cpu_supports("ssse3"))
+		off = bswap32_ssse3(p, len);
+#elif defined(__aarch64__)
+	off = bswap32_neon(p, len);
+#endif
+
+	for (; off + 4 <= len; off += 4) {
+		memcpy(&w, p + off, 4);
+		w = __builtin_bswap32(w);
+		memcpy(p + off, &w, 4);
+	}
+}
@@ -0,0 +1,695 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "libdfx.h"
+#include "dfx_bitstream.h"
+#include "dfx_catalog.h"
+#include "dfx_log.h"
+#include "dfx_mgr.h"
+#include "dfx_pkg.h"
+
+#define CATALOG_MAGIC		"DFXCAT\0\0"
+#define CATALOG_VERSION		2U
+#define CATALOG_BYTE_ORDER	0x01020304U
+#define CATALOG_FILE_LEN	256U
+#define CATALOG_MIN_BITS	6U
+
+/* Record flag for root entries that are packages */
+#define CATALOG_PACKAGE		(0x80000000U)
+
+/* Modification time of records that have never been examined */
+#define CATALOG_UNSCANNED	(-1)
+
+/*
+ * One entry directly under the library root. Entries that are not packages
+ * are kept too, so that they are not examined again until they change.
+ * Records are written to the cache file as they are, the cache is only
+ * meant to be read back on the host that wrote it.
+ */
+struct catalog_record {
+	char file[CATALOG_FILE_LEN];		/* name under the root */
+	char name[DFX_CATALOG_NAME_LEN];	/* package name */
+	int64_t mtime_sec;
+	int64_t mtime_nsec;
+	uint64_t size;
+	uint32_t format;			/* enum dfx_image_format */
+	uint32_t flags;				/* DFX_CATALOG_*, CATALOG_PACKAGE */
+};
+
+struct catalog_file_header {
+	char magic[8];				/* CATALOG_MAGIC */
+	uint32_t byte_order;			/* CATALOG_BYTE_ORDER */
+	uint32_t version;			/* CATALOG_VERSION */
+	uint32_t record_size;
+	uint32_t count;
+	int64_t root_mtime_sec;
+	int64_t root_mtime_nsec;
+	uint32_t platform;			/* see dfx_mgr.h */
+	char root[DFX_CATALOG_PATH_LEN];
+};
+
+static pthread_mutex_t catalog_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct catalog_record *catalog;	/* sorted by file */
+static unsigned int catalog_count;
+static char catalog_root[DFX_CATALOG_PATH_LEN];
+static int64_t catalog_root_sec;
+static int64_t catalog_root_nsec = CATALOG_UNSCANNED;
+static int catalog_platform;
+static int *catalog_table;		/* by package name, record index + 1 */
+static unsigned int catalog_bits;
+
+static unsigned int name_hash(const char *name)
+{
+	unsigned int h = 2166136261U;
+
+	while (*name)
+		h = (h ^ (unsigned char)*name++) * 16777619U;
+
+	return h;
+}
+
+static int record_cmp(const void *a, const void *b)
+{
+	return strcmp(((const struct catalog_record *)a)->file,
+		      ((const struct catalog_record *)b)->file);
+}
+
+static int mtime_changed(const struct stat *st, int64_t sec, int64_t nsec)
+{
+	return st->st_mtim.tv_sec != sec || st->st_mtim.tv_nsec != nsec;
+}
+
+static void catalog_clear(void)
+{
+	free(catalog);
+	free(catalog_table);
+	catalog = NULL;
+	catalog_table = NULL;
+	catalog_count = 0;
+	catalog_bits = 0;
+	catalog_root[0] = '\0';
+	catalog_root_sec = 0;
+	catalog_root_nsec = CATALOG_UNSCANNED;
+}
+
+/* Names @rec after the first @len characters of @name, cut to fit */
+static void set_name(struct catalog_record *rec, const char *name, size_t len)
+{
+	if (len >= sizeof(rec->name))
+		len = sizeof(rec->name) - 1;
+	memcpy(rec->name, name, len);
+	rec->name[len] = '\0';
+}
+
+/*
+ * Classifies a package folder by the same file name rules as dfx_cfg_init()
+ * on a manager of @platform. As there, a folder without an image is a
+ * package.
+ */
+static void scan_folder(int root_fd, const char *root, int platform,
+			struct catalog_record *rec)
+{
+	int fd, images = 0, dtbos = 0, drivers = 0, keys = 0;
+	enum dfx_image_format format = DFX_IMAGE_UNKNOWN;
+	struct dirent *ent;
+	DIR *d;
+
+	fd = openat(root_fd, rec->file, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd < 0)
+		return;
+	d = fdopendir(fd);
+	if (d == NULL) {
+		close(fd);
+		return;
+	}
+
+	while ((ent = readdir(d)) != NULL) {
+		switch (dfx_pkg_file_type(ent->d_name, platform)) {
+		case DFX_PKG_ENTRY_IMAGE:
+			format = dfx_image_format(ent->d_name);
+			images++;
+			break;
+		case DFX_PKG_ENTRY_IMAGE_DTBO:
+			dtbos++;
+			break;
+		case DFX_PKG_ENTRY_DRIVERS_DTBO:
+			drivers++;
+			break;
+		case DFX_PKG_ENTRY_KEY_REF:
+			keys++;
+			break;
+		}
+	}
+	closedir(d);
+
+	if (images > 1 || dtbos != 1 || drivers > 1 || keys > 1) {
+		DFX_DBG("%s: `%s/%s` is not a package", __func__, root,
+			rec->file);
+		return;
+	}
+
+	set_name(rec, rec->file, strlen(rec->file));
+	rec->format = format;
+	rec->flags = CATALOG_PACKAGE;
+	if (drivers)
+		rec->flags |= DFX_CATALOG_DRIVERS_DTBO;
+	if (keys)
+		rec->flags |= DFX_CATALOG_AES_KEY;
+}
+
+/* Reads the name and entry types of a container, not its payloads */
+static void scan_container(int root_fd, const char *root,
+			   struct catalog_record *rec)
+{
+	char image[DFX_PKG_NAME_LEN];
+	int fd, types;
+
+	fd = openat(root_fd, rec->file, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return;
+	types = dfx_pkg_probe(fd, rec->name, image);
+	close(fd);
+
+	if (types < 0 || !(types & (1 << DFX_PKG_ENTRY_IMAGE_DTBO))) {
+		DFX_DBG("%s: `%s/%s` is not a package", __func__, root,
+			rec->file);
+		rec->name[0] = '\0';
+		return;
+	}
+
+	/* Unnamed containers are named after the file, as by dfx_cfg_init() */
+	if (rec->name[0] == '\0')
+		set_name(rec, rec->file,
+			 strlen(rec->file) - strlen(DFX_PKG_SUFFIX));
+
+	rec->format = dfx_image_format(image);
+	rec->flags = CATALOG_PACKAGE | DFX_CATALOG_CONTAINER;
+	if (types & (1 << DFX_PKG_ENTRY_DRIVERS_DTBO))
+		rec->flags |= DFX_CATALOG_DRIVERS_DTBO;
+	if (types & (1 << DFX_PKG_ENTRY_KEY_REF))
+		rec->flags |= DFX_CATALOG_AES_KEY;
+}
+
+static void scan_record(int root_fd, const char *root, int platform,
+			struct catalog_record *rec, const struct stat *st)
+{
+	rec->mtime_sec = st->st_mtim.tv_sec;
+	rec->mtime_nsec = st->st_mtim.tv_nsec;
+	rec->size = st->st_size;
+	rec->name[0] = '\0';
+	rec->format = DFX_IMAGE_UNKNOWN;
+	rec->flags = 0;
+
+	if (S_ISDIR(st->st_mode))
+		scan_folder(root_fd, root, platform, rec);
+	else if (S_ISREG(st->st_mode) && dfx_pkg_is_container(rec->file))
+		scan_container(root_fd, root, rec);
+}
+
+/*
+ * Reads the list of entries under @root into a new sorted array. Records
+ * of entries that are also in @old are copied from it, new entries are
+ * left to be examined.
+ */
+static int read_root(int root_fd, const char *root,
+		     const struct catalog_record *old, unsigned int old_count,
+		     struct catalog_record **out, unsigned int *out_count)
+{
+	const struct catalog_record *prev;
+	struct catalog_record *records, *tmp;
+	unsigned int count = 0, alloc = 64;
+	struct dirent *ent;
+	DIR *d;
+	int fd;
+
+	fd = dup(root_fd);
+	d = fd < 0 ? NULL : fdopendir(fd);
+	if (d == NULL) {
+		if (fd >= 0)
+			close(fd);
+		DFX_ERR("%s: Failed to read `%s`", __func__, root);
+		return -DFX_READ_PACKAGE_ERROR;
+	}
+	/* The duplicate shares the file offset of @root_fd */
+	rewinddir(d);
+
+	records = malloc(alloc * sizeof(*records));
+	while (records != NULL && (ent = readdir(d)) != NULL) {
+		if (ent->d_name[0] == '.' ||
+		    strlen(ent->d_name) >= CATALOG_FILE_LEN)
+			continue;
+		if (count == alloc) {
+			alloc *= 2;
+			tmp = realloc(records, alloc * sizeof(*records));
+			if (tmp == NULL) {
+				free(records);
+				records = NULL;
+				break;
+			}
+			records = tmp;
+		}
+
+		memset(&records[count], 0, sizeof(records[count]));
+		strcpy(records[count].file, ent->d_name);
+		prev = old_count == 0 ? NULL :
+		       bsearch(&records[count], old, old_count, sizeof(*old),
+			       record_cmp);
+		if (prev != NULL)
+			records[count] = *prev;
+		else
+			records[count].mtime_nsec = CATALOG_UNSCANNED;
+		count++;
+	}
+	closedir(d);
+
+	if (records == NULL) {
+		DFX_ERR("%s: Failed to allocate the catalog", __func__);
+		return -DFX_INSUFFICIENT_MEM;
+	}
+
+	qsort(records, count, sizeof(*records), record_cmp);
+	*out = records;
+	*out_count = count;
+
+	return 0;
+}
+
+static int build_table(void)
+{
+	unsigned int bits = CATALOG_MIN_BITS, mask, slot, i;
+
+	while ((1U << bits) < 2 * catalog_count)
+		bits++;
+
+	free(catalog_table);
+	catalog_table = calloc(1U << bits, sizeof(*catalog_table));
+	if (catalog_table == NULL) {
+		catalog_bits = 0;
+		DFX_ERR("%s: Failed to allocate the catalog", __func__);
+		return -DFX_INSUFFICIENT_MEM;
+	}
+	catalog_bits = bits;
+
+	mask = (1U << bits) - 1;
+	for (i = 0; i < catalog_count; i++) {
+		if (!(catalog[i].flags & CATALOG_PACKAGE))
+			continue;
+		slot = name_hash(catalog[i].name) & mask;
+		while (catalog_table[slot])
+			slot = (slot + 1) & mask;
+		catalog_table[slot] = i + 1;
+	}
+
+	return 0;
+}
+
+/* Returns the first package, in file name order, called @name */
+static const struct catalog_record *catalog_lookup(const char *name,
+						   enum dfx_image_format format)
+{
+	const struct catalog_record *rec, *found = NULL;
+	unsigned int mask, slot;
+
+	if (catalog_table == NULL)
+		return NULL;
+
+	mask = (1U << catalog_bits) - 1;
+	slot = name_hash(name) & mask;
+	for (; catalog_table[slot]; slot = (slot + 1) & mask) {
+		rec = &catalog[catalog_table[slot] - 1];
+		if (strcmp(rec->name, name) ||
+		    (format != DFX_IMAGE_UNKNOWN && rec->format != format))
+			continue;
+		if (found == NULL || rec < found)
+			found = rec;
+	}
+
+	return found;
+}
+
+static void fill_entry(const char *root, const struct catalog_record *rec,
+		       struct dfx_catalog_entry *entry)
+{
+	int len;
+
+	memcpy(entry->name, rec->name, sizeof(entry->name));
+	/* copy_root() leaves room for the longest file name under the root */
+	len = snprintf(entry->path, sizeof(entry->path), "%s/%s%s", root,
+		       rec->file, rec->flags & DFX_CATALOG_CONTAINER ? "" : "/");
+	if (len < 0 || (size_t)len >= sizeof(entry->path))
+		entry->path[0] = '\0';
+	entry->format = rec->format;
+	entry->flags = rec->flags & ~CATALOG_PACKAGE;
+}
+
+/*
+ * Loads the records of @catalog_root from @path, if it holds them and they
+ * were classified for @catalog_platform
+ */
+static void load_cache(const char *path)
+{
+	struct catalog_file_header hdr;
+	struct catalog_record *records;
+	unsigned int i;
+	FILE *fp;
+
+	fp = fopen(path, "rb");
+	if (fp == NULL)
+		return;
+
+	if (fread(&hdr, sizeof(hdr), 1, fp) != 1 ||
+	    memcmp(hdr.magic, CATALOG_MAGIC, sizeof(hdr.magic)) ||
+	    hdr.byte_order != CATALOG_BYTE_ORDER ||
+	    hdr.version != CATALOG_VERSION ||
+	    hdr.record_size != sizeof(*records) ||
+	    hdr.platform != (uint32_t)catalog_platform ||
+	    strncmp(hdr.root, catalog_root, sizeof(hdr.root))) {
+		DFX_DBG("%s: `%s` does not match, ignored", __func__, path);
+		fclose(fp);
+		return;
+	}
+
+	records = malloc((hdr.count ? hdr.count : 1) * sizeof(*records));
+	if (records == NULL ||
+	    fread(records, sizeof(*records), hdr.count, fp) != hdr.count) {
+		DFX_DBG("%s: `%s` is truncated, ignored", __func__, path);
+		free(records);
+		fclose(fp);
+		return;
+	}
+	fclose(fp);
+
+	for (i = 0; i < hdr.count; i++) {
+		records[i].file[sizeof(records[i].file) - 1] = '\0';
+		records[i].name[sizeof(records[i].name) - 1] = '\0';
+	}
+	qsort(records, hdr.count, sizeof(*records), record_cmp);
+
+	catalog = records;
+	catalog_count = hdr.count;
+	catalog_root_sec = hdr.root_mtime_sec;
+	catalog_root_nsec = hdr.root_mtime_nsec;
+}
+
+static void save_cache(const char *path)
+{
+	struct catalog_file_header hdr;
+	char tmp[DFX_CATALOG_PATH_LEN + 8];
+	FILE *fp;
+	int err;
+
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, CATALOG_MAGIC, sizeof(hdr.magic));
+	hdr.byte_order = CATALOG_BYTE_ORDER;
+	hdr.version = CATALOG_VERSION;
+	hdr.record_size = sizeof(*catalog);
+	hdr.count = catalog_count;
+	hdr.root_mtime_sec = catalog_root_sec;
+	hdr.root_mtime_nsec = catalog_root_nsec;
+	hdr.platform = catalog_platform;
+	memcpy(hdr.root, catalog_root, sizeof(hdr.root));
+
+	/* Replaced in one step, so a crash never leaves a torn cache */
+	snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+	fp = fopen(tmp, "wb");
+	if (fp == NULL) {
+		DFX_WARN("%s: Failed to create `%s`", __func__, tmp);
+		return;
+	}
+	err = fwrite(&hdr, sizeof(hdr), 1, fp) != 1 ||
+	      fwrite(catalog, sizeof(*catalog), catalog_count, fp) !=
+	      catalog_count;
+	err |= fclose(fp) != 0;
+	if (err || rename(tmp, path)) {
+		DFX_WARN("%s: Failed to write `%s`", __func__, path);
+		remove(tmp);
+	}
+}
+
+/* Copies @root without trailing slashes into @buf, DFX_CATALOG_PATH_LEN */
+static int copy_root(const char *root, char *buf)
+{
+	size_t len = strlen(root);
+
+	while (len > 1 && root[len - 1] == '/')
+		len--;
+	if (len + CATALOG_FILE_LEN + 2 > DFX_CATALOG_PATH_LEN) {
+		DFX_ERR("%s: `%s` is too long", __func__, root);
+		return -DFX_INVALID_PARAM;
+	}
+	memcpy(buf, root, len);
+	buf[len] = '\0';
+
+	return 0;
+}
+
+/* This API indexes the packages of a library root: the package folders and
+ * .dfxpkg containers directly under it. The index is kept in memory for
+ * dfx_catalog_find(), and in cache_file if it is not NULL.
+ *
+ * Later scans of the same root, in this process or from cache_file in the
+ * next one, only re-read the root if its modification time changed, and
+ * only re-examine the entries whose modification time (and size, for
+ * containers) changed.
+ *
+ * const char *root: Library root, Ex: /lib/firmware/xilinx
+ * const char *cache_file: Index file, outside of root, or NULL.
+ *
+ * Return: Number of packages in the catalog, or Error code on failure.
+ */
+int dfx_catalog_scan(const char *root, const char *cache_file)
+{
+	char path[DFX_CATALOG_PATH_LEN];
+	struct catalog_record *records;
+	unsigned int i, count;
+	struct stat st;
+	int fd = -1, changed = 0, platform, ret;
+
+	if (root == NULL || (cache_file != NULL &&
+			     strlen(cache_file) >= DFX_CATALOG_PATH_LEN)) {
+		DFX_ERR("%s: Invalid input args", __func__);
+		return -DFX_INVALID_PARAM;
+	}
+	ret = copy_root(root, path);
+	if (ret)
+		return ret;
+	platform = dfx_fpga_mgr_platform(NULL);
+
+	pthread_mutex_lock(&catalog_lock);
+	if (strcmp(catalog_root, path) || catalog_platform != platform) {
+		catalog_clear();
+		memcpy(catalog_root, path, sizeof(catalog_root));
+		catalog_platform = platform;
+		if (cache_file != NULL)
+			load_cache(cache_file);
+		changed = 1;
+	}
+
+	fd = open(catalog_root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd < 0 || fstat(fd, &st)) {
+		DFX_ERR("%s: Failed to open `%s`", __func__, catalog_root);
+		ret = -DFX_READ_PACKAGE_ERROR;
+		goto END;
+	}
+
+	if (mtime_changed(&st, catalog_root_sec, catalog_root_nsec)) {
+		ret = read_root(fd, catalog_root, catalog, catalog_count,
+				&records, &count);
+		if (ret)
+			goto END;
+		free(catalog);
+		catalog = records;
+		catalog_count = count;
+		catalog_root_sec = st.st_mtim.tv_sec;
+		catalog_root_nsec = st.st_mtim.tv_nsec;
+		changed = 1;
+	}
+
+	for (i = 0; i < catalog_count; i++) {
+		struct catalog_record *rec = &catalog[i];
+
+		if (fstatat(fd, rec->file, &st, 0)) {
+			/* Gone, the next read of the root drops it */
+			changed |= !!(rec->flags & CATALOG_PACKAGE);
+			rec->flags = 0;
+			rec->mtime_nsec = CATALOG_UNSCANNED;
+			continue;
+		}
+		if (!mtime_changed(&st, rec->mtime_sec, rec->mtime_nsec) &&
+		    (S_ISDIR(st.st_mode) || rec->size == (uint64_t)st.st_size))
+			continue;
+		scan_record(fd, catalog_root, catalog_platform, rec, &st);
+		changed = 1;
+	}
+
+	if (changed || catalog_table == NULL) {
+		ret = build_table();
+		if (ret)
+			goto END;
+	}
+	if (changed && cache_file != NULL)
+		save_cache(cache_file);
+
+	ret = 0;
+	for (i = 0; i < catalog_count; i++)
+		ret += !!(catalog[i].flags & CATALOG_PACKAGE);
+END:
+	if (fd >= 0)
+		close(fd);
+	pthread_mutex_unlock(&catalog_lock);
+
+	return ret;
+}
+
+/* This API looks up a package of the last scanned root by name.
+ *
+ * const char *name: Package folder name, or the name in a container header.
+ * enum dfx_image_format format: Image type to match, DFX_IMAGE_UNKNOWN
+ *				 matches any.
+ * struct dfx_catalog_entry *entry: User buffer address.
+ *
+ * Return: returns zero on success or Error code on failure,
+ *	   DFX_PACKAGE_NOT_FOUND_ERROR if there is no such package.
+ */
+int dfx_catalog_find(const char *name, enum dfx_image_format format,
+		     struct dfx_catalog_entry *entry)
+{
+	const struct catalog_record *rec;
+	int ret = 0;
+
+	if (name == NULL || entry == NULL) {
+		DFX_ERR("%s: Invalid input args", __func__);
+		return -DFX_INVALID_PARAM;
+	}
+
+	pthread_mutex_lock(&catalog_lock);
+	rec = catalog_lookup(name, format);
+	if (rec != NULL)
+		fill_entry(catalog_root, rec, entry);
+	else
+		ret = -DFX_PACKAGE_NOT_FOUND_ERROR;
+	pthread_mutex_unlock(&catalog_lock);
+
+	return ret;
+}
+
+/* This API copies the packages of the last scanned root, in file name
+ * order.
+ *
+ * struct dfx_catalog_entry *entries: User buffer address.
+ * int max_entries: Number of entries the buffer can hold.
+ *
+ * Return: Number of packages in the catalog, which may exceed max_entries,
+ *         or Negative value on failure.
+ */
+int dfx_catalog_list(struct dfx_catalog_entry *entries, int max_entries)
+{
+	unsigned int i;
+	int n = 0;
+
+	if (max_entries < 0 || (entries == NULL && max_entries > 0)) {
+		DFX_ERR("%s: Invalid input args", __func__);
+		return -DFX_INVALID_PARAM;
+	}
+
+	pthread_mutex_lock(&catalog_lock);
+	for (i = 0; i < catalog_count; i++) {
+		if (!(catalog[i].flags & CATALOG_PACKAGE))
+			continue;
+		if (n < max_entries)
+			fill_entry(catalog_root, &catalog[i], &entries[n]);
+		n++;
+	}
+	pthread_mutex_unlock(&catalog_lock);
+
+	return n;
+}
+
+int dfx_catalog_scan_list(const char *root, int platform,
+			  struct dfx_catalog_entry **entries)
+{
+	char path[DFX_CATALOG_PATH_LEN];
+	struct catalog_record *records = NULL;
+	unsigned int i, count = 0;
+	struct stat st;
+	int fd, n = 0, ret;
+
+	*entries = NULL;
+	ret = copy_root(root, path);
+	if (ret)
+		return ret;
+
+	fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd < 0) {
+		DFX_ERR("%s: Failed to open `%s`", __func__, path);
+		return -DFX_READ_PACKAGE_ERROR;
+	}
+	ret = read_root(fd, path, NULL, 0, &records, &count);
+	if (ret)
+		goto END;
+
+	for (i = 0; i < count; i++) {
+		if (fstatat(fd, records[i].file, &st, 0))
+			continue;
+		scan_record(fd, path, platform, &records[i], &st);
+		n += !!(records[i].flags & CATALOG_PACKAGE);
+	}
+
+	*entries = calloc(n ? n : 1, sizeof(**entries));
+	if (*entries == NULL) {
+		DFX_ERR("%s: Failed to allocate %d entries", __func__, n);
+		ret = -DFX_INSUFFICIENT_MEM;
+		goto END;
+	}
+	for (i = 0, n = 0; i < count; i++) {
+		if (records[i].flags & CATALOG_PACKAGE)
+			fill_entry(path, &records[i], &(*entries)[n++]);
+	}
+	ret = n;
+END:
+	free(records);
+	close(fd);
+	return ret;
+}
+
+/* This API initializes a package of the catalog, see dfx_catalog_find()
+ * and dfx_cfg_init().
+ *
+ * Return: returns unique package_Id, or Error code on failure.
+ */
+int dfx_catalog_init(const char *name, enum dfx_image_format format,
+		     const char *devpath, unsigned long flags)
+{
+	struct dfx_catalog_entry entry;
+	int ret;
+
+	ret = dfx_catalog_find(name, format, &entry);
+	if (ret) {
+		if (ret == -(int)DFX_PACKAGE_NOT_FOUND_ERROR)
+			DFX_ERR("%s: No package `%s` in the catalog", __func__,
+				name);
+		return ret;
+	}
+
+	return dfx_cfg_init(entry.path, devpath, flags, NULL);
+}
+
+/* This API releases the catalog. The cache file is left as it is. */
+void dfx_catalog_free(void)
+{
+	pthread_mutex_lock(&catalog_lock);
+	catalog_clear();
+	pthread_mutex_unlock(&catalog_lock);
+}
@@ -0,0 +1,383 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#include <pthread.h>
+#include <string.h>
+
+#include "dfx_bitstream.h"
+#include "dfx_digest.h"
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_acle.h>
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#ifndef HWCAP_SHA2
+#define HWCAP_SHA2		(1 << 6)
+#endif
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32		(1 << 7)
+#endif
+#endif
+
+/* Large enough to amortize the read() calls, small enough to stay in L2 */
+#define DIGEST_CHUNK		(256U * 1024U)
+
+#define CRC32C_POLY		0x82F63B78U
+
+#define ROR32(x, n)		(((x) >> (n)) | ((x) << (32 - (n))))
+
+typedef uint32_t (*crc32c_fn)(uint32_t crc, const unsigned char *p,
+			      size_t len);
+typedef void (*sha256_blocks_fn)(uint32_t *state, const unsigned char *p,
+				 size_t blocks);
+
+static pthread_once_t digest_once = PTHREAD_ONCE_INIT;
+static crc32c_fn crc32c_impl;
+static sha256_blocks_fn sha256_blocks_impl;
+static uint32_t crc32c_table[8][256];
+
+static const uint32_t sha256_k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+/* Slicing-by-8 fallback, used when the CPU has no CRC32C instruction */
+static uint32_t crc32c_sw(uint32_t crc, const unsigned char *p, size_t len)
+{
+	uint32_t lo, hi;
+
+	while (len && ((uintptr_t)p & 7)) {
+		crc = crc32c_table[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+		len--;
+	}
+
+	while (len >= 8) {
+		memcpy(&lo, p, 4);
+		memcpy(&hi, p + 4, 4);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+		lo = __builtin_bswap32(lo);
+		hi = __builtin_bswap32(hi);
+#endif
+		lo ^= crc;
+		crc = crc32c_table[7][lo & 0xFF] ^
+		      crc32c_table[6][(lo >> 8) & 0xFF] ^
+		      crc32c_table[5][(lo >> 16) & 0xFF] ^
+		      crc32c_table[4][lo >> 24] ^
+		      crc32c_table[3][hi & 0xFF] ^
+		      crc32c_table[2][(hi >> 8) & 0xFF] ^
+		      crc32c_table[1][(hi >> 16) & 0xFF] ^
+		      crc32c_table[0][hi >> 24];
+		p += 8;
+		len -= 8;
+	}
+
+	while (len--)
+		crc = crc32c_table[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+
+	return crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_sse42(uint32_t crc, const unsigned char *p, size_t len)
+{
+	uint64_t crc64, v;
+
+	while (len && ((uintptr_t)p & 7)) {
+		crc = _mm_crc32_u8(crc, *p++);
+		len--;
+	}
+
+	crc64 = crc;
+	while (len >= 8) {
+		memcpy(&v, p, 8);
+		crc64 = _mm_crc32_u64(crc64, v);
+		p += 8;
+		len -= 8;
+	}
+	crc = (uint32_t)crc64;
+
+	while (len--)
+		crc = _mm_crc32_u8(crc, *p++);
+
+	return crc;
+}
+#endif
+
+#if defined(__aarch64__)
+__attribute__((target("+crc")))
+static uint32_t crc32c_armv8(uint32_t crc, const unsigned char *p, size_t len)
+{
+	uint64_t v;
+
+	while (len && ((uintptr_t)p & 7)) {
+		crc = __crc32cb(crc, *p++);
+		len--;
+	}
+
+	while (len >= 8) {
+		memcpy(&v, p, 8);
+		crc = __crc32cd(crc, v);
+		p += 8;
+		len -= 8;
+	}
+
+	while (len--)
+		crc = __crc32cb(crc, *p++);
+
+	return crc;
+}
+
+/*
+ * SHA256H/SHA256H2 process four rounds per instruction pair, the message
+ * schedule for the next 16 words is produced by SHA256SU0/SHA256SU1.
+ */
+__attribute__((target("+crypto")))
+static void sha256_blocks_armv8(uint32_t *state, const unsigned char *p,
+				size_t blocks)
+{
+	uint32x4_t abcd, efgh, abcd_save, efgh_save, tmp, prev;
+	uint32x4_t msg[4];
+	int i;
+
+	abcd = vld1q_u32(&state[0]);
+	efgh = vld1q_u32(&state[4]);
+
+	while (blocks--) {
+		abcd_save = abcd;
+		efgh_save = efgh;
+
+		for (i = 0; i < 4; i++)
+			msg[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(p + 16 * i)));
+
+		for (i = 0; i < 16; i++) {
+			tmp = vaddq_u32(msg[i & 3], vld1q_u32(&sha256_k[4 * i]));
+			if (i < 12)
+				msg[i & 3] = vsha256su1q_u32(
+					vsha256su0q_u32(msg[i & 3],
+							msg[(i + 1) & 3]),
+					msg[(i + 2) & 3], msg[(i + 3) & 3]);
+			prev = abcd;
+			abcd = vsha256hq_u32(abcd, efgh, tmp);
+			efgh = vsha256h2q_u32(efgh, prev, tmp);
+		}
+
+		abcd = vaddq_u32(abcd, abcd_save);
+		efgh = vaddq_u32(efgh, efgh_save);
+		p += 64;
+	}
+
+	vst1q_u32(&state[0], abcd);
+	vst1q_u32(&state[4], efgh);
+}
+#endif
+
+static void sha256_blocks_sw(uint32_t *state, const unsigned char *p,
+			     size_t blocks)
+{
+	uint32_t w[64], s[8], t1, t2;
+	int i;
+
+	while (blocks--) {
+		for (i = 0; i < 16; i++)
+			w[i] = (uint32_t)p[4 * i] << 24 |
+			       (uint32_t)p[4 * i + 1] << 16 |
+			       (uint32_t)p[4 * i + 2] << 8 |
+			       (uint32_t)p[4 * i + 3];
+		for (i = 16; i < 64; i++)
+			w[i] = w[i - 16] + w[i - 7] +
+			       (ROR32(w[i - 15], 7) ^ ROR32(w[i - 15], 18) ^
+				(w[i - 15] >> 3)) +
+			       (ROR32(w[i - 2], 17) ^ ROR32(w[i - 2], 19) ^
+				(w[i - 2] >> 10));
+
+		memcpy(s, state, sizeof(s));
+		for (i = 0; i < 64; i++) {
+			t1 = s[7] + (ROR32(s[4], 6) ^ ROR32(s[4], 11) ^
+				     ROR32(s[4], 25)) +
+			     ((s[4] & s[5]) ^ (~s[4] & s[6])) +
+			     sha256_k[i] + w[i];
+			t2 = (ROR32(s[0], 2) ^ ROR32(s[0], 13) ^
+			      ROR32(s[0], 22)) +
+			     ((s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]));
+			memmove(&s[1], &s[0], 7 * sizeof(s[0]));
+			s[4] += t1;
+			s[0] = t1 + t2;
+		}
+
+		for (i = 0; i < 8; i++)
+			state[i] += s[i];
+		p += 64;
+	}
+}
+
+static void digest_setup(void)
+{
+	uint32_t crc;
+	int i, j;
+
+	for (i = 0; i < 256; i++) {
+		crc = i;
+		for (j = 0; j < 8; j++)
+			crc = (crc >> 1) ^ (CRC32C_POLY & -(crc & 1));
+		crc32c_table[0][i] = crc;
+	}
+	for (i = 0; i < 256; i++) {
+		crc = crc32c_table[0][i];
+		for (j = 1; j < 8; j++) {
+			crc = crc32c_table[0][crc & 0xFF] ^ (crc >> 8);
+			crc32c_table[j][i] = crc;
+		}
+	}
+
+	crc32c_impl = crc32c_sw;
+	sha256_blocks_impl = sha256_blocks_sw;
+#if defined(__x86_64__)
+	if (__builtin_cpu_supports("sse4.2"))
+		crc32c_impl = crc32c_sse42;
+#elif defined(__aarch64__)
+	if (getauxval(AT_HWCAP) & HWCAP_CRC32)
+		crc32c_impl = crc32c_armv8;
+	if (getauxval(AT_HWCAP) & HWCAP_SHA2)
+		sha256_blocks_impl = sha256_blocks_armv8;
+#endif
+}
+
+uint32_t dfx_crc32c(uint32_t crc, const void *buf, size_t len)
+{
+	pthread_once(&digest_once, digest_setup);
+
+	return ~crc32c_impl(~crc, (const unsigned char *)buf, len);
+}
+
+void dfx_sha256_init(struct dfx_sha256 *ctx)
+{
+	static const uint32_t iv[8] = {
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+		0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+	};
+
+	pthread_once(&digest_once, digest_setup);
+
+	memcpy(ctx->state, iv, sizeof(iv));
+	ctx->bytes = 0;
+	ctx->buf_len = 0;
+}
+
+void dfx_sha256_update(struct dfx_sha256 *ctx, const void *data, size_t len)
+{
+	const unsigned char *p = (const unsigned char *)data;
+	size_t n;
+
+	ctx->bytes += len;
+
+	if (ctx->buf_len) {
+		n = sizeof(ctx->buf) - ctx->buf_len;
+		if (n > len)
+			n = len;
+		memcpy(ctx->buf + ctx->buf_len, p, n);
+		ctx->buf_len += n;
+		p += n;
+		len -= n;
+		if (ctx->buf_len < sizeof(ctx->buf))
+			return;
+		sha256_blocks_impl(ctx->state, ctx->buf, 1);
+		ctx->buf_len = 0;
+	}
+
+	if (len >= 64) {
+		sha256_blocks_impl(ctx->state, p, len / 64);
+		p += len & ~(size_t)63;
+		len &= 63;
+	}
+
+	memcpy(ctx->buf, p, len);
+	ctx->buf_len = len;
+}
+
+void dfx_sha256_final(struct dfx_sha256 *ctx, unsigned char *digest)
+{
+	uint64_t bits = ctx->bytes * 8;
+	int i;
+
+	ctx->buf[ctx->buf_len++] = 0x80;
+	if (ctx->buf_len > 56) {
+		memset(ctx->buf + ctx->buf_len, 0, 64 - ctx->buf_len);
+		sha256_blocks_impl(ctx->state, ctx->buf, 1);
+		ctx->buf_len = 0;
+	}
+	memset(ctx->buf + ctx->buf_len, 0, 56 - ctx->buf_len);
+	for (i = 0; i < 8; i++)
+		ctx->buf[56 + i] = (unsigned char)(bits >> (56 - 8 * i));
+	sha256_blocks_impl(ctx->state, ctx->buf, 1);
+
+	for (i = 0; i < 8; i++) {
+		digest[4 * i] = (unsigned char)(ctx->state[i] >> 24);
+		digest[4 * i + 1] = (unsigned char)(ctx->state[i] >> 16);
+		digest[4 * i + 2] = (unsigned char)(ctx->state[i] >> 8);
+		digest[4 * i + 3] = (unsigned char)ctx->state[i];
+	}
+}
+
+size_t dfx_digest_read(FILE *fp, void *dst, size_t len, int bswap32,
+		       uint32_t *crc, struct dfx_sha256 *sha)
+{
+	unsigned char *p = (unsigned char *)dst;
+	size_t total = 0, want, got;
+
+	while (total < len) {
+		want = len - total < DIGEST_CHUNK ? len - total : DIGEST_CHUNK;
+		got = fread(p + total, 1, want, fp);
+		if (got == 0)
+			break;
+
+		if (bswap32)
+			dfx_bswap32_buf(p + total, got);
+		*crc = dfx_crc32c(*crc, p + total, got);
+		if (sha != NULL)
+			dfx_sha256_update(sha, p + total, got);
+		total += got;
+		if (got < want)
+			break;
+	}
+
+	return total;
+}
+
+void dfx_digest_copy(void *dst, const void *src, size_t len, int bswap32,
+		     uint32_t *crc, uint32_t *raw_crc, struct dfx_sha256 *sha)
+{
+	unsigned char *p = (unsigned char *)dst;
+	const unsigned char *s = (const unsigned char *)src;
+	size_t off, n;
+
+	for (off = 0; off < len; off += n) {
+		n = len - off < DIGEST_CHUNK ? len - off : DIGEST_CHUNK;
+		memcpy(p + off, s + off, n);
+		if (raw_crc != NULL)
+			*raw_crc = dfx_crc32c(*raw_crc, p + off, n);
+		if (bswap32)
+			dfx_bswap32_buf(p + off, n);
+		*crc = dfx_crc32c(*crc, p + off, n);
+		if (sha != NULL)
+			dfx_sha256_update(sha, p + off, n);
+	}
+}
@@ -0,0 +1,389 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "dfx_ktrace.h"
+#include "dfx_log.h"
+#include "dfx_stats.h"
+
+#define TRACEFS_DEFAULT_ROOT	"/sys/kernel/tracing"
+#define KTRACE_GROUP		"libdfx"
+#define KTRACE_INSTANCE		"instances/libdfx"
+#define KTRACE_BUFFER_KB	"256"
+#define KTRACE_PATH_LEN		512U
+#define KTRACE_LINE_LEN		512U
+
+/*
+ * Mainline kernels carry no tracepoints in the FPGA manager or overlay
+ * code, so the kernel phases are bracketed with kprobe/kretprobe events on
+ * the functions that implement them. fpga_mgr_load() runs nested inside
+ * of_overlay_fdt_apply(), so the overlay phase includes the manager write.
+ */
+struct ktrace_event {
+	const char *name;
+	const char *symbol;
+	int kphase;
+	int is_return;
+};
+
+static const struct ktrace_event ktrace_events[] = {
+	{ "fw_request_enter", "_request_firmware", DFX_KPHASE_FIRMWARE, 0 },
+	{ "fw_request_exit", "_request_firmware", DFX_KPHASE_FIRMWARE, 1 },
+	{ "mgr_load_enter", "fpga_mgr_load", DFX_KPHASE_FPGA_MGR_LOAD, 0 },
+	{ "mgr_load_exit", "fpga_mgr_load", DFX_KPHASE_FPGA_MGR_LOAD, 1 },
+	{ "overlay_apply_enter", "of_overlay_fdt_apply",
+	  DFX_KPHASE_OVERLAY_APPLY, 0 },
+	{ "overlay_apply_exit", "of_overlay_fdt_apply",
+	  DFX_KPHASE_OVERLAY_APPLY, 1 },
+};
+
+#define KTRACE_NUM_EVENTS	(sizeof(ktrace_events) / sizeof(ktrace_events[0]))
+
+static pthread_mutex_t ktrace_lock = PTHREAD_MUTEX_INITIALIZER;
+static char ktrace_root[KTRACE_PATH_LEN];
+static char ktrace_dir[KTRACE_PATH_LEN];
+static int ktrace_enabled;
+static int ktrace_instance;
+static int ktrace_active;
+
+/**
+ * ktrace_path() - join a tracefs directory and a file name
+ *
+ * @path:	receives the path, KTRACE_PATH_LEN bytes
+ * @dir:	tracefs directory
+ * @file:	name relative to @dir
+ *
+ * Return:	0 on success
+ *		-1 if the path does not fit
+ */
+static int ktrace_path(char *path, const char *dir, const char *file)
+{
+	int len;
+
+	len = snprintf(path, KTRACE_PATH_LEN, "%s/%s", dir, file);
+	if (len < 0 || len >= (int)KTRACE_PATH_LEN) {
+		DFX_ERR("%s: `%s/%s` is too long", __func__, dir, file);
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * ktrace_write() - write a string to a tracefs file
+ *
+ * @dir:	tracefs directory holding the file
+ * @file:	file name relative to @dir
+ * @src:	null-terminated string to write
+ * @flags:	extra open(2) flags (O_APPEND, O_TRUNC)
+ *
+ * Return:	0 on success
+ *		-1 on failure
+ */
+static int ktrace_write(const char *dir, const char *file, const char *src,
+			int flags)
+{
+	char path[KTRACE_PATH_LEN];
+	ssize_t len = strlen(src);
+	int fd, ret = 0;
+
+	if (ktrace_path(path, dir, file))
+		return -1;
+	fd = open(path, O_WRONLY | flags);
+	if (fd < 0) {
+		DFX_ERR("%s: Failed to open `%s` for writing", __func__, path);
+		return -1;
+	}
+
+	if (len && write(fd, src, len) != len) {
+		DFX_ERR("%s: Failed to write `%s` to `%s`", __func__, src, path);
+		ret = -1;
+	}
+
+	close(fd);
+	return ret;
+}
+
+static void ktrace_remove_kprobes(void)
+{
+	char line[KTRACE_LINE_LEN];
+	size_t i;
+
+	for (i = 0; i < KTRACE_NUM_EVENTS; i++) {
+		snprintf(line, sizeof(line), "-:%s/%s\n", KTRACE_GROUP,
+			 ktrace_events[i].name);
+		ktrace_write(ktrace_root, "kprobe_events", line, O_APPEND);
+	}
+}
+
+static int ktrace_set_events(const char *enable)
+{
+	if (ktrace_write(ktrace_dir, "events/" KTRACE_GROUP "/enable",
+			 enable, 0))
+		return -1;
+
+	return ktrace_write(ktrace_dir, "tracing_on", enable, 0);
+}
+
+/**
+ * dfx_ktrace_enable() - enable the kernel trace diagnostic mode
+ *
+ * @tracefs_root:	tracefs mount point, NULL for /sys/kernel/tracing
+ *
+ * Registers kprobe events on the firmware loader, the FPGA manager write
+ * and the overlay apply path, and sets up a private trace instance using
+ * the monotonic trace clock. While enabled, every dfx_cfg_load() turns the
+ * events on for its duration and attaches the kernel-side phase durations
+ * to its load record (see dfx_get_stats()).
+ *
+ * Return:	0 on success
+ *		-DFX_KTRACE_ERROR on failure
+ */
+int dfx_ktrace_enable(const char *tracefs_root)
+{
+	char line[KTRACE_LINE_LEN];
+	struct stat st;
+	size_t i;
+	int ret = 0;
+
+	if (tracefs_root == NULL)
+		tracefs_root = TRACEFS_DEFAULT_ROOT;
+
+	pthread_mutex_lock(&ktrace_lock);
+	if (ktrace_enabled)
+		goto END;
+
+	if (strlen(tracefs_root) + sizeof(KTRACE_INSTANCE) + 1 >
+	    sizeof(ktrace_root)) {
+		DFX_ERR("%s: tracefs path `%s` is too long", __func__,
+		        tracefs_root);
+		ret = -DFX_KTRACE_ERROR;
+		goto END;
+	}
+	strcpy(ktrace_root, tracefs_root);
+
+	/* Drop stale definitions left behind by a previous process */
+	ktrace_remove_kprobes();
+	for (i = 0; i < KTRACE_NUM_EVENTS; i++) {
+		snprintf(line, sizeof(line), "%c:%s/%s %s\n",
+			 ktrace_events[i].is_return ? 'r' : 'p', KTRACE_GROUP,
+			 ktrace_events[i].name, ktrace_events[i].symbol);
+		if (ktrace_write(ktrace_root, "kprobe_events", line,
+				 O_APPEND)) {
+			ret = -DFX_KTRACE_ERROR;
+			goto remove_kprobes;
+		}
+	}
+
+	/* Use a private ring buffer when the kernel supports instances */
+	ktrace_instance = 0;
+	if (ktrace_path(ktrace_dir, ktrace_root, "instances")) {
+		ret = -DFX_KTRACE_ERROR;
+		goto remove_kprobes;
+	}
+	if (stat(ktrace_dir, &st) == 0 && S_ISDIR(st.st_mode)) {
+		if (ktrace_path(ktrace_dir, ktrace_root, KTRACE_INSTANCE)) {
+			ret = -DFX_KTRACE_ERROR;
+			goto remove_kprobes;
+		}
+		if (mkdir(ktrace_dir, 0755) && errno != EEXIST) {
+			DFX_ERR("%s: Failed to create trace instance `%s`",
+			        __func__, ktrace_dir);
+			ret = -DFX_KTRACE_ERROR;
+			goto remove_kprobes;
+		}
+		ktrace_instance = 1;
+	} else {
+		strcpy(ktrace_dir, ktrace_root);
+	}
+
+	/* Timestamps must be comparable with CLOCK_MONOTONIC */
+	if (ktrace_write(ktrace_dir, "trace_clock", "mono", 0)) {
+		ret = -DFX_KTRACE_ERROR;
+		goto remove_instance;
+	}
+	if (ktrace_instance)
+		ktrace_write(ktrace_dir, "buffer_size_kb", KTRACE_BUFFER_KB, 0);
+
+	ktrace_active = 0;
+	ktrace_enabled = 1;
+	goto END;
+
+remove_instance:
+	if (ktrace_instance)
+		rmdir(ktrace_dir);
+remove_kprobes:
+	ktrace_remove_kprobes();
+END:
+	pthread_mutex_unlock(&ktrace_lock);
+	return ret;
+}
+
+/**
+ * dfx_ktrace_disable() - disable the kernel trace diagnostic mode
+ *
+ * Turns the events off and removes the kprobe events and trace instance
+ * created by dfx_ktrace_enable().
+ *
+ * Return:	0 on success
+ */
+int dfx_ktrace_disable(void)
+{
+	pthread_mutex_lock(&ktrace_lock);
+	if (ktrace_enabled) {
+		ktrace_set_events("0");
+		if (ktrace_instance)
+			rmdir(ktrace_dir);
+		ktrace_remove_kprobes();
+		ktrace_enabled = 0;
+	}
+	pthread_mutex_unlock(&ktrace_lock);
+
+	return 0;
+}
+
+int dfx_ktrace_begin(void)
+{
+	int ret = 0;
+
+	pthread_mutex_lock(&ktrace_lock);
+	if (!ktrace_enabled)
+		goto END;
+
+	/* The first load in flight starts from an empty ring buffer */
+	if (ktrace_active == 0) {
+		ktrace_write(ktrace_dir, "trace", "", O_TRUNC);
+		if (ktrace_set_events("1"))
+			goto END;
+	}
+	ktrace_active++;
+	ret = 1;
+END:
+	pthread_mutex_unlock(&ktrace_lock);
+	return ret;
+}
+
+/**
+ * ktrace_parse_line() - split a line of the tracefs `trace` file
+ *
+ * @line:	one line of trace output, e.g.
+ *		"  dfx_app-1234  [001] .....  5123.000100: mgr_load_enter: (...)"
+ * @pid:	pid of the task that hit the event
+ * @ts:		event timestamp in nanoseconds
+ *
+ * Return:	index of the event in ktrace_events on success
+ *		-1 if the line does not hold one of our events
+ */
+static int ktrace_parse_line(const char *line, long *pid,
+			     unsigned long long *ts)
+{
+	char needle[64];
+	const char *ev = NULL, *p, *end;
+	unsigned long long sec = 0, frac = 0, scale = 1000000000ULL;
+	size_t i;
+
+	for (i = 0; i < KTRACE_NUM_EVENTS; i++) {
+		snprintf(needle, sizeof(needle), " %s:", ktrace_events[i].name);
+		ev = strstr(line, needle);
+		if (ev != NULL)
+			break;
+	}
+	if (ev == NULL)
+		return -1;
+
+	/* Timestamp "<sec>.<frac>:" just before the event name */
+	p = ev;
+	if (p <= line || p[-1] != ':')
+		return -1;
+	end = --p;
+	while (p > line && (isdigit((unsigned char)p[-1]) || p[-1] == '.'))
+		p--;
+	if (p == end)
+		return -1;
+	for (; *p != '.' && p < end; p++)
+		sec = sec * 10 + (*p - '0');
+	if (*p == '.') {
+		for (p++; p < end && scale > 1; p++) {
+			frac = frac * 10 + (*p - '0');
+			scale /= 10;
+		}
+	}
+	*ts = sec * 1000000000ULL + frac * scale;
+
+	/* "<task>-<pid>" right before the "[cpu]" field */
+	p = end;
+	while (p > line && *p != '[')
+		p--;
+	while (p > line && p[-1] == ' ')
+		p--;
+	end = p;
+	while (p > line && isdigit((unsigned char)p[-1]))
+		p--;
+	if (p == end || p == line || p[-1] != '-')
+		return -1;
+	*pid = strtol(p, NULL, 10);
+
+	return (int)i;
+}
+
+void dfx_ktrace_end(struct dfx_load_record *rec, unsigned long long start)
+{
+	unsigned long long enter_ts[DFX_KPHASE_MAX] = { 0 };
+	unsigned long long end = dfx_stats_now(), ts;
+	char path[KTRACE_PATH_LEN];
+	char line[KTRACE_LINE_LEN];
+	long tid = syscall(SYS_gettid), pid;
+	const struct ktrace_event *ev;
+	FILE *fp;
+	int idx;
+
+	pthread_mutex_lock(&ktrace_lock);
+	if (!ktrace_enabled || ktrace_active == 0)
+		goto END;
+
+	if (ktrace_path(path, ktrace_dir, "trace"))
+		goto DISABLE;
+	fp = fopen(path, "r");
+	if (fp == NULL) {
+		DFX_ERR("%s: Failed to open `%s` for reading", __func__, path);
+		goto DISABLE;
+	}
+
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (line[0] == '#')
+			continue;
+
+		idx = ktrace_parse_line(line, &pid, &ts);
+		if (idx < 0 || pid != tid || ts < start || ts > end)
+			continue;
+
+		ev = &ktrace_events[idx];
+		if (!ev->is_return) {
+			enter_ts[ev->kphase] = ts;
+		} else if (enter_ts[ev->kphase]) {
+			rec->kphase_ns[ev->kphase] += ts - enter_ts[ev->kphase];
+			rec->kphase_mask |= 1U << ev->kphase;
+			enter_ts[ev->kphase] = 0;
+		}
+	}
+	fclose(fp);
+
+DISABLE:
+	if (--ktrace_active == 0)
+		ktrace_set_events("0");
+END:
+	pthread_mutex_unlock(&ktrace_lock);
+}
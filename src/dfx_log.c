@@ -0,0 +1,92 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "dfx_log.h"
+
+#define DFX_LOG_MSG_LEN		512U
+
+/*
+ * No sink is installed by default: messages are dropped before they are
+ * formatted, so the library never blocks on a console or a pipe unless the
+ * application asks for it.
+ */
+int dfx_log_threshold = -1;
+
+static int log_level = DFX_LOG_INFO;
+static dfx_log_sink_t log_sink;
+static void *log_arg;
+
+static void log_update_threshold(void)
+{
+	int threshold = -1;
+
+	if (__atomic_load_n(&log_sink, __ATOMIC_ACQUIRE) != NULL)
+		threshold = __atomic_load_n(&log_level, __ATOMIC_RELAXED);
+
+	__atomic_store_n(&dfx_log_threshold, threshold, __ATOMIC_RELEASE);
+}
+
+void dfx_log(enum dfx_log_level level, const char *fmt, ...)
+{
+	dfx_log_sink_t sink = __atomic_load_n(&log_sink, __ATOMIC_ACQUIRE);
+	char msg[DFX_LOG_MSG_LEN];
+	va_list ap;
+	size_t len;
+
+	if (sink == NULL)
+		return;
+
+	va_start(ap, fmt);
+	vsnprintf(msg, sizeof(msg), fmt, ap);
+	va_end(ap);
+
+	len = strlen(msg);
+	while (len && (msg[len - 1] == '\n' || msg[len - 1] == '\r'))
+		msg[--len] = '\0';
+
+	sink(level, msg, log_arg);
+}
+
+/* This API installs the function which receives the library messages.
+ *
+ * dfx_log_sink_t sink: Called from the thread that logs, once per message,
+ *			or NULL to drop all messages (the default).
+ * void *arg: Passed to every sink call.
+ *
+ * The sink must not call back into the library. It should be installed
+ * before the library is used from several threads.
+ */
+void dfx_set_log_sink(dfx_log_sink_t sink, void *arg)
+{
+	log_arg = arg;
+	__atomic_store_n(&log_sink, sink, __ATOMIC_RELEASE);
+	log_update_threshold();
+}
+
+/* This API sets the most verbose level passed to the sink, DFX_LOG_INFO by
+ * default. Levels compiled out with LIBDFX_LOG_LEVEL are never reported.
+ *
+ * enum dfx_log_level level: DFX_LOG_ERROR to DFX_LOG_DEBUG.
+ */
+void dfx_set_log_level(enum dfx_log_level level)
+{
+	__atomic_store_n(&log_level, (int)level, __ATOMIC_RELAXED);
+	log_update_threshold();
+}
+
+/* This API is a ready-made sink which writes every message to stderr.
+ * It may block, it is meant for command line tools and debugging.
+ */
+void dfx_log_stderr_sink(enum dfx_log_level level, const char *msg, void *arg)
+{
+	(void)level;
+	(void)arg;
+
+	fprintf(stderr, "%s\n", msg);
+}
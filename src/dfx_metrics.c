@@ -0,0 +1,442 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "libdfx.h"
+#include "dfx_log.h"
+#include "dfx_stats.h"
+
+#define METRICS_PATH_LEN	512U
+#define METRICS_INITIAL_BUF	16384U
+#define METRICS_MIN_INTERVAL_MS	100U
+#define NSEC_PER_SEC		1000000000ULL
+#define NSEC_PER_MSEC		1000000ULL
+
+/* Label values of the failure counters, indexed by error code */
+static const char *const dfx_err_names[DFX_STATS_ERR_CODES] = {
+	[0] = "unknown",
+	[DFX_INVALID_PLATFORM_ERROR] = "DFX_INVALID_PLATFORM_ERROR",
+	[DFX_CREATE_PACKAGE_ERROR] = "DFX_CREATE_PACKAGE_ERROR",
+	[DFX_DUPLICATE_FIRMWARE_ERROR] = "DFX_DUPLICATE_FIRMWARE_ERROR",
+	[DFX_DUPLICATE_DTBO_ERROR] = "DFX_DUPLICATE_DTBO_ERROR",
+	[DFX_READ_PACKAGE_ERROR] = "DFX_READ_PACKAGE_ERROR",
+	[DFX_AESKEY_READ_ERROR] = "DFX_AESKEY_READ_ERROR",
+	[DFX_DMABUF_ALLOC_ERROR] = "DFX_DMABUF_ALLOC_ERROR",
+	[DFX_INVALID_PACKAGE_ID_ERROR] = "DFX_INVALID_PACKAGE_ID_ERROR",
+	[DFX_GET_PACKAGE_ERROR] = "DFX_GET_PACKAGE_ERROR",
+	[DFX_FAIL_TO_OPEN_DEV_NODE] = "DFX_FAIL_TO_OPEN_DEV_NODE",
+	[DFX_IMAGE_CONFIG_ERROR] = "DFX_IMAGE_CONFIG_ERROR",
+	[DFX_DRIVER_CONFIG_ERROR] = "DFX_DRIVER_CONFIG_ERROR",
+	[DFX_NO_VALID_DRIVER_DTO_FILE] = "DFX_NO_VALID_DRIVER_DTO_FILE",
+	[DFX_DESTROY_PACKAGE_ERROR] = "DFX_DESTROY_PACKAGE_ERROR",
+	[DFX_FAIL_TO_OPEN_BIN_FILE] = "DFX_FAIL_TO_OPEN_BIN_FILE",
+	[DFX_INSUFFICIENT_MEM] = "DFX_INSUFFICIENT_MEM",
+	[DFX_INVALID_PARAM] = "DFX_INVALID_PARAM",
+	[DFX_DUPLICATE_DRIVERS_DTBO_ERROR] = "DFX_DUPLICATE_DRIVERS_DTBO_ERROR",
+	[DFX_DUPLICATE_AES_KEY_ERROR] = "DFX_DUPLICATE_AES_KEY_ERROR",
+	[DFX_KTRACE_ERROR] = "DFX_KTRACE_ERROR",
+	[DFX_TRACE_ERROR] = "DFX_TRACE_ERROR",
+	[DFX_IMAGE_DIGEST_ERROR] = "DFX_IMAGE_DIGEST_ERROR",
+	[DFX_PDI_FORMAT_ERROR] = "DFX_PDI_FORMAT_ERROR",
+	[DFX_UID_NOT_FOUND_ERROR] = "DFX_UID_NOT_FOUND_ERROR",
+	[DFX_UID_PARENT_ERROR] = "DFX_UID_PARENT_ERROR",
+	[DFX_PACKAGE_NOT_FOUND_ERROR] = "DFX_PACKAGE_NOT_FOUND_ERROR",
+	[DFX_LOAD_DEADLINE_ERROR] = "DFX_LOAD_DEADLINE_ERROR",
+};
+
+static const char *const fw_err_names[DFX_STATS_ERR_CODES] = {
+	[0] = "unknown",
+	[XFPGA_ERROR_CSUDMA_INIT_FAIL] = "XFPGA_ERROR_CSUDMA_INIT_FAIL",
+	[XFPGA_ERROR_PL_POWER_UP] = "XFPGA_ERROR_PL_POWER_UP",
+	[XFPGA_ERROR_PL_ISOLATION] = "XFPGA_ERROR_PL_ISOLATION",
+	[XPFGA_ERROR_PCAP_INIT] = "XPFGA_ERROR_PCAP_INIT",
+	[XFPGA_ERROR_BITSTREAM_LOAD_FAIL] = "XFPGA_ERROR_BITSTREAM_LOAD_FAIL",
+	[XFPGA_ERROR_CRYPTO_FLAGS] = "XFPGA_ERROR_CRYPTO_FLAGS",
+	[XFPGA_ERROR_HDR_AUTH] = "XFPGA_ERROR_HDR_AUTH",
+	[XFPGA_ENC_ISCOMPULSORY] = "XFPGA_ENC_ISCOMPULSORY",
+	[XFPGA_PARTITION_AUTH_FAILURE] = "XFPGA_PARTITION_AUTH_FAILURE",
+	[XFPGA_STRING_INVALID_ERROR] = "XFPGA_STRING_INVALID_ERROR",
+	[XFPGA_ERROR_SECURE_CRYPTO_FLAGS] = "XFPGA_ERROR_SECURE_CRYPTO_FLAGS",
+	[XFPGA_ERROR_SECURE_MODE_EN] = "XFPGA_ERROR_SECURE_MODE_EN",
+	[XFPGA_HDR_NOAUTH_PART_AUTH] = "XFPGA_HDR_NOAUTH_PART_AUTH",
+	[XFPGA_DEC_WRONG_KEY_SOURCE] = "XFPGA_DEC_WRONG_KEY_SOURCE",
+	[XFPGA_ERROR_DDR_AUTH_VERIFY_SPK] = "XFPGA_ERROR_DDR_AUTH_VERIFY_SPK",
+	[XFPGA_ERROR_DDR_AUTH_PARTITION] = "XFPGA_ERROR_DDR_AUTH_PARTITION",
+	[XFPGA_ERROR_DDR_AUTH_WRITE_PL] = "XFPGA_ERROR_DDR_AUTH_WRITE_PL",
+	[XFPGA_ERROR_OCM_AUTH_VERIFY_SPK] = "XFPGA_ERROR_OCM_AUTH_VERIFY_SPK",
+	[XFPGA_ERROR_OCM_AUTH_PARTITION] = "XFPGA_ERROR_OCM_AUTH_PARTITION",
+	[XFPGA_ERROR_OCM_REAUTH_WRITE_PL] = "XFPGA_ERROR_OCM_REAUTH_WRITE_PL",
+	[XFPGA_ERROR_PCAP_PL_DONE] = "XFPGA_ERROR_PCAP_PL_DONE",
+	[XFPGA_ERROR_AES_DECRYPT_PL] = "XFPGA_ERROR_AES_DECRYPT_PL",
+	[XFPGA_ERROR_CSU_PCAP_TRANSFER] = "XFPGA_ERROR_CSU_PCAP_TRANSFER",
+	[XFPGA_ERROR_PLSTATE_UNKNOWN] = "XFPGA_ERROR_PLSTATE_UNKNOWN",
+	[XFPGA_ERROR_BITSTREAM_FORMAT] = "XFPGA_ERROR_BITSTREAM_FORMAT",
+	[XFPGA_ERROR_UNALIGN_ADDR] = "XFPGA_ERROR_UNALIGN_ADDR",
+	[XFPGA_ERROR_AES_INIT] = "XFPGA_ERROR_AES_INIT",
+	[XFPGA_ERROR_EFUSE_CHECK] = "XFPGA_ERROR_EFUSE_CHECK",
+};
+
+static const char *const phase_names[DFX_PHASE_MAX] = {
+	[DFX_PHASE_FILE_OPEN] = "file_open",
+	[DFX_PHASE_CMA_ALLOC] = "cma_alloc",
+	[DFX_PHASE_COPY] = "copy",
+	[DFX_PHASE_SYNC] = "sync",
+	[DFX_PHASE_IOCTL] = "ioctl",
+	[DFX_PHASE_OVERLAY_MKDIR] = "overlay_mkdir",
+	[DFX_PHASE_OVERLAY_APPLY] = "overlay_apply",
+	[DFX_PHASE_STATE_CHECK] = "state_check",
+	[DFX_PHASE_TEARDOWN] = "teardown",
+	[DFX_PHASE_VERIFY] = "verify",
+	[DFX_PHASE_INIT] = "init",
+	[DFX_PHASE_LOAD] = "load",
+};
+
+/* Output cursor with snprintf() semantics: len keeps counting on overflow */
+struct metrics_out {
+	char *buf;
+	size_t size;
+	size_t len;
+};
+
+static pthread_mutex_t metrics_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t metrics_cond;
+static pthread_t metrics_thread;
+static char metrics_path[METRICS_PATH_LEN];
+static unsigned int metrics_interval_ms;
+static int metrics_running;
+static int metrics_stop;
+
+static void out_printf(struct metrics_out *out, const char *fmt, ...)
+{
+	size_t avail = out->len < out->size ? out->size - out->len : 0;
+	va_list ap;
+	int n;
+
+	va_start(ap, fmt);
+	n = vsnprintf(avail ? out->buf + out->len : NULL, avail, fmt, ap);
+	va_end(ap);
+
+	if (n > 0)
+		out->len += n;
+}
+
+/**
+ * render_histogram() - emit one phase as an OpenMetrics histogram
+ *
+ * @out:	output cursor
+ * @name:	metric family name
+ * @label:	phase label value, NULL for an unlabelled family
+ * @ps:		phase statistics
+ *
+ * The cumulative buckets follow the log-scale statistics histogram. Only
+ * buckets up to the highest populated one are written; the last statistics
+ * bucket is unbounded and is folded into +Inf.
+ */
+static void render_histogram(struct metrics_out *out, const char *name,
+			     const char *label, const struct dfx_phase_stats *ps)
+{
+	unsigned long long cumulative = 0;
+	char labels[64] = "";
+	int bucket, top = -1;
+
+	if (label != NULL)
+		snprintf(labels, sizeof(labels), "phase=\"%s\",", label);
+
+	for (bucket = 0; bucket < DFX_STATS_HIST_BUCKETS - 1; bucket++) {
+		if (ps->hist[bucket])
+			top = bucket;
+	}
+
+	for (bucket = 0; bucket <= top; bucket++) {
+		cumulative += ps->hist[bucket];
+		out_printf(out, "%s_bucket{%sle=\"%.9g\"} %llu\n", name, labels,
+			   (double)(1ULL << bucket) / 1e6, cumulative);
+	}
+	out_printf(out, "%s_bucket{%sle=\"+Inf\"} %llu\n", name, labels,
+		   ps->count);
+
+	if (label != NULL)
+		snprintf(labels, sizeof(labels), "{phase=\"%s\"}", label);
+	out_printf(out, "%s_count%s %llu\n", name, labels, ps->count);
+	out_printf(out, "%s_sum%s %llu.%09llu\n", name, labels,
+		   ps->total_ns / NSEC_PER_SEC, ps->total_ns % NSEC_PER_SEC);
+}
+
+static void render_failures(struct metrics_out *out, const char *source,
+			    const unsigned long long *counts,
+			    const char *const *names)
+{
+	int code;
+
+	for (code = 0; code < DFX_STATS_ERR_CODES; code++) {
+		if (!counts[code])
+			continue;
+		if (names[code] != NULL)
+			out_printf(out,
+				   "libdfx_load_failures_total{source=\"%s\",code=\"%s\"} %llu\n",
+				   source, names[code], counts[code]);
+		else
+			out_printf(out,
+				   "libdfx_load_failures_total{source=\"%s\",code=\"0x%x\"} %llu\n",
+				   source, code, counts[code]);
+	}
+}
+
+/* This API renders the library-wide statistics in the OpenMetrics text
+ * exposition format.
+ *
+ * char *buffer: User buffer address, may be NULL if buf_size is 0.
+ * size_t buf_size: User buffer size.
+ *
+ * Return: the length of the full exposition, excluding the terminating
+ *         null byte, like snprintf(). If it is not smaller than buf_size the
+ *         output was truncated. Negative value on failure.
+ */
+int dfx_metrics_render(char *buffer, size_t buf_size)
+{
+	struct metrics_out out = { buffer, buf_size, 0 };
+	struct dfx_stats *stats;
+	int phase;
+
+	if (buffer == NULL && buf_size) {
+		DFX_ERR("%s: Invalid input args", __func__);
+		return -DFX_INVALID_PARAM;
+	}
+
+	stats = (struct dfx_stats *) malloc(sizeof(*stats));
+	if (stats == NULL)
+		return -DFX_INSUFFICIENT_MEM;
+	dfx_stats_copy(NULL, stats);
+
+	out_printf(&out, "# TYPE libdfx_inits counter\n"
+		   "# HELP libdfx_inits Package init calls.\n"
+		   "libdfx_inits_total %llu\n", stats->init_count);
+	out_printf(&out, "# TYPE libdfx_loads counter\n"
+		   "# HELP libdfx_loads Image load calls.\n"
+		   "libdfx_loads_total %llu\n", stats->load_count);
+	out_printf(&out, "# TYPE libdfx_load_path_loads counter\n"
+		   "# HELP libdfx_load_path_loads Image loads by the way the image reached the FPGA manager.\n"
+		   "libdfx_load_path_loads_total{path=\"dmabuf\"} %llu\n"
+		   "libdfx_load_path_loads_total{path=\"firmware\"} %llu\n",
+		   stats->load_path_count[DFX_LOAD_PATH_DMABUF],
+		   stats->load_path_count[DFX_LOAD_PATH_FIRMWARE]);
+	out_printf(&out, "# TYPE libdfx_load_promotions counter\n"
+		   "# HELP libdfx_load_promotions Packages with DFX_LOAD_AUTO moved from the firmware loader to a dmabuf.\n"
+		   "libdfx_load_promotions_total %llu\n", stats->promote_count);
+	out_printf(&out, "# TYPE libdfx_load_deadline_misses counter\n"
+		   "# HELP libdfx_load_deadline_misses Timed loads refused or abandoned at their deadline.\n"
+		   "libdfx_load_deadline_misses_total %llu\n",
+		   stats->deadline_miss_count);
+
+	out_printf(&out, "# TYPE libdfx_load_failures counter\n"
+		   "# HELP libdfx_load_failures Failed image loads by DFX_* error code and by XFPGA_* code reported by the firmware.\n");
+	render_failures(&out, "dfx", stats->load_fail_dfx, dfx_err_names);
+	render_failures(&out, "xfpga", stats->load_fail_fw, fw_err_names);
+
+	out_printf(&out, "# TYPE libdfx_cma_resident_bytes gauge\n"
+		   "# UNIT libdfx_cma_resident_bytes bytes\n"
+		   "# HELP libdfx_cma_resident_bytes Bytes held in dmabuf heap buffers by initialized packages.\n"
+		   "libdfx_cma_resident_bytes %llu\n", stats->cma_bytes);
+
+	out_printf(&out, "# TYPE libdfx_load_duration_seconds histogram\n"
+		   "# UNIT libdfx_load_duration_seconds seconds\n"
+		   "# HELP libdfx_load_duration_seconds Duration of dfx_cfg_load() calls.\n");
+	render_histogram(&out, "libdfx_load_duration_seconds", NULL,
+			 &stats->phase[DFX_PHASE_LOAD]);
+
+	out_printf(&out, "# TYPE libdfx_dmabuf_alloc_duration_seconds histogram\n"
+		   "# UNIT libdfx_dmabuf_alloc_duration_seconds seconds\n"
+		   "# HELP libdfx_dmabuf_alloc_duration_seconds Duration of dmabuf heap allocation and mapping.\n");
+	render_histogram(&out, "libdfx_dmabuf_alloc_duration_seconds", NULL,
+			 &stats->phase[DFX_PHASE_CMA_ALLOC]);
+
+	out_printf(&out, "# TYPE libdfx_phase_duration_seconds histogram\n"
+		   "# UNIT libdfx_phase_duration_seconds seconds\n"
+		   "# HELP libdfx_phase_duration_seconds Duration of the individual init and load phases.\n");
+	for (phase = 0; phase < DFX_PHASE_MAX; phase++) {
+		if (phase == DFX_PHASE_LOAD || phase == DFX_PHASE_CMA_ALLOC)
+			continue;
+		render_histogram(&out, "libdfx_phase_duration_seconds",
+				 phase_names[phase], &stats->phase[phase]);
+	}
+
+	out_printf(&out, "# EOF\n");
+	free(stats);
+
+	return (int) out.len;
+}
+
+/**
+ * metrics_write_file() - render the metrics and replace @path atomically
+ *
+ * @path:	destination file
+ * @buf:	render buffer, grown as needed
+ * @size:	size of @buf
+ *
+ * The exposition goes to a temporary file in the same directory which is
+ * then renamed over @path, so a scraper never sees a partial file.
+ *
+ * Return:	0 on success, -1 on failure
+ */
+static int metrics_write_file(const char *path, char **buf, size_t *size)
+{
+	char tmp_path[METRICS_PATH_LEN + 8];
+	char *new_buf;
+	FILE *fp;
+	int len;
+
+	len = dfx_metrics_render(*buf, *size);
+	if (len < 0)
+		return -1;
+	if ((size_t)len >= *size) {
+		new_buf = (char *) realloc(*buf, len + 1);
+		if (new_buf == NULL)
+			return -1;
+		*buf = new_buf;
+		*size = len + 1;
+		len = dfx_metrics_render(*buf, *size);
+		if (len < 0 || (size_t)len >= *size)
+			return -1;
+	}
+
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+	fp = fopen(tmp_path, "w");
+	if (fp == NULL) {
+		DFX_ERR("%s: Failed to open `%s`", __func__, tmp_path);
+		return -1;
+	}
+	if (fwrite(*buf, 1, len, fp) != (size_t)len) {
+		DFX_ERR("%s: Failed to write `%s`", __func__, tmp_path);
+		fclose(fp);
+		unlink(tmp_path);
+		return -1;
+	}
+	fclose(fp);
+
+	if (rename(tmp_path, path)) {
+		DFX_ERR("%s: Failed to rename `%s`", __func__, tmp_path);
+		unlink(tmp_path);
+		return -1;
+	}
+
+	return 0;
+}
+
+static void *metrics_worker(void *arg)
+{
+	size_t size = METRICS_INITIAL_BUF;
+	struct timespec deadline;
+	char *buf;
+
+	(void)arg;
+	buf = (char *) malloc(size);
+
+	pthread_mutex_lock(&metrics_lock);
+	while (!metrics_stop) {
+		pthread_mutex_unlock(&metrics_lock);
+		if (buf != NULL)
+			metrics_write_file(metrics_path, &buf, &size);
+		pthread_mutex_lock(&metrics_lock);
+
+		clock_gettime(CLOCK_MONOTONIC, &deadline);
+		deadline.tv_sec += metrics_interval_ms / 1000;
+		deadline.tv_nsec += (metrics_interval_ms % 1000) * NSEC_PER_MSEC;
+		if (deadline.tv_nsec >= (long)NSEC_PER_SEC) {
+			deadline.tv_sec++;
+			deadline.tv_nsec -= NSEC_PER_SEC;
+		}
+
+		while (!metrics_stop &&
+		       pthread_cond_timedwait(&metrics_cond, &metrics_lock,
+					      &deadline) != ETIMEDOUT)
+			;
+	}
+	pthread_mutex_unlock(&metrics_lock);
+
+	free(buf);
+	return NULL;
+}
+
+/* This API starts a background thread which periodically writes the
+ * OpenMetrics exposition (see dfx_metrics_render()) to a file, for example
+ * for the node-exporter textfile collector.
+ *
+ * const char *path: Destination file, replaced atomically on each refresh.
+ * unsigned int interval_ms: Refresh interval in milliseconds.
+ *
+ * Return: returns zero on success or Error code on failure.
+ */
+int dfx_metrics_file_start(const char *path, unsigned int interval_ms)
+{
+	pthread_condattr_t attr;
+	int ret = 0;
+
+	if (path == NULL || strlen(path) >= METRICS_PATH_LEN ||
+	    interval_ms < METRICS_MIN_INTERVAL_MS) {
+		DFX_ERR("%s: Invalid input args", __func__);
+		return -DFX_INVALID_PARAM;
+	}
+
+	pthread_mutex_lock(&metrics_lock);
+	if (metrics_running) {
+		DFX_ERR("%s: Metrics file writer already running", __func__);
+		ret = -DFX_INVALID_PARAM;
+		goto END;
+	}
+
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&metrics_cond, &attr);
+	pthread_condattr_destroy(&attr);
+
+	strcpy(metrics_path, path);
+	metrics_interval_ms = interval_ms;
+	metrics_stop = 0;
+	if (pthread_create(&metrics_thread, NULL, metrics_worker, NULL)) {
+		DFX_ERR("%s: Failed to start the metrics thread", __func__);
+		pthread_cond_destroy(&metrics_cond);
+		ret = -DFX_INSUFFICIENT_MEM;
+		goto END;
+	}
+	metrics_running = 1;
+
+END:
+	pthread_mutex_unlock(&metrics_lock);
+	return ret;
+}
+
+/* This API stops the metrics file writer started by
+ * dfx_metrics_file_start(). The last written file is left in place.
+ *
+ * Return: returns zero on success or Error code on failure.
+ */
+int dfx_metrics_file_stop(void)
+{
+	pthread_mutex_lock(&metrics_lock);
+	if (!metrics_running) {
+		pthread_mutex_unlock(&metrics_lock);
+		return -DFX_INVALID_PARAM;
+	}
+	metrics_stop = 1;
+	pthread_cond_signal(&metrics_cond);
+	pthread_mutex_unlock(&metrics_lock);
+
+	pthread_join(metrics_thread, NULL);
+
+	pthread_mutex_lock(&metrics_lock);
+	pthread_cond_destroy(&metrics_cond);
+	metrics_running = 0;
+	pthread_mutex_unlock(&metrics_lock);
+
+	return 0;
+}
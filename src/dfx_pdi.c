@@ -0,0 +1,415 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "dfx_log.h"
+#include "dfx_pdi.h"
+
+/* Boot header fields, only present in boot (full) PDIs */
+#define PDI_BH_WIDTH_DETECT	0x10U
+#define PDI_BH_IDENT		0x14U
+#define PDI_BH_META_HDR_OFST	0xC4U
+#define PDI_WIDTH_DETECT	0xAA995566U
+#define PDI_IDENT_XNLX		0x584C4E58U	/* "XNLX" */
+
+/* Partial PDIs read over SelectMAP may start with a bus width pattern */
+#define PDI_SMAP_PATTERN_LEN	0x10U
+
+/* Image header table */
+#define IHT_VERSION		0x00U
+#define IHT_NUM_IMAGES		0x04U
+#define IHT_IMG_HDR_ADDR	0x08U
+#define IHT_NUM_PARTITIONS	0x0CU
+#define IHT_PRTN_HDR_ADDR	0x10U
+#define IHT_IDCODE		0x18U
+#define IHT_ATTR		0x1CU
+#define IHT_PDI_ID		0x20U
+
+/* Image header */
+#define IH_FIRST_PRTN_HDR	0x00U
+#define IH_NUM_PARTITIONS	0x04U
+#define IH_ATTR			0x0CU
+#define IH_NAME			0x10U
+#define IH_NAME_LEN		16U
+#define IH_ID			0x20U
+#define IH_UID			0x24U
+#define IH_PUID			0x28U
+#define IH_FUNC_ID		0x2CU
+
+/* Partition header */
+#define PH_UNENC_DATA_LEN	0x04U
+#define PH_TOTAL_DATA_LEN	0x08U
+#define PH_EXEC_ADDR_LO		0x10U
+#define PH_EXEC_ADDR_HI		0x14U
+#define PH_LOAD_ADDR_LO		0x18U
+#define PH_LOAD_ADDR_HI		0x1CU
+#define PH_DATA_OFST		0x20U
+#define PH_ATTR			0x24U
+#define PH_ID			0x30U
+
+/* Far more than any real PDI, keeps the bounds arithmetic in range */
+#define PDI_MAX_HEADERS		4096U
+
+/*
+ * Direct-mapped cache of raw meta headers, keyed by device and inode and
+ * checked against size and mtime. A colliding file evicts the slot.
+ */
+#define PDI_CACHE_SLOTS		1024U
+
+struct pdi_cache_entry {
+	dev_t dev;
+	ino_t ino;
+	off_t size;
+	struct timespec mtime;
+	struct dfx_pdi_layout layout;
+	size_t raw_len;
+	unsigned char raw[];	/* IHT, image headers, partition headers */
+};
+
+static struct pdi_cache_entry *pdi_cache[PDI_CACHE_SLOTS];
+static pthread_mutex_t pdi_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t le32(const unsigned char *p)
+{
+	return (uint32_t)p[0] | (uint32_t)p[1] << 8 |
+	       (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static unsigned long long le64(const unsigned char *lo, const unsigned char *hi)
+{
+	return (unsigned long long)le32(hi) << 32 | le32(lo);
+}
+
+/* Every header ends with the complemented sum of its other words */
+static int checksum_ok(const unsigned char *p, size_t len)
+{
+	uint32_t sum = 0;
+	size_t i;
+
+	for (i = 0; i + 4 < len; i += 4)
+		sum += le32(p + i);
+
+	return (sum ^ 0xFFFFFFFFU) == le32(p + len - 4);
+}
+
+static int iht_at(const unsigned char *buf, size_t len, size_t off)
+{
+	if (off > len || len - off < PDI_IHT_LEN)
+		return 0;
+	if (!checksum_ok(buf + off, PDI_IHT_LEN))
+		return 0;
+
+	return le32(buf + off + IHT_NUM_IMAGES) != 0 &&
+	       le32(buf + off + IHT_NUM_PARTITIONS) != 0;
+}
+
+static void decode_image(const unsigned char *ih, struct dfx_pdi_image *img)
+{
+	size_t i;
+
+	memcpy(img->name, ih + IH_NAME, IH_NAME_LEN);
+	img->name[IH_NAME_LEN] = '\0';
+	for (i = 0; i < IH_NAME_LEN && img->name[i]; i++)
+		;
+	img->name[i] = '\0';
+
+	img->id = le32(ih + IH_ID);
+	img->uid = le32(ih + IH_UID);
+	img->parent_uid = le32(ih + IH_PUID);
+	img->function_id = le32(ih + IH_FUNC_ID);
+	img->attributes = le32(ih + IH_ATTR);
+	img->num_partitions = le32(ih + IH_NUM_PARTITIONS);
+}
+
+static void decode_partition(const unsigned char *ph, size_t base,
+			     struct dfx_pdi_partition *prtn)
+{
+	prtn->id = le32(ph + PH_ID);
+	prtn->attributes = le32(ph + PH_ATTR);
+	prtn->exec_address = le64(ph + PH_EXEC_ADDR_LO, ph + PH_EXEC_ADDR_HI);
+	prtn->load_address = le64(ph + PH_LOAD_ADDR_LO, ph + PH_LOAD_ADDR_HI);
+	prtn->data_offset = base + 4ULL * le32(ph + PH_DATA_OFST);
+	prtn->data_size = 4ULL * le32(ph + PH_TOTAL_DATA_LEN);
+	prtn->plain_size = 4ULL * le32(ph + PH_UNENC_DATA_LEN);
+}
+
+int dfx_pdi_locate(const unsigned char *buf, size_t len,
+		   struct dfx_pdi_layout *layout)
+{
+	const unsigned char *iht;
+	size_t base, off;
+	unsigned int i;
+	int full = 0;
+
+	/*
+	 * Table addresses are word offsets from the start of the PDI, which
+	 * for a partial PDI is where its image header table starts.
+	 */
+	if (len >= PDI_BH_META_HDR_OFST + 4 &&
+	    le32(buf + PDI_BH_WIDTH_DETECT) == PDI_WIDTH_DETECT &&
+	    le32(buf + PDI_BH_IDENT) == PDI_IDENT_XNLX) {
+		full = 1;
+		base = 0;
+		off = le32(buf + PDI_BH_META_HDR_OFST);
+	} else if (iht_at(buf, len, 0)) {
+		base = off = 0;
+	} else {
+		base = off = PDI_SMAP_PATTERN_LEN;
+	}
+	if (!iht_at(buf, len, off))
+		return -DFX_PDI_FORMAT_ERROR;
+
+	iht = buf + off;
+	layout->full = full;
+	layout->base = base;
+	layout->iht = off;
+	layout->num_images = le32(iht + IHT_NUM_IMAGES);
+	layout->num_partitions = le32(iht + IHT_NUM_PARTITIONS);
+	layout->img_hdrs = base + 4ULL * le32(iht + IHT_IMG_HDR_ADDR);
+	layout->prtn_hdrs = base + 4ULL * le32(iht + IHT_PRTN_HDR_ADDR);
+	if (layout->num_images > PDI_MAX_HEADERS ||
+	    layout->num_partitions > PDI_MAX_HEADERS ||
+	    layout->img_hdrs > len ||
+	    (len - layout->img_hdrs) / PDI_IMG_HDR_LEN < layout->num_images ||
+	    layout->prtn_hdrs > len ||
+	    (len - layout->prtn_hdrs) / PDI_PRTN_HDR_LEN < layout->num_partitions)
+		return -DFX_PDI_FORMAT_ERROR;
+
+	for (i = 0; i < layout->num_images; i++) {
+		if (!checksum_ok(buf + layout->img_hdrs + i * PDI_IMG_HDR_LEN,
+				 PDI_IMG_HDR_LEN))
+			return -DFX_PDI_FORMAT_ERROR;
+	}
+	for (i = 0; i < layout->num_partitions; i++) {
+		if (!checksum_ok(buf + layout->prtn_hdrs + i * PDI_PRTN_HDR_LEN,
+				 PDI_PRTN_HDR_LEN))
+			return -DFX_PDI_FORMAT_ERROR;
+	}
+
+	return 0;
+}
+
+void dfx_pdi_decode(const unsigned char *iht, const unsigned char *img_hdrs,
+		    const unsigned char *prtn_hdrs,
+		    const struct dfx_pdi_layout *layout,
+		    struct dfx_pdi_meta *meta)
+{
+	const unsigned char *ih;
+	unsigned long long first;
+	unsigned int i;
+
+	memset(meta, 0, sizeof(*meta));
+	meta->full = layout->full;
+	meta->version = le32(iht + IHT_VERSION);
+	meta->id_code = le32(iht + IHT_IDCODE);
+	meta->attributes = le32(iht + IHT_ATTR);
+	meta->pdi_id = le32(iht + IHT_PDI_ID);
+	meta->num_images = layout->num_images;
+	meta->num_partitions = layout->num_partitions;
+
+	for (i = 0; i < layout->num_images && i < DFX_PDI_MAX_IMAGES; i++) {
+		ih = img_hdrs + i * PDI_IMG_HDR_LEN;
+		decode_image(ih, &meta->images[i]);
+		first = layout->base + 4ULL * le32(ih + IH_FIRST_PRTN_HDR);
+		if (first >= layout->prtn_hdrs)
+			meta->images[i].first_partition =
+				(first - layout->prtn_hdrs) / PDI_PRTN_HDR_LEN;
+	}
+	for (i = 0; i < layout->num_partitions && i < DFX_PDI_MAX_PARTITIONS;
+	     i++)
+		decode_partition(prtn_hdrs + i * PDI_PRTN_HDR_LEN, layout->base,
+				 &meta->partitions[i]);
+}
+
+int dfx_pdi_parse(const unsigned char *buf, size_t len,
+		  struct dfx_pdi_layout *layout, struct dfx_pdi_meta *meta)
+{
+	int ret;
+
+	ret = dfx_pdi_locate(buf, len, layout);
+	if (ret == 0 && meta != NULL)
+		dfx_pdi_decode(buf + layout->iht, buf + layout->img_hdrs,
+			       buf + layout->prtn_hdrs, layout, meta);
+
+	return ret;
+}
+
+static size_t pdi_cache_slot(const struct stat *st)
+{
+	unsigned long long key;
+
+	key = ((unsigned long long)st->st_dev << 32) ^ st->st_ino;
+	return (size_t)((key * 0x9E3779B97F4A7C15ULL) >> 54) %
+	       PDI_CACHE_SLOTS;
+}
+
+static int pdi_cache_match(const struct pdi_cache_entry *entry,
+			   const struct stat *st)
+{
+	return entry != NULL && entry->dev == st->st_dev &&
+	       entry->ino == st->st_ino && entry->size == st->st_size &&
+	       entry->mtime.tv_sec == st->st_mtim.tv_sec &&
+	       entry->mtime.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+/* Copies the headers out of a cache entry, called with the lock held */
+static int pdi_cache_copy(const struct pdi_cache_entry *entry,
+			  struct dfx_pdi_meta *meta, void *raw, size_t raw_size)
+{
+	size_t img_len = (size_t)entry->layout.num_images * PDI_IMG_HDR_LEN;
+
+	if (raw != NULL && raw_size < entry->raw_len)
+		return -DFX_INSUFFICIENT_MEM;
+	if (raw != NULL)
+		memcpy(raw, entry->raw, entry->raw_len);
+	if (meta != NULL)
+		dfx_pdi_decode(entry->raw, entry->raw + PDI_IHT_LEN,
+			       entry->raw + PDI_IHT_LEN + img_len,
+			       &entry->layout, meta);
+
+	return (int)entry->raw_len;
+}
+
+/**
+ * pdi_cache_fill() - read the headers of a PDI file into a new cache entry
+ *
+ * @path:	PDI file
+ * @st:		stat of @path, taken before it was opened
+ *
+ * Return:	the entry, or NULL with @err set to a negative error code
+ */
+static struct pdi_cache_entry *pdi_cache_fill(const char *path,
+					      const struct stat *st, int *err)
+{
+	struct pdi_cache_entry *entry = NULL;
+	struct dfx_pdi_layout layout;
+	const unsigned char *map;
+	size_t img_len, prtn_len;
+	int fd;
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		DFX_ERR("%s: Failed to open `%s`", __func__, path);
+		*err = -DFX_FAIL_TO_OPEN_BIN_FILE;
+		return NULL;
+	}
+	map = st->st_size ? mmap(NULL, st->st_size, PROT_READ, MAP_PRIVATE,
+				 fd, 0) : MAP_FAILED;
+	close(fd);
+	if (map == MAP_FAILED) {
+		DFX_ERR("%s: Failed to map `%s`", __func__, path);
+		*err = st->st_size ? -DFX_FAIL_TO_OPEN_BIN_FILE :
+				     -DFX_PDI_FORMAT_ERROR;
+		return NULL;
+	}
+
+	*err = dfx_pdi_locate(map, st->st_size, &layout);
+	if (*err) {
+		DFX_ERR("%s: `%s` is not a valid PDI", __func__, path);
+		goto UNMAP;
+	}
+
+	img_len = (size_t)layout.num_images * PDI_IMG_HDR_LEN;
+	prtn_len = (size_t)layout.num_partitions * PDI_PRTN_HDR_LEN;
+	entry = malloc(sizeof(*entry) + PDI_IHT_LEN + img_len + prtn_len);
+	if (entry == NULL) {
+		*err = -DFX_INSUFFICIENT_MEM;
+		goto UNMAP;
+	}
+	entry->dev = st->st_dev;
+	entry->ino = st->st_ino;
+	entry->size = st->st_size;
+	entry->mtime = st->st_mtim;
+	entry->layout = layout;
+	entry->raw_len = PDI_IHT_LEN + img_len + prtn_len;
+	memcpy(entry->raw, map + layout.iht, PDI_IHT_LEN);
+	memcpy(entry->raw + PDI_IHT_LEN, map + layout.img_hdrs, img_len);
+	memcpy(entry->raw + PDI_IHT_LEN + img_len, map + layout.prtn_hdrs,
+	       prtn_len);
+UNMAP:
+	munmap((void *)map, st->st_size);
+	return entry;
+}
+
+int dfx_pdi_read_file(const char *path, struct dfx_pdi_meta *meta,
+		      void *raw, size_t raw_size)
+{
+	struct pdi_cache_entry *entry;
+	struct stat st;
+	size_t slot;
+	int ret;
+
+	if (stat(path, &st)) {
+		DFX_ERR("%s: Failed to open `%s`", __func__, path);
+		return -DFX_FAIL_TO_OPEN_BIN_FILE;
+	}
+
+	slot = pdi_cache_slot(&st);
+	pthread_mutex_lock(&pdi_cache_lock);
+	if (pdi_cache_match(pdi_cache[slot], &st)) {
+		ret = pdi_cache_copy(pdi_cache[slot], meta, raw, raw_size);
+		pthread_mutex_unlock(&pdi_cache_lock);
+		return ret;
+	}
+	pthread_mutex_unlock(&pdi_cache_lock);
+
+	/* Miss: read the file without holding up lookups of other files */
+	entry = pdi_cache_fill(path, &st, &ret);
+	if (entry == NULL)
+		return ret;
+
+	pthread_mutex_lock(&pdi_cache_lock);
+	ret = pdi_cache_copy(entry, meta, raw, raw_size);
+	free(pdi_cache[slot]);
+	pdi_cache[slot] = entry;
+	pthread_mutex_unlock(&pdi_cache_lock);
+
+	return ret;
+}
+
+void dfx_pdi_cache_flush(void)
+{
+	size_t i;
+
+	pthread_mutex_lock(&pdi_cache_lock);
+	for (i = 0; i < PDI_CACHE_SLOTS; i++) {
+		free(pdi_cache[i]);
+		pdi_cache[i] = NULL;
+	}
+	pthread_mutex_unlock(&pdi_cache_lock);
+}
+
+/* This API decodes the meta header (image header table, image headers and
+ * partition headers) of a Versal PDI file. The file is mapped and parsed
+ * in userspace; only the pages holding the headers are read. Results are
+ * cached by file identity and modification time, so repeated queries of an
+ * unchanged file cost a stat().
+ *
+ * const char *pdi_file: PDI image.
+ * struct dfx_pdi_meta *meta: User buffer address.
+ *
+ * Return: returns zero on success or Error code on failure.
+ */
+int dfx_get_pdi_meta(const char *pdi_file, struct dfx_pdi_meta *meta)
+{
+	int ret;
+
+	if (pdi_file == NULL || meta == NULL) {
+		DFX_ERR("%s: Invalid input args", __func__);
+		return -DFX_INVALID_PARAM;
+	}
+
+	ret = dfx_pdi_read_file(pdi_file, meta, NULL, 0);
+
+	return ret < 0 ? ret : 0;
+}
@@ -0,0 +1,199 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#include <endian.h>
+#include <fcntl.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "dfx_digest.h"
+#include "dfx_log.h"
+#include "dfx_mgr.h"
+#include "dfx_pkg.h"
+
+/* Error returned for a second entry of each type */
+static const int dfx_pkg_dup_err[DFX_PKG_ENTRY_MAX] = {
+	[DFX_PKG_ENTRY_IMAGE] = DFX_DUPLICATE_FIRMWARE_ERROR,
+	[DFX_PKG_ENTRY_IMAGE_DTBO] = DFX_DUPLICATE_DTBO_ERROR,
+	[DFX_PKG_ENTRY_DRIVERS_DTBO] = DFX_DUPLICATE_DRIVERS_DTBO_ERROR,
+	[DFX_PKG_ENTRY_KEY_REF] = DFX_DUPLICATE_AES_KEY_ERROR,
+	[DFX_PKG_ENTRY_META] = DFX_READ_PACKAGE_ERROR,
+};
+
+int dfx_pkg_is_container(const char *path)
+{
+	size_t len = strlen(path), suffix = strlen(DFX_PKG_SUFFIX);
+
+	return len > suffix && !strcasecmp(path + len - suffix, DFX_PKG_SUFFIX);
+}
+
+static int has_suffix(const char *name, size_t len, const char *suffix)
+{
+	size_t n = strlen(suffix);
+
+	return len > n && !strcasecmp(name + len - n, suffix);
+}
+
+int dfx_pkg_file_type(const char *name, int platform)
+{
+	size_t len = strlen(name);
+
+	if ((has_suffix(name, len, ".pdi") && platform != ZYNQMP_PLATFORM) ||
+	    (has_suffix(name, len, ".bin") && platform != VERSAL_PLATFORM) ||
+	    (has_suffix(name, len, ".bit") && platform != VERSAL_PLATFORM))
+		return DFX_PKG_ENTRY_IMAGE;
+	if (has_suffix(name, len, "_d.dtbo"))
+		return DFX_PKG_ENTRY_DRIVERS_DTBO;
+	if (has_suffix(name, len, ".dtbo"))
+		return DFX_PKG_ENTRY_IMAGE_DTBO;
+	if (has_suffix(name, len, ".nky"))
+		return DFX_PKG_ENTRY_KEY_REF;
+
+	return 0;
+}
+
+static void copy_name(char *dst, const char *src)
+{
+	memcpy(dst, src, DFX_PKG_NAME_LEN);
+	dst[DFX_PKG_NAME_LEN - 1] = '\0';
+}
+
+/* Validates the header and entry table and fills @pkg->entry */
+static int read_index(struct dfx_pkg *pkg, const char *path)
+{
+	const unsigned char *map = pkg->map;
+	struct dfx_pkg_payload *payload;
+	struct dfx_pkg_header hdr;
+	struct dfx_pkg_entry ent;
+	uint64_t offset, size;
+	uint32_t i, n, type;
+
+	if (pkg->map_len < sizeof(hdr))
+		goto INVALID;
+	memcpy(&hdr, map, sizeof(hdr));
+	n = le32toh(hdr.num_entries);
+	if (memcmp(hdr.magic, DFX_PKG_MAGIC, sizeof(hdr.magic)) ||
+	    le32toh(hdr.version) != DFX_PKG_VERSION ||
+	    n > (pkg->map_len - sizeof(hdr)) / sizeof(ent))
+		goto INVALID;
+	copy_name(pkg->name, hdr.name);
+
+	for (i = 0; i < n; i++) {
+		memcpy(&ent, map + sizeof(hdr) + i * sizeof(ent), sizeof(ent));
+		type = le32toh(ent.type);
+		offset = le64toh(ent.offset);
+		size = le64toh(ent.size);
+
+		/* Entries of later versions are skipped */
+		if (type == 0 || type >= DFX_PKG_ENTRY_MAX)
+			continue;
+		if (offset > pkg->map_len || size > pkg->map_len - offset)
+			goto INVALID;
+		if (type == DFX_PKG_ENTRY_IMAGE && offset % DFX_PKG_ALIGN)
+			goto INVALID;
+
+		payload = &pkg->entry[type];
+		if (payload->data != NULL) {
+			DFX_ERR("%s: `%s` has more than one entry of type %u",
+				__func__, path, type);
+			return -dfx_pkg_dup_err[type];
+		}
+		payload->data = map + offset;
+		payload->size = size;
+		payload->crc32c = le32toh(ent.crc32c);
+		copy_name(payload->name, ent.name);
+
+		if (type != DFX_PKG_ENTRY_IMAGE &&
+		    dfx_crc32c(0, payload->data, size) != payload->crc32c) {
+			DFX_ERR("%s: `%s` entry `%s` is corrupted", __func__,
+				path, payload->name);
+			return -DFX_READ_PACKAGE_ERROR;
+		}
+	}
+
+	if (pkg->entry[DFX_PKG_ENTRY_IMAGE_DTBO].data == NULL) {
+		DFX_ERR("%s: `%s` has no image overlay", __func__, path);
+		return -DFX_READ_PACKAGE_ERROR;
+	}
+
+	return 0;
+
+INVALID:
+	DFX_ERR("%s: `%s` is not a valid package container", __func__, path);
+	return -DFX_READ_PACKAGE_ERROR;
+}
+
+int dfx_pkg_open(const char *path, struct dfx_pkg *pkg)
+{
+	struct stat st;
+	int fd, ret;
+
+	memset(pkg, 0, sizeof(*pkg));
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		DFX_ERR("%s: Failed to open `%s`", __func__, path);
+		return -DFX_FAIL_TO_OPEN_BIN_FILE;
+	}
+	if (fstat(fd, &st) || st.st_size == 0) {
+		close(fd);
+		DFX_ERR("%s: `%s` is empty", __func__, path);
+		return -DFX_READ_PACKAGE_ERROR;
+	}
+
+	pkg->map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (pkg->map == MAP_FAILED) {
+		pkg->map = NULL;
+		DFX_ERR("%s: Failed to map `%s`", __func__, path);
+		return -DFX_FAIL_TO_OPEN_BIN_FILE;
+	}
+	pkg->map_len = st.st_size;
+
+	ret = read_index(pkg, path);
+	if (ret)
+		dfx_pkg_close(pkg);
+
+	return ret;
+}
+
+int dfx_pkg_probe(int fd, char *name, char *image_name)
+{
+	struct dfx_pkg_header hdr;
+	struct dfx_pkg_entry ent;
+	uint32_t i, n, type;
+	int types = 0;
+
+	image_name[0] = '\0';
+	if (pread(fd, &hdr, sizeof(hdr), 0) != sizeof(hdr) ||
+	    memcmp(hdr.magic, DFX_PKG_MAGIC, sizeof(hdr.magic)) ||
+	    le32toh(hdr.version) != DFX_PKG_VERSION)
+		return -DFX_READ_PACKAGE_ERROR;
+	copy_name(name, hdr.name);
+
+	n = le32toh(hdr.num_entries);
+	for (i = 0; i < n; i++) {
+		if (pread(fd, &ent, sizeof(ent), sizeof(hdr) + i * sizeof(ent)) !=
+		    sizeof(ent))
+			return -DFX_READ_PACKAGE_ERROR;
+		type = le32toh(ent.type);
+		if (type == 0 || type >= DFX_PKG_ENTRY_MAX)
+			continue;
+		types |= 1 << type;
+		if (type == DFX_PKG_ENTRY_IMAGE)
+			copy_name(image_name, ent.name);
+	}
+
+	return types;
+}
+
+void dfx_pkg_close(struct dfx_pkg *pkg)
+{
+	if (pkg->map != NULL)
+		munmap(pkg->map, pkg->map_len);
+	memset(pkg, 0, sizeof(*pkg));
+}
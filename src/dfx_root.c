@@ -0,0 +1,83 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "dfx_log.h"
+#include "dfx_root.h"
+
+#ifndef DTBO_ROOT_DIR
+#define DTBO_ROOT_DIR "/sys/kernel/config/device-tree/overlays"
+#endif
+
+#define DFX_ROOT_PATH_LEN	256U
+
+static const char *const root_defaults[DFX_ROOT_MAX] = {
+	[DFX_ROOT_FPGA_MGR] = "/sys/class/fpga_manager",
+	[DFX_ROOT_DEV] = "/dev",
+	[DFX_ROOT_OVERLAYS] = DTBO_ROOT_DIR,
+	[DFX_ROOT_DMA_HEAP] = "/dev/dma_heap",
+	[DFX_ROOT_DEVICETREE] = "/sys/firmware/devicetree/base",
+	[DFX_ROOT_FW_SEARCH_PATH] = "/sys/module/firmware_class/parameters/path",
+	[DFX_ROOT_VERSAL_FW] = "/sys/devices/platform/firmware:versal-firmware",
+};
+
+static char roots[DFX_ROOT_MAX][DFX_ROOT_PATH_LEN];
+
+const char *dfx_root(enum dfx_root root)
+{
+	if (roots[root][0] != '\0')
+		return roots[root];
+
+	return root_defaults[root];
+}
+
+int dfx_root_redirected(enum dfx_root root)
+{
+	return roots[root][0] != '\0';
+}
+
+/* This API redirects one of the kernel interfaces used by the library to
+ * a different path, so the library can run against a generated directory
+ * tree instead of the real sysfs, configfs and /dev.
+ *
+ * enum dfx_root root: The interface to redirect.
+ * const char *path: The new path, or NULL to restore the default.
+ *
+ * Roots are not protected against concurrent use, they must be set before
+ * any package is initialized.
+ *
+ * Return: returns zero on success or Error code on failure.
+ */
+int dfx_set_root(enum dfx_root root, const char *path)
+{
+	size_t len;
+
+	if ((int)root < 0 || root >= DFX_ROOT_MAX) {
+		DFX_ERR("%s: Invalid root", __func__);
+		return -DFX_INVALID_PARAM;
+	}
+
+	/* Whatever was read through the old root no longer applies */
+	dfx_invalidate_cache();
+	if (path == NULL) {
+		roots[root][0] = '\0';
+		return 0;
+	}
+
+	len = strlen(path);
+	while (len > 1 && path[len - 1] == '/')
+		len--;
+	if (len == 0 || len >= DFX_ROOT_PATH_LEN) {
+		DFX_ERR("%s: Invalid path `%s`", __func__, path);
+		return -DFX_INVALID_PARAM;
+	}
+
+	memcpy(roots[root], path, len);
+	roots[root][len] = '\0';
+
+	return 0;
+}
@@ -0,0 +1,251 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#include "dfx_stats.h"
+
+#define NSEC_PER_USEC	1000ULL
+#define NSEC_PER_SEC	1000000000ULL
+
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct dfx_stats global_stats;
+
+unsigned long long dfx_stats_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+unsigned long long dfx_stats_phase_end(struct dfx_load_record *rec,
+				       enum dfx_phase phase,
+				       unsigned long long start)
+{
+	unsigned long long now = dfx_stats_now();
+
+	rec->phase_ns[phase] += now - start;
+	rec->phase_mask |= 1U << phase;
+
+	return now;
+}
+
+/**
+ * hist_bucket() - map a duration onto its log-scale histogram bucket
+ *
+ * @ns:	duration in nanoseconds
+ *
+ * Return:	bucket index, see DFX_STATS_HIST_BUCKETS
+ */
+static int hist_bucket(unsigned long long ns)
+{
+	unsigned long long us = ns / NSEC_PER_USEC;
+	int bucket;
+
+	if (us == 0)
+		return 0;
+
+	bucket = 64 - __builtin_clzll(us);
+	if (bucket >= DFX_STATS_HIST_BUCKETS)
+		bucket = DFX_STATS_HIST_BUCKETS - 1;
+
+	return bucket;
+}
+
+static void phase_stats_add(struct dfx_phase_stats *ps, unsigned long long ns)
+{
+	if (ps->count == 0 || ns < ps->min_ns)
+		ps->min_ns = ns;
+	if (ns > ps->max_ns)
+		ps->max_ns = ns;
+	ps->count++;
+	ps->total_ns += ns;
+	ps->hist[hist_bucket(ns)]++;
+}
+
+/* Out of range error codes are counted in slot 0 */
+static int err_index(int code)
+{
+	if (code <= 0 || code >= DFX_STATS_ERR_CODES)
+		return 0;
+
+	return code;
+}
+
+static void stats_add_record(struct dfx_stats *stats,
+			     const struct dfx_load_record *rec, int is_load)
+{
+	int phase;
+
+	for (phase = 0; phase < DFX_PHASE_MAX; phase++) {
+		if (rec->phase_mask & (1U << phase))
+			phase_stats_add(&stats->phase[phase],
+					rec->phase_ns[phase]);
+	}
+
+	if (!is_load) {
+		stats->init_count++;
+		return;
+	}
+
+	stats->load_count++;
+	if (rec->load_path >= 0 && rec->load_path < DFX_LOAD_PATH_MAX)
+		stats->load_path_count[rec->load_path]++;
+	if (rec->result) {
+		stats->load_fail_count++;
+		stats->load_fail_dfx[err_index(-rec->result)]++;
+	}
+	if (rec->fw_error)
+		stats->load_fail_fw[err_index((rec->fw_error >> 8) & 0xFF)]++;
+	stats->last_load = *rec;
+}
+
+void dfx_stats_commit(struct dfx_stats *pkg_stats,
+		      const struct dfx_load_record *rec, int is_load)
+{
+	pthread_mutex_lock(&stats_lock);
+	stats_add_record(&global_stats, rec, is_load);
+	if (pkg_stats != NULL)
+		stats_add_record(pkg_stats, rec, is_load);
+	pthread_mutex_unlock(&stats_lock);
+}
+
+void dfx_stats_record(struct dfx_stats *pkg_stats, enum dfx_phase phase,
+		      unsigned long long ns)
+{
+	pthread_mutex_lock(&stats_lock);
+	phase_stats_add(&global_stats.phase[phase], ns);
+	if (pkg_stats != NULL)
+		phase_stats_add(&pkg_stats->phase[phase], ns);
+	pthread_mutex_unlock(&stats_lock);
+}
+
+void dfx_stats_cma(struct dfx_stats *pkg_stats, long long delta)
+{
+	pthread_mutex_lock(&stats_lock);
+	global_stats.cma_bytes += delta;
+	if (pkg_stats != NULL)
+		pkg_stats->cma_bytes += delta;
+	pthread_mutex_unlock(&stats_lock);
+}
+
+void dfx_stats_promote(struct dfx_stats *pkg_stats)
+{
+	pthread_mutex_lock(&stats_lock);
+	global_stats.promote_count++;
+	if (pkg_stats != NULL)
+		pkg_stats->promote_count++;
+	pthread_mutex_unlock(&stats_lock);
+}
+
+void dfx_stats_deadline_miss(struct dfx_stats *pkg_stats)
+{
+	pthread_mutex_lock(&stats_lock);
+	global_stats.deadline_miss_count++;
+	if (pkg_stats != NULL)
+		pkg_stats->deadline_miss_count++;
+	pthread_mutex_unlock(&stats_lock);
+}
+
+void dfx_stats_copy(const struct dfx_stats *pkg_stats, struct dfx_stats *stats)
+{
+	pthread_mutex_lock(&stats_lock);
+	memcpy(stats, pkg_stats ? pkg_stats : &global_stats, sizeof(*stats));
+	pthread_mutex_unlock(&stats_lock);
+}
+
+void dfx_stats_ring_add(struct dfx_stats_ring *ring, unsigned long long ns)
+{
+	pthread_mutex_lock(&stats_lock);
+	ring->ns[ring->next] = ns;
+	ring->next = (ring->next + 1) % DFX_STATS_RING_LEN;
+	if (ring->count < DFX_STATS_RING_LEN)
+		ring->count++;
+	pthread_mutex_unlock(&stats_lock);
+}
+
+void dfx_stats_ring_reset(struct dfx_stats_ring *ring)
+{
+	pthread_mutex_lock(&stats_lock);
+	memset(ring, 0, sizeof(*ring));
+	pthread_mutex_unlock(&stats_lock);
+}
+
+unsigned long long dfx_stats_ring_median(const struct dfx_stats_ring *ring,
+					 unsigned int min_count)
+{
+	unsigned long long ns[DFX_STATS_RING_LEN], v;
+	unsigned int count, i, j;
+
+	pthread_mutex_lock(&stats_lock);
+	count = ring->count;
+	memcpy(ns, ring->ns, sizeof(ns));
+	pthread_mutex_unlock(&stats_lock);
+
+	if (count == 0 || count < min_count)
+		return 0;
+
+	/* Insertion sort, the ring is a handful of entries */
+	for (i = 1; i < count; i++) {
+		v = ns[i];
+		for (j = i; j > 0 && ns[j - 1] > v; j--)
+			ns[j] = ns[j - 1];
+		ns[j] = v;
+	}
+
+	if (count % 2)
+		return ns[count / 2];
+	return (ns[count / 2 - 1] + ns[count / 2]) / 2;
+}
+
+/**
+ * dfx_stats_percentile() - estimate a latency percentile from a histogram
+ *
+ * @phase_stats:	statistics of one phase, as returned by dfx_get_stats()
+ * @percentile:		requested percentile in the range 0 - 100
+ *
+ * The result is the upper bound of the histogram bucket holding the
+ * requested percentile, clamped to the observed minimum and maximum.
+ *
+ * Return:	the estimated duration in nanoseconds, 0 if nothing was recorded
+ */
+unsigned long long dfx_stats_percentile(const struct dfx_phase_stats *phase_stats,
+					double percentile)
+{
+	unsigned long long rank, seen = 0, bound;
+	int bucket;
+
+	if (phase_stats == NULL || phase_stats->count == 0)
+		return 0;
+
+	if (percentile <= 0)
+		return phase_stats->min_ns;
+	if (percentile >= 100)
+		return phase_stats->max_ns;
+
+	rank = (unsigned long long)(phase_stats->count * percentile / 100.0);
+	if (rank == 0)
+		rank = 1;
+
+	for (bucket = 0; bucket < DFX_STATS_HIST_BUCKETS; bucket++) {
+		seen += phase_stats->hist[bucket];
+		if (seen >= rank)
+			break;
+	}
+
+	if (bucket >= DFX_STATS_HIST_BUCKETS - 1)
+		return phase_stats->max_ns;
+
+	bound = (1ULL << bucket) * NSEC_PER_USEC;
+	if (bound > phase_stats->max_ns)
+		bound = phase_stats->max_ns;
+	if (bound < phase_stats->min_ns)
+		bound = phase_stats->min_ns;
+
+	return bound;
+}
@@ -0,0 +1,365 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "libdfx.h"
+#include "dfx_log.h"
+#include "dfx_trace.h"
+
+#define TRACE_RING_SIZE		(64U * 1024U)	/* power of two */
+#define TRACE_STR_MAX		1024U
+#define TRACE_FLUSH_MS		100U
+#define NSEC_PER_SEC		1000000000ULL
+#define NSEC_PER_MSEC		1000000ULL
+
+#define TRACE_ALIGN(x)	(((x) + DFX_TRACE_ALIGN - 1) & ~(DFX_TRACE_ALIGN - 1))
+
+/*
+ * Single producer, single consumer byte ring. The owning thread appends
+ * records at @head, the writer thread consumes them at @tail. Records never
+ * wrap: a PAD header sends the consumer back to the start of the ring.
+ */
+struct trace_ring {
+	unsigned char *buf;
+	size_t head;
+	size_t tail;
+	unsigned long long dropped;
+	uint32_t tid;
+	int dead;
+	struct trace_ring *next;
+};
+
+int dfx_trace_enabled;
+
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t trace_cond;
+static pthread_once_t trace_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t trace_key;
+static pthread_t trace_thread;
+static struct trace_ring *trace_rings;
+static FILE *trace_fp;
+static int trace_running;
+static int trace_stop;
+static __thread struct trace_ring *trace_tls_ring;
+
+static void trace_ring_exit(void *arg)
+{
+	struct trace_ring *ring = arg;
+
+	__atomic_store_n(&ring->dead, 1, __ATOMIC_RELEASE);
+}
+
+static void trace_key_create(void)
+{
+	pthread_key_create(&trace_key, trace_ring_exit);
+}
+
+static struct trace_ring *trace_ring_register(void)
+{
+	struct trace_ring *ring;
+
+	ring = (struct trace_ring *) calloc(1, sizeof(*ring));
+	if (ring == NULL)
+		return NULL;
+
+	ring->buf = (unsigned char *) malloc(TRACE_RING_SIZE);
+	if (ring->buf == NULL) {
+		free(ring);
+		return NULL;
+	}
+	ring->tid = (uint32_t) syscall(SYS_gettid);
+
+	pthread_once(&trace_key_once, trace_key_create);
+	pthread_setspecific(trace_key, ring);
+
+	pthread_mutex_lock(&trace_lock);
+	ring->next = trace_rings;
+	trace_rings = ring;
+	pthread_mutex_unlock(&trace_lock);
+
+	trace_tls_ring = ring;
+	return ring;
+}
+
+void dfx_trace_call(enum dfx_trace_op op, unsigned long long start,
+		    int package_id, int result, unsigned long flags,
+		    int nstr, const char *const *strs)
+{
+	struct trace_ring *ring = trace_tls_ring;
+	struct dfx_trace_record *rec;
+	size_t len[DFX_TRACE_MAX_STRS];
+	size_t size, head, tail, off, contig, need;
+	unsigned char *p;
+	int i;
+
+	if (ring == NULL) {
+		ring = trace_ring_register();
+		if (ring == NULL)
+			return;
+	}
+
+	if (nstr > (int)DFX_TRACE_MAX_STRS)
+		nstr = DFX_TRACE_MAX_STRS;
+
+	size = sizeof(*rec);
+	for (i = 0; i < nstr; i++) {
+		len[i] = strs[i] ? strnlen(strs[i], TRACE_STR_MAX - 1) : 0;
+		size += len[i] + 1;
+	}
+	size = TRACE_ALIGN(size);
+
+	head = ring->head;
+	tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+	off = head & (TRACE_RING_SIZE - 1);
+	contig = TRACE_RING_SIZE - off;
+	need = contig < size ? contig + size : size;
+	if (TRACE_RING_SIZE - (head - tail) < need) {
+		__atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+		return;
+	}
+
+	if (contig < size) {
+		rec = (struct dfx_trace_record *)(ring->buf + off);
+		rec->op = DFX_TRACE_OP_PAD;
+		head += contig;
+		off = 0;
+	}
+
+	rec = (struct dfx_trace_record *)(ring->buf + off);
+	memset(rec, 0, sizeof(*rec));
+	rec->size = (uint16_t) size;
+	rec->op = (uint8_t) op;
+	rec->nstr = (uint8_t) nstr;
+	rec->tid = ring->tid;
+	rec->package_id = package_id;
+	rec->result = result;
+	rec->flags = (uint32_t) flags;
+	rec->start_ns = start;
+	rec->duration_ns = dfx_stats_now() - start;
+
+	p = (unsigned char *)(rec + 1);
+	for (i = 0; i < nstr; i++) {
+		if (strs[i] == NULL)
+			rec->null_mask |= 1U << i;
+		else
+			memcpy(p, strs[i], len[i]);
+		p[len[i]] = '\0';
+		p += len[i] + 1;
+	}
+	memset(p, 0, (unsigned char *)rec + size - p);
+
+	__atomic_store_n(&ring->head, head + size, __ATOMIC_RELEASE);
+}
+
+/**
+ * trace_ring_drain() - move the records of one ring into the trace file
+ *
+ * @ring:	ring to drain
+ * @fp:		trace file
+ */
+static void trace_ring_drain(struct trace_ring *ring, FILE *fp)
+{
+	struct dfx_trace_record drop;
+	struct dfx_trace_record *rec;
+	unsigned long long dropped;
+	size_t head, tail, off;
+
+	head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+	tail = ring->tail;
+	while (tail != head) {
+		off = tail & (TRACE_RING_SIZE - 1);
+		rec = (struct dfx_trace_record *)(ring->buf + off);
+		if (rec->op == DFX_TRACE_OP_PAD) {
+			tail += TRACE_RING_SIZE - off;
+			continue;
+		}
+		fwrite(rec, 1, rec->size, fp);
+		tail += rec->size;
+	}
+	__atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+
+	dropped = __atomic_exchange_n(&ring->dropped, 0, __ATOMIC_RELAXED);
+	if (dropped) {
+		memset(&drop, 0, sizeof(drop));
+		drop.size = sizeof(drop);
+		drop.op = DFX_TRACE_OP_DROPPED;
+		drop.tid = ring->tid;
+		drop.result = (int32_t) dropped;
+		drop.start_ns = dfx_stats_now();
+		fwrite(&drop, 1, sizeof(drop), fp);
+	}
+}
+
+/* Drains every ring and frees the rings of exited threads */
+static void trace_drain_all(FILE *fp)
+{
+	struct trace_ring **link, *ring;
+
+	pthread_mutex_lock(&trace_lock);
+	link = &trace_rings;
+	while ((ring = *link) != NULL) {
+		if (__atomic_load_n(&ring->dead, __ATOMIC_ACQUIRE)) {
+			trace_ring_drain(ring, fp);
+			*link = ring->next;
+			free(ring->buf);
+			free(ring);
+			continue;
+		}
+		trace_ring_drain(ring, fp);
+		link = &ring->next;
+	}
+	pthread_mutex_unlock(&trace_lock);
+
+	fflush(fp);
+}
+
+static void *trace_writer(void *arg)
+{
+	struct timespec deadline;
+
+	(void)arg;
+
+	pthread_mutex_lock(&trace_lock);
+	while (!trace_stop) {
+		clock_gettime(CLOCK_MONOTONIC, &deadline);
+		deadline.tv_nsec += TRACE_FLUSH_MS * NSEC_PER_MSEC;
+		if (deadline.tv_nsec >= (long)NSEC_PER_SEC) {
+			deadline.tv_sec++;
+			deadline.tv_nsec -= NSEC_PER_SEC;
+		}
+		while (!trace_stop &&
+		       pthread_cond_timedwait(&trace_cond, &trace_lock,
+					      &deadline) != ETIMEDOUT)
+			;
+
+		pthread_mutex_unlock(&trace_lock);
+		trace_drain_all(trace_fp);
+		pthread_mutex_lock(&trace_lock);
+	}
+	pthread_mutex_unlock(&trace_lock);
+
+	return NULL;
+}
+
+/* This API starts recording every package lifecycle call (dfx_cfg_*() and
+ * the dfx_get_*() firmware queries) with its arguments, result and
+ * CLOCK_MONOTONIC timestamps. Calls are appended to per-thread ring buffers
+ * without taking locks, and a background thread writes them to @path in
+ * the format described in dfx_trace_format.h.
+ *
+ * const char *path: Trace file to create.
+ *
+ * Return: returns zero on success or Error code on failure.
+ */
+int dfx_trace_start(const char *path)
+{
+	struct dfx_trace_file_header hdr;
+	pthread_condattr_t attr;
+	struct timespec ts;
+	struct trace_ring *ring;
+	int ret = 0;
+
+	if (path == NULL) {
+		DFX_ERR("%s: Invalid input args", __func__);
+		return -DFX_INVALID_PARAM;
+	}
+
+	pthread_mutex_lock(&trace_lock);
+	if (trace_running) {
+		DFX_ERR("%s: Trace recorder already running", __func__);
+		ret = -DFX_INVALID_PARAM;
+		goto END;
+	}
+
+	trace_fp = fopen(path, "wb");
+	if (trace_fp == NULL) {
+		DFX_ERR("%s: Failed to open `%s`", __func__, path);
+		ret = -DFX_TRACE_ERROR;
+		goto END;
+	}
+
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, DFX_TRACE_MAGIC, sizeof(hdr.magic));
+	hdr.byte_order = DFX_TRACE_BYTE_ORDER;
+	hdr.version = DFX_TRACE_VERSION;
+	hdr.start_ns = dfx_stats_now();
+	clock_gettime(CLOCK_REALTIME, &ts);
+	hdr.realtime_ns = (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+	if (fwrite(&hdr, 1, sizeof(hdr), trace_fp) != sizeof(hdr)) {
+		DFX_ERR("%s: Failed to write `%s`", __func__, path);
+		ret = -DFX_TRACE_ERROR;
+		goto close_file;
+	}
+
+	/* Discard whatever was left behind by a previous session */
+	for (ring = trace_rings; ring != NULL; ring = ring->next) {
+		__atomic_store_n(&ring->tail,
+				 __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE),
+				 __ATOMIC_RELEASE);
+		__atomic_store_n(&ring->dropped, 0, __ATOMIC_RELAXED);
+	}
+
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&trace_cond, &attr);
+	pthread_condattr_destroy(&attr);
+
+	trace_stop = 0;
+	if (pthread_create(&trace_thread, NULL, trace_writer, NULL)) {
+		DFX_ERR("%s: Failed to start the trace writer", __func__);
+		pthread_cond_destroy(&trace_cond);
+		ret = -DFX_TRACE_ERROR;
+		goto close_file;
+	}
+
+	trace_running = 1;
+	__atomic_store_n(&dfx_trace_enabled, 1, __ATOMIC_RELEASE);
+	goto END;
+
+close_file:
+	fclose(trace_fp);
+	trace_fp = NULL;
+	unlink(path);
+END:
+	pthread_mutex_unlock(&trace_lock);
+	return ret;
+}
+
+/* This API stops the recorder started by dfx_trace_start(), writes the
+ * remaining records and closes the trace file.
+ *
+ * Return: returns zero on success or Error code on failure.
+ */
+int dfx_trace_stop(void)
+{
+	pthread_mutex_lock(&trace_lock);
+	if (!trace_running) {
+		pthread_mutex_unlock(&trace_lock);
+		return -DFX_INVALID_PARAM;
+	}
+	__atomic_store_n(&dfx_trace_enabled, 0, __ATOMIC_RELEASE);
+	trace_stop = 1;
+	pthread_cond_signal(&trace_cond);
+	pthread_mutex_unlock(&trace_lock);
+
+	pthread_join(trace_thread, NULL);
+
+	pthread_mutex_lock(&trace_lock);
+	pthread_cond_destroy(&trace_cond);
+	fclose(trace_fp);
+	trace_fp = NULL;
+	trace_running = 0;
+	pthread_mutex_unlock(&trace_lock);
+
+	return 0;
+}
@@ -0,0 +1,174 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "dfx_uid.h"
+
+/* Ints per entry of the firmware UID list */
+#define UID_TUPLE_INTS		4
+
+/* Smallest hash table, keeps the probe sequences short for tiny trees */
+#define UID_MIN_BITS		4U
+
+static unsigned int node_key(const struct dfx_uid_node *node,
+			     enum dfx_uid_key key)
+{
+	switch (key) {
+	case DFX_UID_KEY_NODE_ID:
+		return node->node_id;
+	case DFX_UID_KEY_FUNCTION_ID:
+		return node->function_id;
+	default:
+		return node->uid;
+	}
+}
+
+static unsigned int slot_of(unsigned int value, unsigned int bits)
+{
+	return (value * 0x9E3779B1U) >> (32 - bits);
+}
+
+/* Adds node @i to the table of @key unless a node with that key is there */
+static void table_insert(struct dfx_uid_index *index, enum dfx_uid_key key,
+			 int i)
+{
+	unsigned int mask = (1U << index->bits) - 1;
+	unsigned int value = node_key(&index->nodes[i], key);
+	unsigned int slot = slot_of(value, index->bits);
+	int *table = index->table[key];
+
+	while (table[slot]) {
+		if (node_key(&index->nodes[table[slot] - 1], key) == value)
+			return;
+		slot = (slot + 1) & mask;
+	}
+	table[slot] = i + 1;
+}
+
+void dfx_uid_index_free(struct dfx_uid_index *index)
+{
+	int key;
+
+	free(index->nodes);
+	for (key = 0; key < DFX_UID_KEY_MAX; key++)
+		free(index->table[key]);
+	memset(index, 0, sizeof(*index));
+}
+
+int dfx_uid_index_build(struct dfx_uid_index *index, const int *tuples,
+			size_t len)
+{
+	const struct dfx_uid_node *parent;
+	struct dfx_uid_node *node;
+	size_t entries = len / (UID_TUPLE_INTS * sizeof(int)), e;
+	unsigned int bits = UID_MIN_BITS;
+	int i, key;
+
+	dfx_uid_index_free(index);
+
+	/* Keep the tables at most half full */
+	while ((1UL << bits) < 2 * entries)
+		bits++;
+
+	index->bits = bits;
+	index->nodes = calloc(entries ? entries : 1, sizeof(*index->nodes));
+	for (key = 0; key < DFX_UID_KEY_MAX; key++)
+		index->table[key] = calloc(1UL << bits, sizeof(int));
+	if (index->nodes == NULL || index->table[0] == NULL ||
+	    index->table[1] == NULL || index->table[2] == NULL) {
+		dfx_uid_index_free(index);
+		return -DFX_INSUFFICIENT_MEM;
+	}
+
+	for (e = 0; e < entries; e++) {
+		const int *t = tuples + e * UID_TUPLE_INTS;
+
+		if (t[1] == 0)
+			continue;
+		node = &index->nodes[index->count];
+		node->node_id = t[0];
+		node->uid = t[1];
+		node->parent_uid = t[2];
+		node->function_id = t[3];
+		node->parent = -1;
+		node->first_child = -1;
+		node->next_sibling = -1;
+		for (key = 0; key < DFX_UID_KEY_MAX; key++)
+			table_insert(index, key, index->count);
+		index->count++;
+	}
+
+	/* Link children in reverse so that each list keeps firmware order */
+	for (i = index->count - 1; i >= 0; i--) {
+		node = &index->nodes[i];
+		if (node->parent_uid == 0 || node->parent_uid == node->uid)
+			continue;
+		parent = dfx_uid_index_find(index, DFX_UID_KEY_UID,
+					    node->parent_uid);
+		if (parent == NULL)
+			continue;
+		node->parent = parent - index->nodes;
+		node->next_sibling = parent->first_child;
+		index->nodes[node->parent].first_child = i;
+	}
+
+	return 0;
+}
+
+const struct dfx_uid_node *dfx_uid_index_find(const struct dfx_uid_index *index,
+					      enum dfx_uid_key key,
+					      unsigned int value)
+{
+	unsigned int mask, slot;
+	const int *table;
+
+	if (index->count == 0)
+		return NULL;
+
+	mask = (1U << index->bits) - 1;
+	slot = slot_of(value, index->bits);
+	table = index->table[key];
+	while (table[slot]) {
+		if (node_key(&index->nodes[table[slot] - 1], key) == value)
+			return &index->nodes[table[slot] - 1];
+		slot = (slot + 1) & mask;
+	}
+
+	return NULL;
+}
+
+static int pairs_have_uid(const struct dfx_uid_pair *pairs, int count,
+			  unsigned int uid)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if (pairs[i].uid == uid)
+			return 1;
+	}
+
+	return 0;
+}
+
+int dfx_uid_index_check(const struct dfx_uid_index *index,
+			const struct dfx_uid_pair *pairs, int count)
+{
+	int i, active = 1;
+
+	for (i = 0; i < count; i++) {
+		if (dfx_uid_index_find(index, DFX_UID_KEY_UID, pairs[i].uid))
+			continue;
+		active = 0;
+		if (pairs[i].parent_uid != 0 &&
+		    !dfx_uid_index_find(index, DFX_UID_KEY_UID,
+					pairs[i].parent_uid) &&
+		    !pairs_have_uid(pairs, count, pairs[i].parent_uid))
+			return -DFX_UID_PARENT_ERROR;
+	}
+
+	return active;
+}
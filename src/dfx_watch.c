@@ -0,0 +1,439 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "libdfx.h"
+#include "dfx_log.h"
+#include "dfx_mgr.h"
+#include "dfx_root.h"
+#include "dfx_stats.h"
+#include "dfx_watch.h"
+
+#define WATCH_QUEUE_LEN		64U	/* power of two */
+#define WATCH_POLL_MS		100U
+#define WATCH_MGR_NAME_LEN	32U
+#define WATCH_PATH_LEN		512U
+#define WATCH_EPOLL_EVENTS	4
+#define NSEC_PER_MSEC		1000000ULL
+
+/*
+ * One dfx_watch_open(). The caller polls @epoll_fd, which is readable when
+ * one of the sources is. The state attribute is polled for POLLPRI like
+ * any sysfs attribute; where it is a plain file it is watched with inotify
+ * instead. Mainline FPGA managers never notify the attribute, so it is
+ * also sampled every WATCH_POLL_MS until POLLPRI has been seen to fire.
+ */
+struct dfx_watch {
+	int epoll_fd;
+	int event_fd;		/* events queued by library calls */
+	int inotify_fd;
+	int state_fd;		/* -1 unless the state attribute is polled */
+	int timer_fd;		/* -1 unless the state is sampled */
+	bool pri_seen;		/* state_fd has reported POLLPRI */
+	int overlay_wd;
+	int state_wd;
+	unsigned int mask;
+	char mgr_name[WATCH_MGR_NAME_LEN];
+	char state[DFX_WATCH_NAME_LEN];	/* last state reported */
+
+	/* Protected by watch_lock */
+	unsigned int head;
+	unsigned int tail;
+	bool overflow;
+	struct dfx_watch_event queue[WATCH_QUEUE_LEN];
+	struct dfx_watch *next;
+};
+
+int dfx_watch_count;
+
+static pthread_mutex_t watch_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct dfx_watch *watch_list;
+
+/* Appends an event to the queue of @w, watch_lock held */
+static void watch_queue(struct dfx_watch *w, unsigned int type,
+			int package_id, int result, const char *name)
+{
+	struct dfx_watch_event *ev;
+
+	if (!(w->mask & (1U << type)))
+		return;
+	if (w->head - w->tail == WATCH_QUEUE_LEN) {
+		w->overflow = true;
+		return;
+	}
+
+	ev = &w->queue[w->head++ & (WATCH_QUEUE_LEN - 1)];
+	memset(ev, 0, sizeof(*ev));
+	ev->type = type;
+	ev->package_id = package_id;
+	ev->result = result;
+	ev->time_ns = dfx_stats_now();
+	if (name != NULL)
+		snprintf(ev->name, sizeof(ev->name), "%s", name);
+}
+
+static void watch_wake(struct dfx_watch *w)
+{
+	uint64_t one = 1;
+
+	if (write(w->event_fd, &one, sizeof(one)) < 0)
+		DFX_DBG("%s: eventfd write failed", __func__);
+}
+
+void dfx_watch_notify(enum dfx_watch_type type, const char *mgr_name,
+		      int package_id, int result)
+{
+	struct dfx_watch *w;
+
+	pthread_mutex_lock(&watch_lock);
+	for (w = watch_list; w != NULL; w = w->next) {
+		if (strcmp(w->mgr_name, mgr_name))
+			continue;
+		watch_queue(w, type, package_id, result, NULL);
+		/* Also when masked out, a load changes the state */
+		watch_wake(w);
+	}
+	pthread_mutex_unlock(&watch_lock);
+}
+
+/* Reads the state attribute, without the trailing newline */
+static int watch_read_state(struct dfx_watch *w, char *buf)
+{
+	char path[WATCH_PATH_LEN];
+	ssize_t n;
+	int fd = w->state_fd;
+
+	if (fd < 0) {
+		snprintf(path, sizeof(path), "%s/%s/state",
+			 dfx_root(DFX_ROOT_FPGA_MGR), w->mgr_name);
+		fd = open(path, O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+			return -1;
+	}
+
+	/* Reading from the start also re-arms POLLPRI of a sysfs attribute */
+	n = pread(fd, buf, DFX_WATCH_NAME_LEN - 1, 0);
+	if (fd != w->state_fd)
+		close(fd);
+	if (n < 0)
+		return -1;
+
+	buf[n] = '\0';
+	buf[strcspn(buf, "\n")] = '\0';
+	return 0;
+}
+
+/* Turns the pending inotify records into overlay events */
+static void watch_drain_inotify(struct dfx_watch *w)
+{
+	char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	const struct inotify_event *ev;
+	unsigned int type;
+	ssize_t len;
+	char *p;
+
+	while ((len = read(w->inotify_fd, buf, sizeof(buf))) > 0) {
+		pthread_mutex_lock(&watch_lock);
+		for (p = buf; p < buf + len; p += sizeof(*ev) + ev->len) {
+			ev = (const struct inotify_event *)p;
+			if (ev->mask & IN_Q_OVERFLOW) {
+				w->overflow = true;
+				continue;
+			}
+			if (ev->wd != w->overlay_wd || !(ev->mask & IN_ISDIR))
+				continue;
+			type = ev->mask & IN_CREATE ? DFX_WATCH_OVERLAY_ADDED :
+						      DFX_WATCH_OVERLAY_REMOVED;
+			watch_queue(w, type, 0, 0, ev->len ? ev->name : NULL);
+		}
+		pthread_mutex_unlock(&watch_lock);
+	}
+}
+
+static int watch_add(struct dfx_watch *w, int fd, unsigned int events)
+{
+	struct epoll_event ev = { 0 };
+
+	ev.events = events;
+	ev.data.fd = fd;
+	return epoll_ctl(w->epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+static void watch_free(struct dfx_watch *w)
+{
+	int *fds[] = { &w->epoll_fd, &w->event_fd, &w->inotify_fd,
+		       &w->state_fd, &w->timer_fd };
+	size_t i;
+
+	for (i = 0; i < sizeof(fds) / sizeof(fds[0]); i++)
+		if (*fds[i] >= 0)
+			close(*fds[i]);
+	free(w);
+}
+
+/* Sets up sampling of the state, for a state attribute nothing notifies */
+static int watch_start_timer(struct dfx_watch *w)
+{
+	struct itimerspec its = { 0 };
+
+	w->timer_fd = timerfd_create(CLOCK_MONOTONIC,
+				     TFD_CLOEXEC | TFD_NONBLOCK);
+	if (w->timer_fd < 0)
+		return -1;
+
+	its.it_interval.tv_nsec = WATCH_POLL_MS * NSEC_PER_MSEC;
+	its.it_value = its.it_interval;
+	if (timerfd_settime(w->timer_fd, 0, &its, NULL))
+		return -1;
+
+	DFX_INFO("%s: state of %s is sampled every %u ms", __func__,
+		 w->mgr_name, WATCH_POLL_MS);
+	return watch_add(w, w->timer_fd, EPOLLIN);
+}
+
+/* This API opens a watch on an FPGA manager and the configfs overlays. The
+ * returned fd becomes readable (POLLIN) when there are events to collect
+ * with dfx_watch_read(); it is meant for poll(), epoll or an event loop,
+ * and must only be closed with dfx_watch_close().
+ *
+ * FPGA state changes are picked up with POLLPRI on the sysfs state
+ * attribute. Since not every FPGA manager driver notifies it, the state is
+ * also sampled every 100 ms until a notification has been seen, and
+ * re-read whenever anything else wakes the watch. Overlay
+ * directories are watched with inotify. DFX_WATCH_LOAD and
+ * DFX_WATCH_REMOVE report calls of this process on the same manager.
+ *
+ * const char *devpath: FPGA manager, see dfx_cfg_init(). NULL selects fpga0.
+ * unsigned int events: Mask of (1 << DFX_WATCH_*) bits, or DFX_WATCH_ALL.
+ *
+ * Return: returns the fd of the watch or Error code on failure.
+ */
+int dfx_watch_open(const char *devpath, unsigned int events)
+{
+	char path[WATCH_PATH_LEN];
+	struct dfx_watch *w;
+	int ret;
+
+	if (!(events & DFX_WATCH_ALL)) {
+		DFX_ERR("%s: No event selected", __func__);
+		return -DFX_INVALID_PARAM;
+	}
+
+	w = calloc(1, sizeof(*w));
+	if (w == NULL)
+		return -DFX_INSUFFICIENT_MEM;
+	w->epoll_fd = w->event_fd = w->inotify_fd = -1;
+	w->state_fd = w->timer_fd = -1;
+	w->overlay_wd = w->state_wd = -1;
+	w->mask = (events & DFX_WATCH_ALL) | (1U << DFX_WATCH_OVERFLOW);
+
+	if (dfx_fpga_mgr_name(devpath, w->mgr_name, sizeof(w->mgr_name))) {
+		ret = -DFX_INVALID_PARAM;
+		goto ERR;
+	}
+
+	snprintf(path, sizeof(path), "%s/%s/state",
+		 dfx_root(DFX_ROOT_FPGA_MGR), w->mgr_name);
+	w->state_fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (w->state_fd < 0) {
+		DFX_ERR("%s: Failed to open `%s`", __func__, path);
+		ret = -DFX_FAIL_TO_OPEN_DEV_NODE;
+		goto ERR;
+	}
+	watch_read_state(w, w->state);
+
+	w->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	w->event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (w->epoll_fd < 0 || w->event_fd < 0 ||
+	    watch_add(w, w->event_fd, EPOLLIN)) {
+		DFX_ERR("%s: Failed to create the watch fds", __func__);
+		ret = -DFX_INSUFFICIENT_MEM;
+		goto ERR;
+	}
+
+	w->inotify_fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+
+	/* epoll refuses plain files, as in a tree set up with dfx_set_root() */
+	if (watch_add(w, w->state_fd, EPOLLPRI)) {
+		close(w->state_fd);
+		w->state_fd = -1;
+		if (w->inotify_fd >= 0)
+			w->state_wd = inotify_add_watch(w->inotify_fd, path,
+							IN_MODIFY);
+	}
+
+	if (w->inotify_fd >= 0)
+		w->overlay_wd = inotify_add_watch(w->inotify_fd,
+						  dfx_root(DFX_ROOT_OVERLAYS),
+						  IN_CREATE | IN_DELETE |
+						  IN_ONLYDIR);
+	if (w->overlay_wd < 0)
+		DFX_WARN("%s: Cannot watch `%s`, no overlay events", __func__,
+			 dfx_root(DFX_ROOT_OVERLAYS));
+	if ((w->overlay_wd >= 0 || w->state_wd >= 0) &&
+	    watch_add(w, w->inotify_fd, EPOLLIN)) {
+		ret = -DFX_INSUFFICIENT_MEM;
+		goto ERR;
+	}
+
+	if (((w->state_fd >= 0 && (w->mask & (1U << DFX_WATCH_FPGA_STATE))) ||
+	     (w->state_fd < 0 && w->state_wd < 0)) && watch_start_timer(w)) {
+		DFX_ERR("%s: Cannot watch the state of %s", __func__,
+			w->mgr_name);
+		ret = -DFX_INSUFFICIENT_MEM;
+		goto ERR;
+	}
+
+	pthread_mutex_lock(&watch_lock);
+	w->next = watch_list;
+	watch_list = w;
+	__atomic_add_fetch(&dfx_watch_count, 1, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&watch_lock);
+
+	return w->epoll_fd;
+
+ERR:
+	watch_free(w);
+	return ret;
+}
+
+/* The driver notifies the state attribute, stop sampling it */
+static void watch_pri_seen(struct dfx_watch *w)
+{
+	struct itimerspec its = { 0 };
+
+	if (w->pri_seen || w->timer_fd < 0)
+		return;
+
+	w->pri_seen = true;
+	if (timerfd_settime(w->timer_fd, 0, &its, NULL))
+		return;
+	DFX_INFO("%s: state of %s is notified, sampling stopped", __func__,
+		 w->mgr_name);
+}
+
+static struct dfx_watch *watch_find(int fd)
+{
+	struct dfx_watch *w;
+
+	pthread_mutex_lock(&watch_lock);
+	for (w = watch_list; w != NULL; w = w->next)
+		if (w->epoll_fd == fd)
+			break;
+	pthread_mutex_unlock(&watch_lock);
+
+	return w;
+}
+
+/* This API collects the events of a watch without blocking. Events of one
+ * source are in order; a load and the overlay it created may be reported
+ * in either order. DFX_WATCH_OVERFLOW means events were dropped, the
+ * caller should re-read what it tracks. A watch must not be read from two
+ * threads at once, nor closed while it is read.
+ *
+ * int fd: Watch returned by dfx_watch_open().
+ * struct dfx_watch_event *events: Receives the events.
+ * int max_events: Size of events. What does not fit is kept, the fd
+ *		   stays readable.
+ *
+ * Return: returns the number of events, 0 if there are none, or Error
+ *	   code on failure.
+ */
+int dfx_watch_read(int fd, struct dfx_watch_event *events, int max_events)
+{
+	struct epoll_event ev[WATCH_EPOLL_EVENTS];
+	char state[DFX_WATCH_NAME_LEN];
+	struct dfx_watch *w;
+	uint64_t count;
+	int i, n, ret = 0;
+
+	if (events == NULL || max_events <= 0) {
+		DFX_ERR("%s: Invalid input args", __func__);
+		return -DFX_INVALID_PARAM;
+	}
+
+	w = watch_find(fd);
+	if (w == NULL) {
+		DFX_ERR("%s: %d is not a watch", __func__, fd);
+		return -DFX_INVALID_PARAM;
+	}
+
+	n = epoll_wait(w->epoll_fd, ev, WATCH_EPOLL_EVENTS, 0);
+	for (i = 0; i < n; i++) {
+		if (ev[i].data.fd == w->inotify_fd)
+			watch_drain_inotify(w);
+		else if (ev[i].data.fd == w->state_fd)
+			watch_pri_seen(w);
+		else if (
+			 read(ev[i].data.fd, &count, sizeof(count)) < 0)
+			DFX_DBG("%s: nothing to read on %d", __func__,
+				ev[i].data.fd);
+	}
+
+	pthread_mutex_lock(&watch_lock);
+	if (n > 0 && !watch_read_state(w, state) && strcmp(state, w->state)) {
+		memcpy(w->state, state, sizeof(state));
+		watch_queue(w, DFX_WATCH_FPGA_STATE, 0, 0, state);
+	}
+
+	if (w->overflow) {
+		memset(&events[ret], 0, sizeof(events[ret]));
+		events[ret].type = DFX_WATCH_OVERFLOW;
+		events[ret].time_ns = dfx_stats_now();
+		w->overflow = false;
+		ret++;
+	}
+	while (ret < max_events && w->tail != w->head)
+		events[ret++] = w->queue[w->tail++ & (WATCH_QUEUE_LEN - 1)];
+	if (w->tail != w->head)
+		watch_wake(w);
+	pthread_mutex_unlock(&watch_lock);
+
+	return ret;
+}
+
+/* This API closes a watch returned by dfx_watch_open() and drops its
+ * pending events.
+ *
+ * int fd: Watch returned by dfx_watch_open().
+ *
+ * Return: returns zero on success or Error code on failure.
+ */
+int dfx_watch_close(int fd)
+{
+	struct dfx_watch **pw, *w = NULL;
+
+	pthread_mutex_lock(&watch_lock);
+	for (pw = &watch_list; *pw != NULL; pw = &(*pw)->next) {
+		if ((*pw)->epoll_fd == fd) {
+			w = *pw;
+			*pw = w->next;
+			__atomic_sub_fetch(&dfx_watch_count, 1,
+					   __ATOMIC_RELAXED);
+			break;
+		}
+	}
+	pthread_mutex_unlock(&watch_lock);
+
+	if (w == NULL) {
+		DFX_ERR("%s: %d is not a watch", __func__, fd);
+		return -DFX_INVALID_PARAM;
+	}
+
+	watch_free(w);
+	return 0;
+}
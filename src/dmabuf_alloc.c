@@ -8,14 +8,20 @@
  *
  ***************************************************************/
 
+#define _GNU_SOURCE
 #include <fcntl.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/ioctl.h>
 #include <unistd.h>
 #include <sys/mman.h>
+#include <linux/dma-buf.h>
+#include <linux/udmabuf.h>
 #include "dmabuf_alloc.h"
 #include "dma-heap.h"
+#include "dfx_log.h"
+#include "dfx_probes.h"
+#include "dfx_root.h"
 
 #include <dirent.h>
 #include <string.h>
@@ -28,8 +34,8 @@ static int is_cma_default_node(const char *node_name)
 	char path[512];
 
 	snprintf(path, sizeof(path),
-		 "/sys/firmware/devicetree/base/reserved-memory/%s/linux,cma-default",
-		 node_name);
+		 "%s/reserved-memory/%s/linux,cma-default",
+		 dfx_root(DFX_ROOT_DEVICETREE), node_name);
 
 	/* returns 1 if property exists, 0 if not */
 	return (access(path, F_OK) == 0);
@@ -37,8 +43,11 @@ static int is_cma_default_node(const char *node_name)
 
 static int open_device(const char *cma_file, int *devfd)
 {
+	char path[256];
+	int len;
+
 	if (!devfd) {
-		printf("%s: Invalid devfd pointer\n", __func__);
+		DFX_ERR("%s: Invalid devfd pointer", __func__);
 		return -1;
 	}
 
@@ -50,12 +59,13 @@ static int open_device(const char *cma_file, int *devfd)
 	}
 
 	// Try default kernel reserved CMA heap
-	*devfd = open("/dev/dma_heap/reserved", O_RDWR);
+	snprintf(path, sizeof(path), "%s/reserved", dfx_root(DFX_ROOT_DMA_HEAP));
+	*devfd = open(path, O_RDWR);
 	if (*devfd >= 0)
 		return 0;
 
 	// Dynamic scan for cma_reserved@* that also has linux,cma-default
-	DIR *dir = opendir("/dev/dma_heap");
+	DIR *dir = opendir(dfx_root(DFX_ROOT_DMA_HEAP));
 	if (dir) {
 		struct dirent *entry;
 		while ((entry = readdir(dir)) != NULL) {
@@ -65,9 +75,11 @@ static int open_device(const char *cma_file, int *devfd)
 				if (!is_cma_default_node(entry->d_name))
 					continue;
 
-				char path[256];
-				snprintf(path, sizeof(path),
-					 "/dev/dma_heap/%s", entry->d_name);
+				len = snprintf(path, sizeof(path), "%s/%s",
+					       dfx_root(DFX_ROOT_DMA_HEAP),
+					       entry->d_name);
+				if (len < 0 || (size_t)len >= sizeof(path))
+					continue;
 
 				*devfd = open(path, O_RDWR);
 
@@ -80,12 +92,100 @@ static int open_device(const char *cma_file, int *devfd)
 		closedir(dir);
 	}
 
-	printf("%s: No valid CMA heap found\n", __func__);
+	DFX_ERR("%s: No valid CMA heap found", __func__);
 
 	return -1;
 }
 
-static int alloc_dma_buffer(struct dma_buffer_info *dma_data)
+/* mmap()s @fd over the whole buffer */
+static int map_fd(struct dma_buffer_info *dma_data, int fd)
+{
+	dma_data->dma_buffer = (unsigned char *)mmap(NULL, dma_data->dma_buflen,
+						     PROT_READ|PROT_WRITE,
+						     MAP_SHARED, fd, 0);
+	if (dma_data->dma_buffer == MAP_FAILED) {
+		dma_data->dma_buffer = NULL;
+		DFX_ERR("%s: mmap: Failed", __func__);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int map_dma_buffer(struct dma_buffer_info *dma_data)
+{
+	return map_fd(dma_data, dma_data->dma_buffd);
+}
+
+static int sync_dmabuf_fd(struct dma_buffer_info *dma_data,
+			  unsigned long long flags)
+{
+	struct dma_buf_sync sync = { 0 };
+
+	sync.flags = flags;
+	return ioctl(dma_data->dma_buffd, DMA_BUF_IOCTL_SYNC, &sync);
+}
+
+static void free_dma_buffer(struct dma_buffer_info *dma_data)
+{
+	if (dma_data->dma_buffer != NULL)
+		munmap(dma_data->dma_buffer, dma_data->dma_buflen);
+
+	if (dma_data->dma_buffd > 0)
+		close(dma_data->dma_buffd);
+
+	if (dma_data->memfd > 0)
+		close(dma_data->memfd);
+
+	if (dma_data->devfd > 0)
+		close(dma_data->devfd);
+}
+
+/*
+ * memfd backend: plain shared memory with no cache maintenance to do. The
+ * FPGA manager cannot DMA from it, it stands in for a heap in tests and
+ * benchmarks.
+ */
+static int alloc_memfd_buffer(struct dma_buffer_info *dma_data)
+{
+	int fd;
+
+	fd = memfd_create("libdfx-heap", MFD_CLOEXEC);
+	if (fd < 0) {
+		DFX_ERR("%s: memfd_create: Failed", __func__);
+		return -1;
+	}
+
+	if (ftruncate(fd, dma_data->dma_buflen)) {
+		DFX_ERR("%s: ftruncate: Failed", __func__);
+		close(fd);
+		return -1;
+	}
+
+	dma_data->dma_buffd = fd;
+
+	return 0;
+}
+
+static int sync_memfd_buffer(struct dma_buffer_info *dma_data,
+			     unsigned long long flags)
+{
+	(void)dma_data;
+	(void)flags;
+
+	return 0;
+}
+
+static const struct dma_buffer_ops memfd_ops = {
+	.name = "memfd",
+	.alloc = alloc_memfd_buffer,
+	.map = map_dma_buffer,
+	.sync = sync_memfd_buffer,
+	.free = free_dma_buffer,
+};
+
+/* dma-heap backend: physically contiguous memory from a CMA heap */
+static int alloc_heap_buffer(struct dma_buffer_info *dma_data)
 {
 	struct dma_heap_allocation_data alloc_data_info = {
 		.len = dma_data->dma_buflen,
@@ -93,83 +193,182 @@ static int alloc_dma_buffer(struct dma_buffer_info *dma_data)
 		.fd_flags = O_RDWR | O_CLOEXEC,
 		.heap_flags = 0,
 	};
-	int ret;
+	int devfd, ret;
+
+	ret = open_device(dma_data->cma_file, &devfd);
+	if (ret)
+		return ret;
 
-	ret = ioctl(dma_data->devfd, DMA_HEAP_IOCTL_ALLOC, &alloc_data_info);
+	ret = ioctl(devfd, DMA_HEAP_IOCTL_ALLOC, &alloc_data_info);
+	/* The buffer fd keeps the allocation alive, the heap fd is done */
+	close(devfd);
 	if (ret < 0) {
-		printf("%s: DMA_HEAP_IOCTL_ALLOC: Failed\n", __func__);
+		DFX_ERR("%s: DMA_HEAP_IOCTL_ALLOC: Failed", __func__);
 		return -1;
 	}
 
-        if (alloc_data_info.fd < 0 || alloc_data_info.len <= 0) {
-                printf("%s: Invalid mmap data\n", __func__);
-                goto err;
-        }
+	if (alloc_data_info.fd <= 0 || alloc_data_info.len <= 0) {
+		DFX_ERR("%s: Invalid mmap data", __func__);
+		if (alloc_data_info.fd > 0)
+			close(alloc_data_info.fd);
+		return -1;
+	}
 
 	dma_data->dma_buffd = alloc_data_info.fd;
-        dma_data->dma_buflen = alloc_data_info.len;
+	dma_data->dma_buflen = alloc_data_info.len;
 
-        /* mapp buffer for the buffer fd */
-        dma_data->dma_buffer = (unsigned char *)mmap(NULL, dma_data->dma_buflen,
-						 PROT_READ|PROT_WRITE,
-						 MAP_SHARED,
-						 dma_data->dma_buffd, 0);
-        if (dma_data->dma_buffer == MAP_FAILED) {
-                printf("%s: mmap: Failed\n", __func__);
-                goto err;
-        }
+	return 0;
+}
 
-        return 0;
+static const struct dma_buffer_ops heap_ops = {
+	.name = "dma-heap",
+	.alloc = alloc_heap_buffer,
+	.map = map_dma_buffer,
+	.sync = sync_dmabuf_fd,
+	.free = free_dma_buffer,
+};
+
+/*
+ * udmabuf backend: a sealed memfd exported as a dmabuf by /dev/udmabuf.
+ * The pages are not contiguous, so the FPGA manager must sit behind an
+ * SMMU. udmabuf only takes whole pages, the tail of the last one stays
+ * zero.
+ */
+static int alloc_udmabuf_buffer(struct dma_buffer_info *dma_data)
+{
+	struct udmabuf_create create = { 0 };
+	char path[256];
+	long page = sysconf(_SC_PAGESIZE);
+	int devfd, fd;
+
+	fd = memfd_create("libdfx-udmabuf", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (fd < 0) {
+		DFX_ERR("%s: memfd_create: Failed", __func__);
+		return -1;
+	}
+	dma_data->memfd = fd;
+
+	create.memfd = fd;
+	create.flags = UDMABUF_FLAGS_CLOEXEC;
+	create.size = (dma_data->dma_buflen + page - 1) & ~(page - 1);
+	if (ftruncate(fd, create.size) ||
+	    fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK)) {
+		DFX_ERR("%s: Failed to size and seal memfd", __func__);
+		goto err;
+	}
 
-err:
-	if (alloc_data_info.fd)
-                close(alloc_data_info.fd);
+	snprintf(path, sizeof(path), "%s/udmabuf", dfx_root(DFX_ROOT_DEV));
+	devfd = open(path, O_RDWR | O_CLOEXEC);
+	if (devfd < 0) {
+		DFX_ERR("%s: Failed to open `%s`", __func__, path);
+		goto err;
+	}
+	fd = ioctl(devfd, UDMABUF_CREATE, &create);
+	close(devfd);
+	if (fd < 0) {
+		DFX_ERR("%s: UDMABUF_CREATE: Failed", __func__);
+		goto err;
+	}
 
+	dma_data->dma_buffd = fd;
+
+	return 0;
+
+err:
+	close(dma_data->memfd);
+	dma_data->memfd = -1;
 	return -1;
 }
 
+/* The CPU writes through the memfd, udmabuf does not fault mappings in */
+static int map_udmabuf_buffer(struct dma_buffer_info *dma_data)
+{
+	return map_fd(dma_data, dma_data->memfd);
+}
+
+static const struct dma_buffer_ops udmabuf_ops = {
+	.name = "udmabuf",
+	.alloc = alloc_udmabuf_buffer,
+	.map = map_udmabuf_buffer,
+	.sync = sync_dmabuf_fd,
+	.free = free_dma_buffer,
+};
+
+static const struct dma_buffer_ops *const backends[DMA_BUFFER_BACKEND_MAX] = {
+	[DMA_BUFFER_DMA_HEAP] = &heap_ops,
+	[DMA_BUFFER_UDMABUF] = &udmabuf_ops,
+	[DMA_BUFFER_MEMFD] = &memfd_ops,
+};
+
 int export_dma_buffer(struct dma_buffer_info *dma_data)
 {
-	int devfd, ret;
+	int ret;
 
-	if (!dma_data) {
-		printf("%s: Invalid input data\n", __func__);
+	if (!dma_data || dma_data->backend >= DMA_BUFFER_BACKEND_MAX) {
+		DFX_ERR("%s: Invalid input data", __func__);
 		return -1;
 	}
 
-	ret = open_device(dma_data->cma_file, &devfd);
-	if (ret)
-		return ret;
-
-	dma_data->devfd = devfd;
+	dma_data->ops = backends[dma_data->backend];
+	dma_data->devfd = -1;
+	dma_data->memfd = -1;
+	dma_data->dma_buffd = -1;
+	dma_data->dma_buffer = NULL;
 
-	ret = alloc_dma_buffer(dma_data);
+	DFX_PROBE1(dmabuf_alloc_entry, dma_data->dma_buflen);
+	ret = dma_data->ops->alloc(dma_data);
+	DFX_PROBE2(dmabuf_alloc_return, dma_data->dma_buflen, ret);
 	if (ret)
-		goto err;
+		return -1;
 
+	ret = dma_data->ops->map(dma_data);
+	if (ret) {
+		dma_data->ops->free(dma_data);
+		return -1;
+	}
+
+	DFX_DBG("%s: %lu bytes from %s", __func__, dma_data->dma_buflen,
+		dma_data->ops->name);
 	return 0;
+}
 
-err:
-	if (devfd)
-		close(devfd);
+int sync_dma_buffer(struct dma_buffer_info *dma_data, unsigned long long flags)
+{
+	return dma_data->ops->sync(dma_data, flags);
+}
 
-	return -1;
+long long dma_buffer_cma_free(void)
+{
+	long long free_kb = -1;
+	char line[128];
+	FILE *fp;
+
+	fp = fopen("/proc/meminfo", "r");
+	if (fp == NULL)
+		return -1;
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (sscanf(line, "CmaFree: %lld kB", &free_kb) == 1)
+			break;
+	}
+	fclose(fp);
+
+	return free_kb < 0 ? -1 : free_kb * 1024;
 }
 
 int close_dma_buffer(struct dma_buffer_info *dma_data)
 {
 	if (!dma_data) {
-		printf("%s: Invalid input data\n", __func__);
+		DFX_ERR("%s: Invalid input data", __func__);
 		return -1;
 	}
 
-	munmap(dma_data->dma_buffer, dma_data->dma_buflen);
-
-	if (dma_data->dma_buffd > 0)
+	/* Imported buffers are only referenced, see dfx_cfg_init_dmabuf() */
+	if (dma_data->is_imported) {
 		close(dma_data->dma_buffd);
+		return 0;
+	}
 
-	if (dma_data->devfd > 0)
-		close(dma_data->devfd);
+	dma_data->ops->free(dma_data);
 
 	return 0;
 }
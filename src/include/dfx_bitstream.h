@@ -0,0 +1,36 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#ifndef __DFX_BITSTREAM_H
+#define __DFX_BITSTREAM_H
+
+#include <stdio.h>
+
+#include "libdfx.h"
+
+/* Returns the image format implied by the file name extension of @path */
+enum dfx_image_format dfx_image_format(const char *path);
+
+/* Whether @data starts with the preamble of a .bit file */
+int dfx_bit_is_bit(const void *data, size_t len);
+
+/**
+ * dfx_bit_parse_header() - parse the header of a Xilinx .bit file
+ *
+ * @fp:		file positioned at its start
+ * @info:	receives the design, part, date and time fields
+ * @data_len:	receives the length of the configuration data
+ *
+ * On success @fp is left at the first byte of the configuration data.
+ *
+ * Return:	0 on success, -1 if the header is malformed
+ */
+int dfx_bit_parse_header(FILE *fp, struct dfx_package_info *info,
+			 unsigned long *data_len);
+
+/* Byte-swaps every complete 32-bit word of @buf in place */
+void dfx_bswap32_buf(void *buf, size_t len);
+
+#endif
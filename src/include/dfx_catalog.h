@@ -0,0 +1,21 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#ifndef __DFX_CATALOG_H
+#define __DFX_CATALOG_H
+
+#include "libdfx.h"
+
+/* This API scans the packages of @root, as dfx_catalog_scan() does, into
+ * an array of its own in file name order, without touching the catalog.
+ * Package folders are classified for @platform, see dfx_pkg_file_type().
+ * *entries is released with free().
+ *
+ * Return: Number of packages, or Error code on failure.
+ */
+int dfx_catalog_scan_list(const char *root, int platform,
+			  struct dfx_catalog_entry **entries);
+
+#endif
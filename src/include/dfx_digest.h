@@ -0,0 +1,49 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#ifndef __DFX_DIGEST_H
+#define __DFX_DIGEST_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define DFX_SHA256_LEN		32U
+
+struct dfx_sha256 {
+	uint32_t state[8];
+	uint64_t bytes;
+	unsigned char buf[64];
+	size_t buf_len;
+};
+
+/*
+ * CRC32C (Castagnoli) of @len bytes, continuing from @crc. Start with 0.
+ * Uses the ARMv8 CRC or SSE4.2 instructions when the CPU has them.
+ */
+uint32_t dfx_crc32c(uint32_t crc, const void *buf, size_t len);
+
+void dfx_sha256_init(struct dfx_sha256 *ctx);
+void dfx_sha256_update(struct dfx_sha256 *ctx, const void *data, size_t len);
+void dfx_sha256_final(struct dfx_sha256 *ctx, unsigned char *digest);
+
+/*
+ * Reads up to @len bytes of @fp into @dst and digests each chunk right after
+ * it lands, while it is still in the cache. With @bswap32 each chunk is
+ * byte-swapped per 32-bit word before it is digested. @sha may be NULL.
+ *
+ * Returns the number of bytes read.
+ */
+size_t dfx_digest_read(FILE *fp, void *dst, size_t len, int bswap32,
+		       uint32_t *crc, struct dfx_sha256 *sha);
+
+/*
+ * Same as dfx_digest_read(), from a mapped source such as a package
+ * container. @raw_crc, if not NULL, is continued over the bytes before
+ * they are swapped.
+ */
+void dfx_digest_copy(void *dst, const void *src, size_t len, int bswap32,
+		     uint32_t *crc, uint32_t *raw_crc, struct dfx_sha256 *sha);
+
+#endif
@@ -0,0 +1,22 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#ifndef __DFX_KTRACE_H
+#define __DFX_KTRACE_H
+
+#include "libdfx.h"
+
+/* This API starts capturing kernel events for a load. Returns non-zero if
+ * the kernel trace mode is enabled and dfx_ktrace_end() must be called.
+ */
+int dfx_ktrace_begin(void);
+
+/* This API stops capturing kernel events for a load that started at
+ * @start (CLOCK_MONOTONIC ns) and attributes the kernel-side durations
+ * seen on the calling thread to @rec.
+ */
+void dfx_ktrace_end(struct dfx_load_record *rec, unsigned long long start);
+
+#endif
@@ -0,0 +1,39 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#ifndef __DFX_LOG_H
+#define __DFX_LOG_H
+
+#include "libdfx.h"
+
+/*
+ * Most verbose level built into the library. Messages above it are removed
+ * at compile time together with their format strings. Set with
+ * -DLIBDFX_LOG_LEVEL=<ERROR|WARN|INFO|DEBUG> at configure time.
+ */
+#ifndef DFX_LOG_COMPILE_LEVEL
+#define DFX_LOG_COMPILE_LEVEL	DFX_LOG_DEBUG
+#endif
+
+/* Most verbose level passed to the sink, -1 while no sink is installed */
+extern int dfx_log_threshold;
+
+void dfx_log(enum dfx_log_level level, const char *fmt, ...)
+	__attribute__((format(printf, 2, 3)));
+
+#define DFX_LOG(level, ...)						\
+do {									\
+	if ((level) <= DFX_LOG_COMPILE_LEVEL &&				\
+	    (int)(level) <= __atomic_load_n(&dfx_log_threshold,	\
+					    __ATOMIC_RELAXED))		\
+		dfx_log(level, __VA_ARGS__);				\
+} while (0)
+
+#define DFX_ERR(...)	DFX_LOG(DFX_LOG_ERROR, __VA_ARGS__)
+#define DFX_WARN(...)	DFX_LOG(DFX_LOG_WARN, __VA_ARGS__)
+#define DFX_INFO(...)	DFX_LOG(DFX_LOG_INFO, __VA_ARGS__)
+#define DFX_DBG(...)	DFX_LOG(DFX_LOG_DEBUG, __VA_ARGS__)
+
+#endif
@@ -0,0 +1,23 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#ifndef __DFX_MGR_H
+#define __DFX_MGR_H
+
+#include <stddef.h>
+
+#define INVALID_PLATFORM	0x0U
+#define ZYNQMP_PLATFORM		0x2U
+#define VERSAL_PLATFORM		0x3U
+
+/* Writes the FPGA manager named by @devpath into @name, 0 on success */
+int dfx_fpga_mgr_name(const char *devpath, char *name, const size_t size);
+
+/* Platform of the FPGA manager named by @devpath, INVALID_PLATFORM if it
+ * cannot be told
+ */
+int dfx_fpga_mgr_platform(const char *devpath);
+
+#endif
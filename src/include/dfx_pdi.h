@@ -0,0 +1,69 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#ifndef __DFX_PDI_H
+#define __DFX_PDI_H
+
+#include <stddef.h>
+
+#include "libdfx.h"
+
+/* Sizes of the meta header tables, in bytes */
+#define PDI_IHT_LEN		0x80U
+#define PDI_IMG_HDR_LEN		0x40U
+#define PDI_PRTN_HDR_LEN	0x80U
+
+/* Where the meta header tables of a PDI are, as byte offsets into it */
+struct dfx_pdi_layout {
+	int full;		/* boot PDI, with a boot header */
+	size_t base;		/* what header addresses are relative to */
+	size_t iht;
+	size_t img_hdrs;
+	size_t prtn_hdrs;
+	unsigned int num_images;
+	unsigned int num_partitions;
+};
+
+/**
+ * dfx_pdi_locate() - locate and validate the meta header of a PDI
+ *
+ * @buf:	PDI contents, or at least everything up to the last header
+ * @len:	length of @buf
+ * @layout:	receives the table offsets
+ *
+ * Return:	0 on success, -DFX_PDI_FORMAT_ERROR if @buf is not a valid PDI
+ */
+int dfx_pdi_locate(const unsigned char *buf, size_t len,
+		   struct dfx_pdi_layout *layout);
+
+/* Decodes tables found by dfx_pdi_locate(), which may since have been copied */
+void dfx_pdi_decode(const unsigned char *iht, const unsigned char *img_hdrs,
+		    const unsigned char *prtn_hdrs,
+		    const struct dfx_pdi_layout *layout,
+		    struct dfx_pdi_meta *meta);
+
+/* dfx_pdi_locate() followed by dfx_pdi_decode(), @meta may be NULL */
+int dfx_pdi_parse(const unsigned char *buf, size_t len,
+		  struct dfx_pdi_layout *layout, struct dfx_pdi_meta *meta);
+
+/**
+ * dfx_pdi_read_file() - read the meta header of a PDI file, through the cache
+ *
+ * @path:	PDI file
+ * @meta:	receives the decoded tables, may be NULL
+ * @raw:	receives the image header table, image headers and partition
+ *		headers back to back, may be NULL
+ * @raw_size:	size of @raw
+ *
+ * Return:	length of the raw meta header on success,
+ *		negative error code otherwise
+ */
+int dfx_pdi_read_file(const char *path, struct dfx_pdi_meta *meta,
+		      void *raw, size_t raw_size);
+
+/* Drops every cached meta header */
+void dfx_pdi_cache_flush(void);
+
+#endif
@@ -0,0 +1,78 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#ifndef __DFX_PKG_H
+#define __DFX_PKG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dfx_pkg_format.h"
+#include "libdfx.h"
+
+/* Payload of a container entry, pointing into the mapping */
+struct dfx_pkg_payload {
+	const unsigned char *data;	/* NULL if the entry is absent */
+	size_t size;
+	uint32_t crc32c;
+	char name[DFX_PKG_NAME_LEN];
+};
+
+/* A mapped .dfxpkg container */
+struct dfx_pkg {
+	void *map;
+	size_t map_len;
+	char name[DFX_PKG_NAME_LEN];
+	struct dfx_pkg_payload entry[DFX_PKG_ENTRY_MAX];
+};
+
+/* Whether @path names a container rather than a package directory, by its
+ * suffix in any case
+ */
+int dfx_pkg_is_container(const char *path);
+
+/**
+ * dfx_pkg_file_type() - classify a file of a package folder by its name
+ *
+ * @name:	file name, in any case
+ * @platform:	platform of the FPGA manager, see dfx_mgr.h
+ *
+ * Images are .pdi files on Versal and .bin files elsewhere, and also .bit
+ * files on ZynqMP. With INVALID_PLATFORM any of these is an image.
+ *
+ * Return:	the DFX_PKG_ENTRY_* type of the file, 0 if it is none
+ */
+int dfx_pkg_file_type(const char *name, int platform);
+
+/**
+ * dfx_pkg_open() - map and validate a .dfxpkg container
+ *
+ * @path:	container file
+ * @pkg:	receives the mapping and its entries
+ *
+ * The image payload is only bounds-checked here, its CRC is compared while
+ * it is copied into the dmabuf. The smaller payloads are checked now.
+ *
+ * Return:	0 on success, negative error code otherwise
+ */
+int dfx_pkg_open(const char *path, struct dfx_pkg *pkg);
+
+void dfx_pkg_close(struct dfx_pkg *pkg);
+
+/**
+ * dfx_pkg_probe() - read the index of a container without mapping it
+ *
+ * @fd:		open container file
+ * @name:	receives the package name, DFX_PKG_NAME_LEN bytes
+ * @image_name:	receives the name of the image entry, empty if there is none
+ *
+ * Payloads are neither read nor checked, see dfx_pkg_open() for that.
+ *
+ * Return:	bit N set for each entry type N present, negative error code
+ *		if @fd is not a container
+ */
+int dfx_pkg_probe(int fd, char *name, char *image_name);
+
+#endif
@@ -0,0 +1,53 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#ifndef __DFX_PKG_FORMAT_H
+#define __DFX_PKG_FORMAT_H
+
+#include <stdint.h>
+
+/*
+ * Layout of the single-file .dfxpkg package container accepted by
+ * dfx_cfg_init() and written by dfx_pack.
+ *
+ * A container is a struct dfx_pkg_header followed by @num_entries struct
+ * dfx_pkg_entry, then the payloads. Every payload starts on a
+ * DFX_PKG_ALIGN boundary so that it can be mapped and copied into a
+ * dmabuf without realignment. All fields are little-endian.
+ */
+
+#define DFX_PKG_MAGIC		"DFXPKG\r\n"
+#define DFX_PKG_VERSION		1U
+#define DFX_PKG_ALIGN		4096U
+#define DFX_PKG_NAME_LEN	64U
+#define DFX_PKG_SUFFIX		".dfxpkg"
+
+enum dfx_pkg_entry_type {
+	DFX_PKG_ENTRY_IMAGE = 1,	/* .bin, .bit or .pdi image */
+	DFX_PKG_ENTRY_IMAGE_DTBO,	/* image overlay, required */
+	DFX_PKG_ENTRY_DRIVERS_DTBO,	/* driver overlay */
+	DFX_PKG_ENTRY_KEY_REF,		/* path of the .nky file, relative to
+					 * the container directory */
+	DFX_PKG_ENTRY_META,		/* "key=value\n" lines */
+	DFX_PKG_ENTRY_MAX
+};
+
+struct dfx_pkg_header {
+	char magic[8];			/* DFX_PKG_MAGIC, not terminated */
+	uint32_t version;		/* DFX_PKG_VERSION */
+	uint32_t num_entries;
+	char name[DFX_PKG_NAME_LEN];	/* package name, null-terminated */
+	uint32_t reserved[4];
+};
+
+struct dfx_pkg_entry {
+	uint32_t type;			/* enum dfx_pkg_entry_type */
+	uint32_t crc32c;		/* CRC32C of the payload */
+	uint64_t offset;		/* from the start of the container */
+	uint64_t size;
+	char name[DFX_PKG_NAME_LEN];	/* source file name, null-terminated */
+};
+
+#endif
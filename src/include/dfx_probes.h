@@ -0,0 +1,36 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#ifndef __DFX_PROBES_H
+#define __DFX_PROBES_H
+
+/*
+ * USDT probes under the "libdfx" provider. With <sys/sdt.h> available each
+ * probe site compiles to a single NOP plus an ELF note, which perf, bpftrace
+ * and SystemTap patch only while a probe is attached, e.g.:
+ *
+ *	bpftrace -e 'usdt:/usr/lib/libdfx.so.1:libdfx:cfg_load_return
+ *		     { printf("%d -> %d\n", arg0, arg1); }'
+ *
+ * Without <sys/sdt.h>, or with ENABLE_LIBDFX_USDT off, they compile away.
+ */
+#if defined(ENABLE_LIBDFX_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define DFX_HAVE_USDT	1
+#endif
+#endif
+
+#ifdef DFX_HAVE_USDT
+#define DFX_PROBE1(name, a1)		DTRACE_PROBE1(libdfx, name, a1)
+#define DFX_PROBE2(name, a1, a2)	DTRACE_PROBE2(libdfx, name, a1, a2)
+#define DFX_PROBE3(name, a1, a2, a3)	DTRACE_PROBE3(libdfx, name, a1, a2, a3)
+#else
+#define DFX_PROBE1(name, a1)		do { } while (0)
+#define DFX_PROBE2(name, a1, a2)	do { } while (0)
+#define DFX_PROBE3(name, a1, a2, a3)	do { } while (0)
+#endif
+
+#endif
@@ -0,0 +1,17 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#ifndef __DFX_ROOT_H
+#define __DFX_ROOT_H
+
+#include "libdfx.h"
+
+/* Returns the current path of @root, see dfx_set_root() */
+const char *dfx_root(enum dfx_root root);
+
+/* Returns non-zero if @root has been redirected away from its default */
+int dfx_root_redirected(enum dfx_root root);
+
+#endif
@@ -0,0 +1,67 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#ifndef __DFX_STATS_H
+#define __DFX_STATS_H
+
+#include "libdfx.h"
+
+#define DFX_STATS_RING_LEN	8U
+
+/* Last DFX_STATS_RING_LEN durations of an event, the oldest overwritten */
+struct dfx_stats_ring {
+	unsigned long long ns[DFX_STATS_RING_LEN];
+	unsigned int count;	/* valid entries */
+	unsigned int next;	/* slot of the next entry */
+};
+
+/* Returns the CLOCK_MONOTONIC time in nanoseconds */
+unsigned long long dfx_stats_now(void);
+
+/* This API adds the time elapsed since @start to @phase of @rec and
+ * returns the current time, so consecutive phases can be chained.
+ */
+unsigned long long dfx_stats_phase_end(struct dfx_load_record *rec,
+				       enum dfx_phase phase,
+				       unsigned long long start);
+
+/* This API folds a finished init (@is_load false) or load (@is_load true)
+ * record into the global statistics and, if @pkg_stats is not NULL, into
+ * the statistics of the package.
+ */
+void dfx_stats_commit(struct dfx_stats *pkg_stats,
+		      const struct dfx_load_record *rec, int is_load);
+
+/* This API records a single phase outside of an init or load call */
+void dfx_stats_record(struct dfx_stats *pkg_stats, enum dfx_phase phase,
+		      unsigned long long ns);
+
+/* This API adjusts the allocated dmabuf byte count by @delta */
+void dfx_stats_cma(struct dfx_stats *pkg_stats, long long delta);
+
+/* This API counts a DFX_LOAD_AUTO package moved to a dmabuf */
+void dfx_stats_promote(struct dfx_stats *pkg_stats);
+
+/* This API counts a timed load that missed its deadline */
+void dfx_stats_deadline_miss(struct dfx_stats *pkg_stats);
+
+/* This API copies @pkg_stats, or the global statistics if NULL, into
+ * @stats under the statistics lock.
+ */
+void dfx_stats_copy(const struct dfx_stats *pkg_stats, struct dfx_stats *stats);
+
+/* This API adds @ns to @ring under the statistics lock */
+void dfx_stats_ring_add(struct dfx_stats_ring *ring, unsigned long long ns);
+
+/* This API empties @ring under the statistics lock */
+void dfx_stats_ring_reset(struct dfx_stats_ring *ring);
+
+/* This API returns the median of @ring, or 0 while it holds fewer than
+ * @min_count durations.
+ */
+unsigned long long dfx_stats_ring_median(const struct dfx_stats_ring *ring,
+					 unsigned int min_count);
+
+#endif
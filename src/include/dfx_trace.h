@@ -0,0 +1,47 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#ifndef __DFX_TRACE_H
+#define __DFX_TRACE_H
+
+#include "dfx_stats.h"
+#include "dfx_trace_format.h"
+
+extern int dfx_trace_enabled;
+
+/* Returns the call start time while the recorder runs, 0 otherwise */
+static inline unsigned long long dfx_trace_begin(void)
+{
+	if (!__atomic_load_n(&dfx_trace_enabled, __ATOMIC_RELAXED))
+		return 0;
+
+	return dfx_stats_now();
+}
+
+/* This API appends a finished call to the ring buffer of the calling
+ * thread. It never blocks; the record is dropped if the ring is full.
+ */
+void dfx_trace_call(enum dfx_trace_op op, unsigned long long start,
+		    int package_id, int result, unsigned long flags,
+		    int nstr, const char *const *strs);
+
+#define DFX_TRACE_CALL(op, start, package_id, result, flags)		\
+do {									\
+	if (start)							\
+		dfx_trace_call(op, start, package_id, result, flags,	\
+			       0, NULL);				\
+} while (0)
+
+#define DFX_TRACE_CALL_STR(op, start, package_id, result, flags, ...)	\
+do {									\
+	if (start) {							\
+		const char *const __strs[] = { __VA_ARGS__ };		\
+		dfx_trace_call(op, start, package_id, result, flags,	\
+			       sizeof(__strs) / sizeof(__strs[0]),	\
+			       __strs);					\
+	}								\
+} while (0)
+
+#endif
@@ -0,0 +1,75 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#ifndef __DFX_TRACE_FORMAT_H
+#define __DFX_TRACE_FORMAT_H
+
+#include <stdint.h>
+
+/*
+ * Binary format of the API call traces written by dfx_trace_start().
+ *
+ * A trace is a struct dfx_trace_file_header followed by a stream of
+ * records. Every record starts with a struct dfx_trace_record and is
+ * followed by @nstr null-terminated strings, padded with zeroes to a
+ * multiple of DFX_TRACE_ALIGN bytes; @size covers all of it. All fields
+ * are in the byte order of the recording host, which readers detect with
+ * @byte_order.
+ */
+
+#define DFX_TRACE_MAGIC		"DFXTRACE"
+#define DFX_TRACE_VERSION	1U
+#define DFX_TRACE_BYTE_ORDER	0x01020304U
+#define DFX_TRACE_ALIGN		8U
+#define DFX_TRACE_MAX_STRS	8U
+
+enum dfx_trace_op {
+	DFX_TRACE_OP_PAD = 0,		/* filler, skip @size bytes */
+	DFX_TRACE_OP_CFG_INIT,		/* path, devpath, cma_file */
+	DFX_TRACE_OP_CFG_INIT_FILE,	/* bin, dtbo, driver dtbo, aes key,
+					 * devpath, cma_file */
+	DFX_TRACE_OP_CFG_LOAD,
+	DFX_TRACE_OP_CFG_DRIVERS_LOAD,
+	DFX_TRACE_OP_CFG_REMOVE,
+	DFX_TRACE_OP_CFG_DESTROY,
+	DFX_TRACE_OP_GET_ACTIVE_UID_LIST, /* @flags holds buf_size, 0 if
+					   * none was given */
+	DFX_TRACE_OP_GET_META_HEADER,	/* binfile, @flags holds buf_size */
+	DFX_TRACE_OP_DROPPED,		/* @result records were lost because
+					 * the ring of thread @tid was full */
+	DFX_TRACE_OP_CFG_INIT_MEM,	/* devpath, cma_file, then the image,
+					 * overlay and drivers overlay lengths
+					 * in decimal; the data is not kept */
+	DFX_TRACE_OP_CFG_INIT_DMABUF,	/* dtbo, driver dtbo, aes key, devpath,
+					 * image length in decimal */
+	DFX_TRACE_OP_CFG_LOAD_TIMED,	/* deadline minus @start_ns in decimal
+					 * ns, negative if already passed */
+	DFX_TRACE_OP_CFG_HINT,		/* @flags holds expected_ms */
+	DFX_TRACE_OP_MAX
+};
+
+struct dfx_trace_file_header {
+	char magic[8];			/* DFX_TRACE_MAGIC, not terminated */
+	uint32_t byte_order;		/* DFX_TRACE_BYTE_ORDER */
+	uint32_t version;		/* DFX_TRACE_VERSION */
+	uint64_t start_ns;		/* CLOCK_MONOTONIC at dfx_trace_start() */
+	uint64_t realtime_ns;		/* CLOCK_REALTIME at dfx_trace_start() */
+};
+
+struct dfx_trace_record {
+	uint16_t size;			/* record size including the strings */
+	uint8_t op;			/* enum dfx_trace_op */
+	uint8_t nstr;			/* number of strings that follow */
+	uint8_t null_mask;		/* bit N set if string N was NULL */
+	uint8_t reserved[3];
+	uint32_t tid;			/* calling thread */
+	int32_t package_id;		/* package argument, 0 if none */
+	int32_t result;			/* return value of the call */
+	uint32_t flags;			/* flags argument */
+	uint64_t start_ns;		/* CLOCK_MONOTONIC at call entry */
+	uint64_t duration_ns;
+};
+
+#endif
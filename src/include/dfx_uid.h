@@ -0,0 +1,77 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#ifndef __DFX_UID_H
+#define __DFX_UID_H
+
+#include <stddef.h>
+
+#include "libdfx.h"
+
+/* Fields of a dfx_uid_node that can be looked up */
+enum dfx_uid_key {
+	DFX_UID_KEY_UID = 0,
+	DFX_UID_KEY_NODE_ID,
+	DFX_UID_KEY_FUNCTION_ID,
+	DFX_UID_KEY_MAX
+};
+
+/*
+ * Active UID tree built from the firmware's flat {Node ID, UID, Parent UID,
+ * Function ID} list, with one open-addressed hash table per lookup key.
+ */
+struct dfx_uid_index {
+	struct dfx_uid_node *nodes;
+	int count;
+	unsigned int bits;		/* log2 of the hash table size */
+	int *table[DFX_UID_KEY_MAX];	/* node index + 1, 0 for a free slot */
+};
+
+/* UID and parent UID of an image of a package */
+struct dfx_uid_pair {
+	unsigned int uid;
+	unsigned int parent_uid;
+};
+
+/**
+ * dfx_uid_index_build() - (re)build an index from a firmware UID list
+ *
+ * @index:	index to fill, its previous contents are released
+ * @tuples:	the list as returned by uid-read
+ * @len:	length of @tuples in bytes
+ *
+ * Entries with a zero UID are unused node slots and are left out.
+ *
+ * Return:	0 on success, -DFX_INSUFFICIENT_MEM on allocation failure
+ */
+int dfx_uid_index_build(struct dfx_uid_index *index, const int *tuples,
+			size_t len);
+
+void dfx_uid_index_free(struct dfx_uid_index *index);
+
+/*
+ * Returns the first node whose @key field equals @value, or NULL. For
+ * DFX_UID_KEY_FUNCTION_ID several nodes may match.
+ */
+const struct dfx_uid_node *dfx_uid_index_find(const struct dfx_uid_index *index,
+					      enum dfx_uid_key key,
+					      unsigned int value);
+
+/**
+ * dfx_uid_index_check() - match the images of a package against the index
+ *
+ * @index:	active UID tree
+ * @pairs:	UIDs of the images of the package
+ * @count:	number of entries in @pairs
+ *
+ * Return:	1 if every image is already active,
+ *		0 if the package can be loaded: each image that is not active
+ *		  has no parent, an active parent or a parent in the package,
+ *		-DFX_UID_PARENT_ERROR otherwise
+ */
+int dfx_uid_index_check(const struct dfx_uid_index *index,
+			const struct dfx_uid_pair *pairs, int count);
+
+#endif
@@ -0,0 +1,28 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+#ifndef __DFX_WATCH_H
+#define __DFX_WATCH_H
+
+#include "libdfx.h"
+
+/* Number of open watches, nothing is queued while it is 0 */
+extern int dfx_watch_count;
+
+/* This API queues an event of a library call to the watches of @mgr_name
+ * and wakes them up. A watch whose queue is full drops the event and
+ * reports DFX_WATCH_OVERFLOW instead.
+ */
+void dfx_watch_notify(enum dfx_watch_type type, const char *mgr_name,
+		      int package_id, int result);
+
+#define DFX_WATCH_NOTIFY(type, mgr_name, package_id, result)		\
+do {									\
+	if (__atomic_load_n(&dfx_watch_count, __ATOMIC_RELAXED) &&	\
+	    (mgr_name) != NULL)						\
+		dfx_watch_notify(type, mgr_name, package_id, result);	\
+} while (0)
+
+#endif
@@ -11,22 +11,58 @@
 #ifndef __DMABUF_ALLOC_H
 #define __DMABUF_ALLOC_H
 
+/* Where the image buffer comes from, selected per package */
+enum dma_buffer_backend {
+	DMA_BUFFER_DMA_HEAP = 0,	/* contiguous CMA heap, the default */
+	DMA_BUFFER_UDMABUF,		/* memfd exported by /dev/udmabuf */
+	DMA_BUFFER_MEMFD,		/* plain memfd, tests only */
+	DMA_BUFFER_BACKEND_MAX
+};
+
+struct dma_buffer_info;
+
+/*
+ * Operations of a buffer backend. alloc() sets dma_buffd, the fd handed to
+ * the FPGA manager, map() sets dma_buffer. free() releases whatever the
+ * two set up, also after a failed map().
+ */
+struct dma_buffer_ops {
+	const char *name;
+	int (*alloc)(struct dma_buffer_info *dma_data);
+	int (*map)(struct dma_buffer_info *dma_data);
+	int (*sync)(struct dma_buffer_info *dma_data, unsigned long long flags);
+	void (*free)(struct dma_buffer_info *dma_data);
+};
+
 struct dma_buffer_info {
 	int devfd;
 	int dma_buffd;
+	int memfd;		/* memory behind a udmabuf, -1 otherwise */
 	const char *cma_file;
 	unsigned char *dma_buffer;
 	unsigned long dma_buflen;
+	enum dma_buffer_backend backend;
+	const struct dma_buffer_ops *ops;
+	int is_imported;	/* dma_buffd was given by the user, not mapped */
 };
 
-
-/* This API is used to allocate dmaable memory in the kernel
- * and export to others
+/* This API is used to allocate dmaable memory from the backend selected
+ * by dma_data->backend and export to others
  */
 int export_dma_buffer(struct dma_buffer_info *dma_data);
 
+/* This API is used to synchronize CPU access to the buffer, see
+ * DMA_BUF_IOCTL_SYNC. It is a no-op for memfd backed buffers.
+ */
+int sync_dma_buffer(struct dma_buffer_info *dma_data, unsigned long long flags);
+
+/* This API returns the free CMA in bytes (CmaFree of /proc/meminfo), or -1
+ * if the kernel does not report it.
+ */
+long long dma_buffer_cma_free(void);
+
 /* This API is used to close all references related to dmaable
- * memory allocated by the dma_heap.
+ * memory allocated by the backend. Imported buffers are only closed.
  */
 int close_dma_buffer(struct dma_buffer_info *dma_data);
 
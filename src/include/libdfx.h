@@ -7,10 +7,64 @@
 #ifndef __LIBDFX_H
 #define __LIBDFX_H
 
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #define DFX_NORMAL_EN			(0x00000000U)
 #define DFX_EXTERNAL_CONFIG_EN		(0x00000001U)
 #define DFX_ENCRYPTION_USERKEY_EN	(0x00000020U)
 
+/*
+ * Library-only flags, never passed to the FPGA manager.
+ * DFX_DIGEST_SHA256_EN: also compute a SHA-256 of the image while it is
+ *			 copied into the dmabuf (a CRC32C is always computed).
+ * DFX_VERIFY_ON_LOAD_EN: re-check the dmabuf against the digest before it
+ *			  is handed to the FPGA manager.
+ * DFX_UID_SKIP_ACTIVE_EN: make dfx_cfg_load() a no-op if every image UID of
+ *			   the PDI is already active.
+ * DFX_UID_CHECK_PARENT_EN: fail dfx_cfg_load() with DFX_UID_PARENT_ERROR if
+ *			    the parent of an image of the PDI is not active.
+ */
+#define DFX_DIGEST_SHA256_EN		(0x00010000U)
+#define DFX_VERIFY_ON_LOAD_EN		(0x00020000U)
+#define DFX_UID_SKIP_ACTIVE_EN		(0x00040000U)
+#define DFX_UID_CHECK_PARENT_EN		(0x00080000U)
+#define DFX_LIBRARY_FLAGS_MASK		(0xFFFF0000U)
+
+/*
+ * Backend of the image buffer, a library-only field of the flags.
+ * DFX_BUFFER_DMA_HEAP: contiguous buffer from a CMA dma-heap (default).
+ * DFX_BUFFER_UDMABUF: memfd turned into a dmabuf by /dev/udmabuf, no CMA
+ *		       used; the FPGA manager must sit behind an SMMU.
+ * DFX_BUFFER_MEMFD: plain memfd the FPGA manager cannot DMA from, for
+ *		     tests and benchmarks. dfx_cfg_load() does not hand it
+ *		     to the FPGA manager.
+ */
+#define DFX_BUFFER_DMA_HEAP		(0x00000000U)
+#define DFX_BUFFER_UDMABUF		(0x00100000U)
+#define DFX_BUFFER_MEMFD		(0x00200000U)
+#define DFX_BUFFER_MASK			(0x00300000U)
+
+/*
+ * Load strategy, a library-only field of the flags.
+ * DFX_LOAD_PRELOAD: copy the image into a dmabuf at init (default).
+ * DFX_LOAD_FIRMWARE: allocate nothing, the kernel firmware loader reads
+ *		      the image file when the overlay is applied.
+ * DFX_LOAD_AUTO: use the firmware loader for small images or when CMA is
+ *		  short, and move to a dmabuf once the package turns out to
+ *		  be loaded often or slowly.
+ * Only image files in .bin or .pdi format can go through the firmware
+ * loader; DFX_LOAD_AUTO preloads anything else. Any other value of the
+ * field fails the init with DFX_INVALID_PARAM.
+ */
+#define DFX_LOAD_PRELOAD		(0x00000000U)
+#define DFX_LOAD_FIRMWARE		(0x00400000U)
+#define DFX_LOAD_AUTO			(0x00800000U)
+#define DFX_LOAD_MASK			(0x00C00000U)
+
 /* Error codes */
 #define DFX_INVALID_PLATFORM_ERROR		(0x1U)
 #define DFX_CREATE_PACKAGE_ERROR		(0x2U)
@@ -31,6 +85,14 @@
 #define DFX_INVALID_PARAM			(0x11U)
 #define DFX_DUPLICATE_DRIVERS_DTBO_ERROR	(0x12U)
 #define DFX_DUPLICATE_AES_KEY_ERROR		(0x13U)
+#define DFX_KTRACE_ERROR			(0x14U)
+#define DFX_TRACE_ERROR				(0x15U)
+#define DFX_IMAGE_DIGEST_ERROR			(0x16U)
+#define DFX_PDI_FORMAT_ERROR			(0x17U)
+#define DFX_UID_NOT_FOUND_ERROR			(0x18U)
+#define DFX_UID_PARENT_ERROR			(0x19U)
+#define DFX_PACKAGE_NOT_FOUND_ERROR		(0x1AU)
+#define DFX_LOAD_DEADLINE_ERROR			(0x1BU)
 
 /* XILFPGA/PMUFW Error Codes */
 #define XFPGA_ERROR_CSUDMA_INIT_FAIL		(0x2U)
@@ -71,19 +133,267 @@
 #define XFPGA_OPS_NOT_IMPLEMENTED       (0x6U)
 #define XFPGA_INVALID_PARAM             (0x8U)
 
+/* Phases timed by the statistics API */
+enum dfx_phase {
+	DFX_PHASE_FILE_OPEN = 0,	/* open the image file */
+	DFX_PHASE_CMA_ALLOC,		/* allocate and map the dmabuf */
+	DFX_PHASE_COPY,			/* copy the image into the dmabuf */
+	DFX_PHASE_SYNC,			/* dmabuf cache synchronization */
+	DFX_PHASE_IOCTL,		/* hand the dmabuf to the FPGA manager */
+	DFX_PHASE_OVERLAY_MKDIR,	/* create the configfs overlay dir */
+	DFX_PHASE_OVERLAY_APPLY,	/* write the overlay path */
+	DFX_PHASE_STATE_CHECK,		/* FPGA state and overlay readback */
+	DFX_PHASE_TEARDOWN,		/* overlay removal and buffer release */
+	DFX_PHASE_VERIFY,		/* dmabuf digest check before the load */
+	DFX_PHASE_INIT,			/* whole dfx_cfg_init*() call */
+	DFX_PHASE_LOAD,			/* whole dfx_cfg_load() call */
+	DFX_PHASE_MAX
+};
+
+/*
+ * Log-scale latency histogram: bucket 0 counts durations below 1us, bucket
+ * N (N > 0) counts durations in [2^(N-1), 2^N) us. The last bucket also
+ * counts everything above its upper bound.
+ */
+#define DFX_STATS_HIST_BUCKETS	32
+
+struct dfx_phase_stats {
+	unsigned long long count;
+	unsigned long long total_ns;
+	unsigned long long min_ns;
+	unsigned long long max_ns;
+	unsigned long long hist[DFX_STATS_HIST_BUCKETS];
+};
+
+/* Kernel-side phases attributed by the kernel trace mode */
+enum dfx_kphase {
+	DFX_KPHASE_FIRMWARE = 0,	/* firmware loader (_request_firmware) */
+	DFX_KPHASE_FPGA_MGR_LOAD,	/* FPGA manager write (fpga_mgr_load) */
+	DFX_KPHASE_OVERLAY_APPLY,	/* overlay apply and driver probe
+					 * (of_overlay_fdt_apply) */
+	DFX_KPHASE_MAX
+};
+
+/* How a load handed the image to the FPGA manager */
+enum dfx_load_path {
+	DFX_LOAD_PATH_DMABUF = 0,	/* dmabuf filled at init */
+	DFX_LOAD_PATH_FIRMWARE,		/* kernel firmware loader */
+	DFX_LOAD_PATH_MAX
+};
+
+/* Durations of a single init or load call */
+struct dfx_load_record {
+	unsigned int phase_mask;	/* bit N set if phase N ran */
+	unsigned long long phase_ns[DFX_PHASE_MAX];
+	unsigned int kphase_mask;	/* bit N set if kernel phase N was seen */
+	unsigned long long kphase_ns[DFX_KPHASE_MAX];
+	int fw_error;			/* error read back from the FPGA manager */
+	int result;
+	int load_path;			/* enum dfx_load_path, -1 if none */
+};
+
+/* Event types of dfx_watch_read() */
+enum dfx_watch_type {
+	DFX_WATCH_FPGA_STATE = 0,	/* state attribute of the manager changed */
+	DFX_WATCH_OVERLAY_ADDED,	/* overlay directory created in configfs */
+	DFX_WATCH_OVERLAY_REMOVED,	/* overlay directory removed from configfs */
+	DFX_WATCH_LOAD,			/* dfx_cfg_load() of this process returned */
+	DFX_WATCH_REMOVE,		/* dfx_cfg_remove() of this process returned */
+	DFX_WATCH_OVERFLOW,		/* events were dropped, always reported */
+	DFX_WATCH_MAX
+};
+
+/* Mask of dfx_watch_open() selecting every event type */
+#define DFX_WATCH_ALL		((1U << DFX_WATCH_MAX) - 1)
+#define DFX_WATCH_NAME_LEN	64
+
+struct dfx_watch_event {
+	unsigned int type;		/* enum dfx_watch_type */
+	int package_id;			/* DFX_WATCH_LOAD and DFX_WATCH_REMOVE */
+	int result;			/* return value of the call */
+	unsigned long long time_ns;	/* CLOCK_MONOTONIC, when it was seen */
+	char name[DFX_WATCH_NAME_LEN];	/* new state, or overlay directory */
+};
+
+/* Size of the per error code failure counters */
+#define DFX_STATS_ERR_CODES	32
+
+struct dfx_stats {
+	unsigned long long init_count;
+	unsigned long long load_count;
+	unsigned long long load_fail_count;
+	/* failed loads by DFX_* error code */
+	unsigned long long load_fail_dfx[DFX_STATS_ERR_CODES];
+	/* failed image configurations by XFPGA_ERROR_* code */
+	unsigned long long load_fail_fw[DFX_STATS_ERR_CODES];
+	unsigned long long cma_bytes;	/* dmabuf bytes currently allocated */
+	struct dfx_phase_stats phase[DFX_PHASE_MAX];
+	struct dfx_load_record last_load;
+	/* loads by enum dfx_load_path */
+	unsigned long long load_path_count[DFX_LOAD_PATH_MAX];
+	/* DFX_LOAD_AUTO packages moved to a dmabuf after init */
+	unsigned long long promote_count;
+	/* dfx_cfg_load_timed() calls refused or timed out at their deadline */
+	unsigned long long deadline_miss_count;
+};
+
+/* Kernel interfaces that can be redirected with dfx_set_root() */
+enum dfx_root {
+	DFX_ROOT_FPGA_MGR = 0,		/* /sys/class/fpga_manager */
+	DFX_ROOT_DEV,			/* /dev, holding the fpgaN nodes */
+	DFX_ROOT_OVERLAYS,		/* configfs device-tree overlays */
+	DFX_ROOT_DMA_HEAP,		/* /dev/dma_heap */
+	DFX_ROOT_DEVICETREE,		/* /sys/firmware/devicetree/base */
+	DFX_ROOT_FW_SEARCH_PATH,	/* firmware_class path parameter */
+	DFX_ROOT_VERSAL_FW,		/* versal-firmware platform device */
+	DFX_ROOT_MAX
+};
+
+/* Digest of the image copied into the dmabuf of a package */
+struct dfx_package_digest {
+	unsigned long long length;	/* image bytes covered, 0 if no dmabuf */
+	unsigned int crc32c;
+	int has_sha256;			/* set with DFX_DIGEST_SHA256_EN */
+	unsigned char sha256[32];
+};
+
+/* Image file formats */
+enum dfx_image_format {
+	DFX_IMAGE_UNKNOWN = 0,
+	DFX_IMAGE_BIN,			/* raw configuration data */
+	DFX_IMAGE_BIT,			/* Vivado .bit, header + big-endian data */
+	DFX_IMAGE_PDI,			/* Versal programmable device image */
+};
+
+/* Image metadata, the text fields are only filled in for .bit files */
+struct dfx_package_info {
+	enum dfx_image_format format;
+	unsigned long long image_size;	/* bytes handed to the FPGA manager */
+	unsigned long long header_size;	/* .bit header bytes stripped */
+	char design[128];		/* design name */
+	char tool_version[32];		/* Vivado version */
+	unsigned int user_id;		/* USR_ACCESS/UserID value */
+	char part[32];			/* target part, e.g. xczu9eg-ffvb1156-2-e */
+	char date[16];			/* build date, yyyy/mm/dd */
+	char time[16];			/* build time, hh:mm:ss */
+};
+
+/* Versal PDI meta header, see dfx_get_pdi_meta() */
+#define DFX_PDI_MAX_IMAGES	32
+#define DFX_PDI_MAX_PARTITIONS	64
+
+struct dfx_pdi_image {
+	char name[20];			/* image name, NUL terminated */
+	unsigned int id;		/* node id */
+	unsigned int uid;		/* unique id */
+	unsigned int parent_uid;	/* unique id of the parent image */
+	unsigned int function_id;
+	unsigned int attributes;
+	unsigned int first_partition;	/* index into partitions[] */
+	unsigned int num_partitions;
+};
+
+struct dfx_pdi_partition {
+	unsigned int id;
+	unsigned int attributes;
+	unsigned long long load_address;
+	unsigned long long exec_address;
+	unsigned long long data_offset;	/* bytes from the start of the PDI */
+	unsigned long long data_size;	/* stored size in bytes */
+	unsigned long long plain_size;	/* unencrypted size in bytes */
+};
+
+struct dfx_pdi_meta {
+	int full;			/* boot PDI, with a boot header */
+	unsigned int version;
+	unsigned int id_code;		/* target device IDCODE */
+	unsigned int attributes;
+	unsigned int pdi_id;
+	unsigned int num_images;	/* may exceed DFX_PDI_MAX_IMAGES */
+	unsigned int num_partitions;	/* may exceed DFX_PDI_MAX_PARTITIONS */
+	struct dfx_pdi_image images[DFX_PDI_MAX_IMAGES];
+	struct dfx_pdi_partition partitions[DFX_PDI_MAX_PARTITIONS];
+};
+
+/*
+ * Entry of the active UID tree, see dfx_uid_tree(). The parent, first_child
+ * and next_sibling links index the array filled by dfx_uid_tree(), -1 ends
+ * them.
+ */
+struct dfx_uid_node {
+	unsigned int node_id;		/* region (image node) it occupies */
+	unsigned int uid;
+	unsigned int parent_uid;
+	unsigned int function_id;
+	int parent;
+	int first_child;
+	int next_sibling;
+};
+
+/* Package of a library root, see dfx_catalog_scan() */
+#define DFX_CATALOG_NAME_LEN	64
+#define DFX_CATALOG_PATH_LEN	512
+
+#define DFX_CATALOG_CONTAINER		(0x1U)	/* .dfxpkg file, not a folder */
+#define DFX_CATALOG_DRIVERS_DTBO	(0x2U)	/* has a driver overlay */
+#define DFX_CATALOG_AES_KEY		(0x4U)	/* has a .nky file or reference */
+
+struct dfx_catalog_entry {
+	char name[DFX_CATALOG_NAME_LEN];
+	char path[DFX_CATALOG_PATH_LEN];	/* to pass to dfx_cfg_init() */
+	enum dfx_image_format format;
+	unsigned int flags;			/* DFX_CATALOG_* */
+};
+
+/* Outcome of dfx_cfg_init_dir() for one package */
+struct dfx_init_result {
+	char name[DFX_CATALOG_NAME_LEN];
+	int package_id;			/* or negative error code */
+};
+
+/* Log levels, in decreasing order of severity */
+enum dfx_log_level {
+	DFX_LOG_ERROR = 0,
+	DFX_LOG_WARN,
+	DFX_LOG_INFO,
+	DFX_LOG_DEBUG,
+};
+
+/*
+ * Log sink. @msg is a single formatted line without the trailing newline;
+ * it is only valid for the duration of the call.
+ */
+typedef void (*dfx_log_sink_t)(enum dfx_log_level level, const char *msg,
+			       void *arg);
 
 int dfx_cfg_init(const char *dfx_package_path,
 		 const char *devpath, unsigned long flags,
 		 ...);
+int dfx_cfg_init_dir(const char *root, const char *devpath,
+		     unsigned long flags, struct dfx_init_result **results,
+		     int *count);
 int dfx_cfg_load(int package_id);
+int dfx_cfg_load_timed(int package_id, unsigned long long deadline_ns);
 int dfx_cfg_drivers_load(int package_id);
 int dfx_cfg_remove(int package_id);
 int dfx_cfg_destroy(int package_id);
+int dfx_cfg_hint(int package_id, unsigned int expected_ms);
+int dfx_set_prefetch_budget(size_t bytes);
 int dfx_get_active_uid_list(int *buffer);
+int dfx_get_active_uid_list_buf(int *buffer, size_t buf_size);
+void dfx_invalidate_cache(void);
 int dfx_get_meta_header(char *binfile, int *buffer, int buf_size);
 int dfx_cfg_init_file(const char *dfx_bin_file, const char *dfx_dtbo_file,
 		      const char *dfx_driver_dtbo_file, const char *dfx_aes_key_file,
 		      const char *devpath, unsigned long flags, ...);
+int dfx_cfg_init_mem(const void *image, size_t image_len,
+		     const void *dtbo, size_t dtbo_len,
+		     const void *drv_dtbo, size_t drv_dtbo_len,
+		     const char *devpath, unsigned long flags, ...);
+int dfx_cfg_init_dmabuf(int dmabuf_fd, size_t len, const char *dfx_dtbo_file,
+			const char *dfx_driver_dtbo_file,
+			const char *dfx_aes_key_file, const char *devpath,
+			unsigned long flags);
 int dfx_set_firmware_search_path(const char* file_path);
 int dfx_get_fpga_state(char* buffer, size_t buf_size);
 int dfx_set_overlay_path(const char *overlay_dir, const char *requested_path);
@@ -92,4 +402,43 @@ int dfx_set_fpga_flags(int flags);
 int dfx_set_fpga_key(const char * key);
 int dfx_get_overlay_path(const char *overlay_dir, char *buffer, size_t buf_size);
 int dfx_get_overlay_status(const char *overlay_dir, char *buffer, size_t buf_size);
+int dfx_get_stats(int package_id, struct dfx_stats *stats);
+unsigned long long dfx_stats_percentile(const struct dfx_phase_stats *phase_stats,
+					double percentile);
+int dfx_ktrace_enable(const char *tracefs_root);
+int dfx_ktrace_disable(void);
+int dfx_metrics_render(char *buffer, size_t buf_size);
+int dfx_metrics_file_start(const char *path, unsigned int interval_ms);
+int dfx_metrics_file_stop(void);
+int dfx_set_root(enum dfx_root root, const char *path);
+int dfx_trace_start(const char *path);
+int dfx_trace_stop(void);
+void dfx_set_log_sink(dfx_log_sink_t sink, void *arg);
+void dfx_set_log_level(enum dfx_log_level level);
+void dfx_log_stderr_sink(enum dfx_log_level level, const char *msg, void *arg);
+int dfx_watch_open(const char *devpath, unsigned int events);
+int dfx_watch_read(int fd, struct dfx_watch_event *events, int max_events);
+int dfx_watch_close(int fd);
+int dfx_get_package_digest(int package_id, struct dfx_package_digest *digest);
+int dfx_get_package_info(int package_id, struct dfx_package_info *info);
+int dfx_get_package_meta(int package_id, char *buffer, size_t buf_size);
+int dfx_get_pdi_meta(const char *pdi_file, struct dfx_pdi_meta *meta);
+int dfx_get_package_pdi_meta(int package_id, struct dfx_pdi_meta *meta);
+int dfx_uid_tree(struct dfx_uid_node *nodes, int max_nodes);
+int dfx_uid_find(unsigned int uid, struct dfx_uid_node *node);
+int dfx_uid_find_function(unsigned int function_id, struct dfx_uid_node *node);
+int dfx_uid_find_region(unsigned int node_id, struct dfx_uid_node *node);
+int dfx_package_uid_check(int package_id);
+int dfx_catalog_scan(const char *root, const char *cache_file);
+int dfx_catalog_find(const char *name, enum dfx_image_format format,
+		     struct dfx_catalog_entry *entry);
+int dfx_catalog_list(struct dfx_catalog_entry *entries, int max_entries);
+int dfx_catalog_init(const char *name, enum dfx_image_format format,
+		     const char *devpath, unsigned long flags);
+void dfx_catalog_free(void);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
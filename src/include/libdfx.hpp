@@ -0,0 +1,429 @@
+/***************************************************************
+ * Copyright (C) 2026, Advanced Micro Devices, Inc. All Rights Reserved
+ * SPDX-License-Identifier: MIT
+ ***************************************************************/
+
+/*
+ * Header-only C++20 layer over libdfx.h.
+ *
+ * dfx::Package owns a package_id and destroys it, dfx::Overlay owns a
+ * loaded package and removes its overlays. Both are move-only. Calls return
+ * dfx::Result<T>, std::expected<T, dfx::Error> where the standard library
+ * has it, and a class with the same interface otherwise.
+ *
+ * Path arguments are std::string_view. They are copied into a stack buffer
+ * to terminate them, nothing here allocates beyond what the C calls do.
+ */
+
+#ifndef __LIBDFX_HPP
+#define __LIBDFX_HPP
+
+#if __cplusplus < 202002L
+#error "libdfx.hpp needs C++20"
+#endif
+
+#include <coroutine>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#if __has_include(<expected>)
+#include <expected>
+#endif
+
+#include "libdfx.h"
+
+namespace dfx {
+
+/* A DFX_* error code, as returned negated by the C API */
+class Error {
+public:
+	constexpr explicit Error(int code) noexcept : code_(code) {}
+
+	constexpr int code() const noexcept { return code_; }
+
+	friend constexpr bool operator==(Error, Error) = default;
+
+private:
+	int code_;
+};
+
+#if defined(__cpp_lib_expected)
+
+template <class T>
+using Result = std::expected<T, Error>;
+
+inline std::unexpected<Error> fail(int ret) noexcept
+{
+	return std::unexpected<Error>(Error(-ret));
+}
+
+#else
+
+struct Unexpected {
+	Error error;
+};
+
+inline Unexpected fail(int ret) noexcept
+{
+	return Unexpected{ Error(-ret) };
+}
+
+/* The subset of std::expected used by this header */
+template <class T>
+class [[nodiscard]] Result {
+public:
+	Result(T &&value) noexcept(std::is_nothrow_move_constructible_v<T>)
+		: v_(std::in_place_index<0>, std::move(value)) {}
+	Result(Unexpected e) noexcept : v_(std::in_place_index<1>, e.error) {}
+
+	bool has_value() const noexcept { return v_.index() == 0; }
+	explicit operator bool() const noexcept { return has_value(); }
+
+	T &value() & { return std::get<0>(v_); }
+	T &&value() && { return std::get<0>(std::move(v_)); }
+	T &operator*() & { return std::get<0>(v_); }
+	T &&operator*() && { return std::get<0>(std::move(v_)); }
+	T *operator->() { return &std::get<0>(v_); }
+	Error error() const { return std::get<1>(v_); }
+
+	template <class U>
+	T value_or(U &&other) const &
+	{
+		return has_value() ? std::get<0>(v_) : T(std::forward<U>(other));
+	}
+
+private:
+	std::variant<T, Error> v_;
+};
+
+template <>
+class [[nodiscard]] Result<void> {
+public:
+	Result() noexcept = default;
+	Result(Unexpected e) noexcept : err_(e.error), ok_(false) {}
+
+	bool has_value() const noexcept { return ok_; }
+	explicit operator bool() const noexcept { return ok_; }
+
+	void value() const {}
+	Error error() const noexcept { return err_; }
+
+private:
+	Error err_{ 0 };
+	bool ok_ = true;
+};
+
+#endif
+
+namespace detail {
+
+/* Longest path accepted, the library truncates longer ones anyway */
+inline constexpr std::size_t path_max = 1024;
+
+/* NUL-terminated copy of a string_view, an empty view gives NULL */
+class CPath {
+public:
+	explicit CPath(std::string_view s) noexcept
+	{
+		if (s.empty())
+			return;
+		if (s.size() >= sizeof(buf_)) {
+			too_long_ = true;
+			return;
+		}
+		std::memcpy(buf_, s.data(), s.size());
+		buf_[s.size()] = '\0';
+		str_ = buf_;
+	}
+
+	CPath(const CPath &) = delete;
+	CPath &operator=(const CPath &) = delete;
+
+	const char *get() const noexcept { return str_; }
+	bool too_long() const noexcept { return too_long_; }
+
+private:
+	char buf_[path_max];
+	const char *str_ = nullptr;
+	bool too_long_ = false;
+};
+
+inline Result<void> check(int ret) noexcept
+{
+	if (ret < 0)
+		return fail(ret);
+	return {};
+}
+
+} /* namespace detail */
+
+/*
+ * A loaded package. The destructor removes the image and driver overlays
+ * (dfx_cfg_remove()). Destroy it before the Package it was loaded from.
+ */
+class Overlay {
+public:
+	Overlay() noexcept = default;
+	explicit Overlay(int package_id) noexcept : id_(package_id) {}
+
+	Overlay(Overlay &&other) noexcept : id_(std::exchange(other.id_, -1)) {}
+	Overlay &operator=(Overlay &&other) noexcept
+	{
+		if (this != &other) {
+			reset();
+			id_ = std::exchange(other.id_, -1);
+		}
+		return *this;
+	}
+	Overlay(const Overlay &) = delete;
+	Overlay &operator=(const Overlay &) = delete;
+
+	~Overlay() { reset(); }
+
+	int package_id() const noexcept { return id_; }
+	explicit operator bool() const noexcept { return id_ > 0; }
+
+	/* Applies the driver overlay, dfx_cfg_drivers_load() */
+	Result<void> drivers_load() const noexcept
+	{
+		return detail::check(dfx_cfg_drivers_load(id_));
+	}
+
+	/* Removes the overlays now, reporting the error the destructor hides */
+	Result<void> remove() noexcept
+	{
+		return detail::check(dfx_cfg_remove(std::exchange(id_, -1)));
+	}
+
+	/* Gives up ownership, the overlays stay applied */
+	int release() noexcept { return std::exchange(id_, -1); }
+
+	void reset() noexcept
+	{
+		if (id_ > 0)
+			dfx_cfg_remove(std::exchange(id_, -1));
+	}
+
+private:
+	int id_ = -1;
+};
+
+/*
+ * Awaitable dfx_cfg_load(), see Package::load_async(). The load runs on
+ * @Executor, which is any object with a post() member that takes a
+ * callable, and the coroutine resumes there.
+ */
+template <class Executor>
+class LoadAwaiter {
+public:
+	LoadAwaiter(int package_id, Executor &ex) noexcept
+		: ex_(ex), id_(package_id) {}
+
+	bool await_ready() const noexcept { return false; }
+
+	void await_suspend(std::coroutine_handle<> h)
+	{
+		ex_.post([this, h]() {
+			ret_ = dfx_cfg_load(id_);
+			h.resume();
+		});
+	}
+
+	Result<Overlay> await_resume() noexcept
+	{
+		if (ret_ < 0)
+			return fail(ret_);
+		return Overlay(id_);
+	}
+
+private:
+	Executor &ex_;
+	int id_;
+	int ret_ = 0;
+};
+
+/* An initialized package. The destructor calls dfx_cfg_destroy(). */
+class Package {
+public:
+	Package() noexcept = default;
+	explicit Package(int package_id) noexcept : id_(package_id) {}
+
+	Package(Package &&other) noexcept : id_(std::exchange(other.id_, -1)) {}
+	Package &operator=(Package &&other) noexcept
+	{
+		if (this != &other) {
+			reset();
+			id_ = std::exchange(other.id_, -1);
+		}
+		return *this;
+	}
+	Package(const Package &) = delete;
+	Package &operator=(const Package &) = delete;
+
+	~Package() { reset(); }
+
+	/* dfx_cfg_init(), an empty @devpath selects fpga0 */
+	static Result<Package> init(std::string_view package_path,
+				    std::string_view devpath = {},
+				    unsigned long flags = 0) noexcept
+	{
+		detail::CPath path(package_path), dev(devpath);
+
+		if (path.get() == nullptr || path.too_long() || dev.too_long())
+			return fail(-DFX_INVALID_PARAM);
+		return from_id(dfx_cfg_init(path.get(), dev.get(), flags,
+					    nullptr));
+	}
+
+	/* dfx_cfg_init_file(), empty views stand for NULL */
+	static Result<Package> init_file(std::string_view bin_file,
+					 std::string_view dtbo_file,
+					 std::string_view driver_dtbo_file = {},
+					 std::string_view aes_key_file = {},
+					 std::string_view devpath = {},
+					 unsigned long flags = 0) noexcept
+	{
+		detail::CPath bin(bin_file), dtbo(dtbo_file);
+		detail::CPath drv(driver_dtbo_file), key(aes_key_file);
+		detail::CPath dev(devpath);
+
+		if (bin.too_long() || dtbo.too_long() || drv.too_long() ||
+		    key.too_long() || dev.too_long())
+			return fail(-DFX_INVALID_PARAM);
+		return from_id(dfx_cfg_init_file(bin.get(), dtbo.get(),
+						 drv.get(), key.get(),
+						 dev.get(), flags, nullptr));
+	}
+
+	/* dfx_catalog_init() */
+	static Result<Package> from_catalog(std::string_view name,
+					    dfx_image_format format =
+						    DFX_IMAGE_UNKNOWN,
+					    std::string_view devpath = {},
+					    unsigned long flags = 0) noexcept
+	{
+		detail::CPath n(name), dev(devpath);
+
+		if (n.get() == nullptr || n.too_long() || dev.too_long())
+			return fail(-DFX_INVALID_PARAM);
+		return from_id(dfx_catalog_init(n.get(), format, dev.get(),
+						flags));
+	}
+
+	int id() const noexcept { return id_; }
+	explicit operator bool() const noexcept { return id_ > 0; }
+
+	/* dfx_cfg_load(), the overlays stay applied while the Overlay lives */
+	Result<Overlay> load() const noexcept
+	{
+		int ret = dfx_cfg_load(id_);
+
+		if (ret < 0)
+			return fail(ret);
+		return Overlay(id_);
+	}
+
+	/* co_await pkg.load_async(ex) runs load() on @ex */
+	template <class Executor>
+	LoadAwaiter<Executor> load_async(Executor &ex) const noexcept
+	{
+		return LoadAwaiter<Executor>(id_, ex);
+	}
+
+	/* dfx_get_package_meta(), returns the number of bytes copied */
+	Result<std::size_t> meta(std::span<char> buffer) const noexcept
+	{
+		int ret = dfx_get_package_meta(id_, buffer.data(),
+					       buffer.size());
+
+		if (ret < 0)
+			return fail(ret);
+		return static_cast<std::size_t>(ret);
+	}
+
+	Result<dfx_package_info> info() const noexcept
+	{
+		dfx_package_info info;
+		int ret = dfx_get_package_info(id_, &info);
+
+		if (ret < 0)
+			return fail(ret);
+		return info;
+	}
+
+	Result<dfx_package_digest> digest() const noexcept
+	{
+		dfx_package_digest digest;
+		int ret = dfx_get_package_digest(id_, &digest);
+
+		if (ret < 0)
+			return fail(ret);
+		return digest;
+	}
+
+	/* dfx_package_uid_check(): true if active, false if loadable */
+	Result<bool> uid_active() const noexcept
+	{
+		int ret = dfx_package_uid_check(id_);
+
+		if (ret < 0)
+			return fail(ret);
+		return ret == 1;
+	}
+
+	/* Destroys the package now, reporting the error the destructor hides */
+	Result<void> destroy() noexcept
+	{
+		return detail::check(dfx_cfg_destroy(std::exchange(id_, -1)));
+	}
+
+	/* Gives up ownership, the caller destroys the package */
+	int release() noexcept { return std::exchange(id_, -1); }
+
+	void reset() noexcept
+	{
+		if (id_ > 0)
+			dfx_cfg_destroy(std::exchange(id_, -1));
+	}
+
+private:
+	static Result<Package> from_id(int ret) noexcept
+	{
+		if (ret < 0)
+			return fail(ret);
+		return Package(ret);
+	}
+
+	int id_ = -1;
+};
+
+/*
+ * dfx_get_active_uid_list_buf(), returns the number of {Node ID, Unique ID,
+ * Parent Unique ID, Function ID} entries, each 4 ints of the span
+ */
+inline Result<int> active_uids(std::span<int> buffer) noexcept
+{
+	int ret = dfx_get_active_uid_list_buf(buffer.data(),
+					      buffer.size_bytes());
+
+	if (ret < 0)
+		return fail(ret);
+	return ret / static_cast<int>(4 * sizeof(int));
+}
+
+/* dfx_uid_tree(), returns the number of nodes, which may exceed the span */
+inline Result<int> uid_tree(std::span<dfx_uid_node> nodes) noexcept
+{
+	int ret = dfx_uid_tree(nodes.data(), static_cast<int>(nodes.size()));
+
+	if (ret < 0)
+		return fail(ret);
+	return ret;
+}
+
+} /* namespace dfx */
+
+#endif
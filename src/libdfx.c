@@ -4,17 +4,20 @@
  * SPDX-License-Identifier: MIT
  ***************************************************************/
 
-#include <ctype.h>
 #include <dirent.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <libgen.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -23,6 +26,7 @@
 #include <sys/mman.h>
 #include <sys/time.h>
 #include <err.h>
+#include <pthread.h>
 
 #include <linux/dma-buf.h>
 
@@ -31,13 +35,23 @@
 #include "dmabuf_alloc.h"
 #include "libdfx.h"
 #include "dma-heap.h"
+#include "dfx_stats.h"
+#include "dfx_bitstream.h"
+#include "dfx_catalog.h"
+#include "dfx_digest.h"
+#include "dfx_ktrace.h"
+#include "dfx_log.h"
+#include "dfx_mgr.h"
+#include "dfx_pdi.h"
+#include "dfx_pkg.h"
+#include "dfx_probes.h"
+#include "dfx_root.h"
+#include "dfx_trace.h"
+#include "dfx_uid.h"
+#include "dfx_watch.h"
 
 #define DFX_IOCTL_LOAD_DMA_BUFF        _IOWR('R', 1, __u32)
 
-#define INVALID_PLATFORM	0x0U
-#define ZYNQMP_PLATFORM		0x2U
-#define VERSAL_PLATFORM		0x3U
-
 #define MAX_CMD_LEN		512U
 #define MAX_AES_KEY_LEN         64U
 #define PLATFORM_STR_LEN	128U
@@ -46,15 +60,85 @@
 
 #define ZYNQMP_MAX_ERR	27U
 
-#ifndef DTBO_ROOT_DIR
-#define DTBO_ROOT_DIR "/sys/kernel/config/device-tree/overlays"
-#endif
+#define DEFAULT_FPGA_MGR	"fpga0"
+#define FPGA_MGR_NAME_LEN	32U
+#define FIRMWARE_PATH_LEN	512U
+
+/* Threads of dfx_cfg_init_dir(), past this the copies contend for memory */
+#define INIT_DIR_WORKERS	8
+
+/*
+ * DFX_LOAD_AUTO thresholds. Images below AUTO_PRELOAD_MIN, or larger than
+ * half the free CMA, start on the firmware loader. A package moves to a
+ * dmabuf once it is loaded AUTO_HOT_LOADS times within AUTO_HOT_WINDOW_NS,
+ * or once its firmware loads average more than AUTO_SLOW_LOAD_NS.
+ */
+#define AUTO_PRELOAD_MIN	(1L << 20)
+#define AUTO_HOT_LOADS		4U
+#define AUTO_HOT_WINDOW_NS	(60ULL * 1000000000ULL)
+#define AUTO_SLOW_LOAD_NS	(50ULL * 1000000ULL)
+
+/*
+ * dfx_cfg_hint() queue. Hints further out than PREFETCH_HORIZON_NS wait,
+ * so that buffers are not held long before they are needed. A fill that
+ * finds the FPGA manager busy with a load is retried PREFETCH_RETRY_NS
+ * later.
+ */
+#define PREFETCH_QUEUE_LEN	64
+#define PREFETCH_HORIZON_NS	(5ULL * 1000000000ULL)
+#define PREFETCH_RETRY_NS	(5ULL * 1000000ULL)
+#define PREFETCH_BUDGET		(64UL << 20)
+#define IOPRIO_CLASS_IDLE	3
+#define IOPRIO_CLASS_SHIFT	13
+#define IOPRIO_WHO_PROCESS	1
+
+/*
+ * dfx_cfg_load_timed() refuses a load up front when the median of the last
+ * loads of the package that configured the image, once there are
+ * TIMED_LOAD_HISTORY of them, does not fit before the deadline.
+ */
+#define TIMED_LOAD_HISTORY	3U
+
+/*
+ * One entry per FPGA manager a package has been bound to. Loads on the
+ * same manager are serialized by @lock; loads on different managers run
+ * concurrently. Entries live for the lifetime of the process.
+ */
+struct dfx_fpga_mgr {
+	char name[FPGA_MGR_NAME_LEN];
+	pthread_mutex_t lock;
+	int platform;		/* cached, INVALID_PLATFORM until detected */
+	struct dfx_fpga_mgr *next;
+};
+
+/* Bytes of arena allocated with each package, enough for a typical one */
+#define PACKAGE_ARENA_LEN	2048U
+#define CACHE_LINE_SIZE		64U
 
+/* Arena space allocated once the first PACKAGE_ARENA_LEN bytes are used */
+struct package_chunk {
+	struct package_chunk *next;
+	unsigned char data[];
+};
 
+/*
+ * A package lives in a single allocation: the node, followed by an arena
+ * that its names, paths, key and tables are carved from (see
+ * package_alloc()). The first cache line holds the fields read by the
+ * package lookup and by every load, the rest is only used by init, destroy
+ * and the query APIs.
+ */
 struct dfx_package_node {
+	struct dfx_package_node *next;
+	unsigned long  package_id;
 	int  flags;
 	int  xilplatform;
-	unsigned long  package_id;
+	int  dma_buffd;
+	struct dfx_fpga_mgr *mgr;
+	struct dfx_pkg *pkg;		/* mapped container, NULL for folders */
+	char *load_image_overlay_pck_path;
+	char *load_drivers_overlay_pck_path;
+
 	char *aes_key;
 	char *package_name;
 	char *package_path;
@@ -66,15 +150,110 @@ struct dfx_package_node {
 	char *load_image_dtbo_path;
 	char *load_drivers_dtbo_name;
 	char *load_drivers_dtbo_path;
-	char *load_image_overlay_pck_path;
-	char *load_drivers_overlay_pck_path;
 	struct dma_buffer_info *dmabuf_info;
-	struct dfx_package_node *next;
-};
+	struct dfx_package_digest digest;
+	struct dfx_package_info info;
+	struct dfx_uid_pair *uids;	/* images of the PDI, NULL if unknown */
+	int num_uids;
+	struct dfx_stats stats;
+	struct dfx_stats_ring load_history;	/* loads that configured the image */
+	int load_path;			/* enum dfx_load_path of the next load */
+	char *cma_file;			/* kept for a DFX_LOAD_AUTO promotion */
+	unsigned long long hot_start;	/* start of the current load window */
+	unsigned int hot_loads;		/* loads in the current window */
+	unsigned int fw_loads;		/* firmware loader loads and their time */
+	unsigned long long fw_load_ns;
+	unsigned long prefetch_bytes;	/* dmabuf charged to the prefetch budget */
+	struct dma_buffer_info *stage_info;	/* reused by every promotion */
+	bool stage_failed;		/* last promotion failed, with CMA at */
+	long long stage_cma_free;
+	int timed_loads;		/* dfx_cfg_load_timed() loads running */
+	unsigned char *arena;		/* free space of the current chunk */
+	size_t arena_left;
+	struct package_chunk *chunks;	/* allocated past the first chunk */
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+_Static_assert(offsetof(struct dfx_package_node, aes_key) <= CACHE_LINE_SIZE,
+	       "load fields of struct dfx_package_node span cache lines");
 
 typedef struct dfx_package_node FPGA_NODE;
 
-FPGA_NODE *head_node, *first_node, *temp_node = NULL, *prev_node, next_node;
+FPGA_NODE *head_node, *first_node, *prev_node, next_node;
+
+/*
+ * Protects the package list and the FPGA manager list. package_idle_cond
+ * is signalled when the last timed load of a package is done with it.
+ */
+static pthread_mutex_t package_list_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t package_idle_cond = PTHREAD_COND_INITIALIZER;
+static struct dfx_fpga_mgr *fpga_mgr_list;
+
+/*
+ * The firmware search path is a single kernel-wide parameter. Users that
+ * need the same directory share it, users that need a different one wait
+ * until the current users are done.
+ */
+static pthread_mutex_t fw_path_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t fw_path_cond = PTHREAD_COND_INITIALIZER;
+static char fw_path_dir[FIRMWARE_PATH_LEN];
+static int fw_path_users;
+
+/*
+ * Last UID list read from the firmware, and the tree indexed from it. The
+ * list only changes when an image is loaded or removed, which bumps
+ * uid_cache_gen; until then it is served from memory.
+ */
+struct uid_cache {
+	unsigned int gen;
+	size_t len;
+	int *data;
+	struct dfx_uid_index index;
+};
+
+static pthread_mutex_t uid_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct uid_cache uid_cache;
+static unsigned int uid_cache_gen = 1;
+
+/*
+ * Packages announced by dfx_cfg_hint(), served by one background thread in
+ * order of their expected load time. prefetch_active is the package the
+ * thread is working on, dfx_cfg_destroy() waits for it. prefetch_used is
+ * the dmabuf memory staged ahead of a load, out of prefetch_budget.
+ */
+struct prefetch_hint {
+	int package_id;
+	unsigned long long due_ns;
+};
+
+static pthread_mutex_t prefetch_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t prefetch_cond;
+static pthread_once_t prefetch_once = PTHREAD_ONCE_INIT;
+static struct prefetch_hint prefetch_queue[PREFETCH_QUEUE_LEN];
+static int prefetch_len;
+static int prefetch_active;
+static int prefetch_cancelled;
+static bool prefetch_running;
+static size_t prefetch_budget = PREFETCH_BUDGET;
+static size_t prefetch_used;
+
+/*
+ * A dfx_cfg_load_timed() call, shared by the caller and the thread running
+ * the load. Whichever of the two is done last frees it. The thread counts
+ * in package_node->timed_loads until dfx_cfg_load() returns, which keeps
+ * the package from being destroyed under it. timed_load_self is set on
+ * that thread, dfx_cfg_load() checks it once it holds the FPGA manager.
+ */
+struct timed_load {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	struct dfx_package_node *package_node;
+	int package_id;
+	int ret;
+	bool done;
+	bool abandoned;
+};
+
+static __thread struct timed_load *timed_load_self;
 
 typedef struct {
         int err_code;
@@ -114,38 +293,81 @@ static dfx_err zynqmp_err[] = {
 
 static struct dfx_package_node *create_package(void);
 static struct dfx_package_node *get_package(int package_id);
+static struct dfx_package_node *get_package_timed(int package_id);
+static void put_package_timed(struct dfx_package_node *package_node);
+static void package_wait_idle(struct dfx_package_node *package_node);
 static int destroy_package(int package_id);
 static int read_package_folder(struct dfx_package_node *package_node);
+static int read_package_container(struct dfx_package_node *package_node,
+				  const char *path);
 static int dfx_package_load_dmabuf(struct dfx_package_node *package_node,
-				   const char *cma_file);
-static int dfx_getplatform(void);
+				   const char *cma_file,
+				   struct dfx_load_record *rec);
+static int import_dmabuf(struct dfx_package_node *package_node,
+			 const struct dma_buffer_info *import);
+static int verify_dmabuf(struct dfx_package_node *package_node);
+static int package_choose_path(struct dfx_package_node *package_node,
+			       const char *cma_file);
+static void package_auto_promote(struct dfx_package_node *package_node,
+				 struct dfx_load_record *rec);
+static int package_stage_dmabuf(struct dfx_package_node *package_node,
+				struct dfx_load_record *rec);
+static void prefetch_start(void);
+static bool timed_load_abandoned(struct timed_load *job);
+static void timed_load_free(struct timed_load *job);
+static void *timed_load_worker(void *arg);
+static void prefetch_cancel(int package_id);
+static int dfx_getplatform(const char *mgr_name);
 static int find_key(struct dfx_package_node *package_node);
 static int lengthOfLastWord2(const char *input);
-static void strlwr(char *destination, const char *source);
 static int dfx_get_error(const char *state_buf);
+static enum dma_buffer_backend buffer_backend(int flags);
 static void zynqmp_print_err_msg(int err);
 static int dfx_cfg_init_common(const char *dfx_package_path, const char *cma_file,
 			       const char *dfx_bin_file, const char *dfx_dtbo_file,
 			        const char *dfx_driver_dtbo_file,
-			       const char *dfx_aes_key_file, const char *devpath,
-			       unsigned long flags);
+			       const char *dfx_aes_key_file,
+			       const struct dfx_pkg *mem,
+			       const struct dma_buffer_info *import,
+			       const char *devpath, unsigned long flags);
+static int read_package_mem(struct dfx_package_node *package_node,
+			    const struct dfx_pkg *mem);
 static int read_package_byname(struct dfx_package_node *package_node,
 			       const char *dfx_bin_file, const char *dfx_dtbo_file,
 			       const char *dfx_driver_dtbo_file,
 			       const char *dfx_aes_key_file);
-static char *get_file_name_from_path(char *full_path);
+static const char *get_file_name_from_path(const char *full_path);
+static void *package_alloc(struct dfx_package_node *package_node, size_t size);
+static char *package_strndup(struct dfx_package_node *package_node,
+			     const char *src, size_t len);
+static char *package_strdup(struct dfx_package_node *package_node,
+			    const char *src);
+static char *package_path_join(struct dfx_package_node *package_node,
+			       const char *dir, const char *name);
 static int validate_input_files(const char *dfx_bin_file, const char *dfx_dtbo_file,
 				const char *dfx_driver_dtbo_file, const char *dfx_aes_key_file,
 				unsigned long flags);
 static bool file_exists(const char *filename);
-#ifdef ENABLE_LIBDFX_TIME
-static inline double gettime(struct timeval  t0, struct timeval t1);
-#endif
 
 static void strip_trailing(char *haystack, char needle);
 static int read_single_line(const char *path, char *buffer, size_t buf_size);
 static int write_string_to_file(const char *path, const char *src);
 static void remove_overlay_dir(const char *dir);
+static int apply_overlay(struct dfx_package_node *package_node,
+			 const char *overlay_dir, enum dfx_pkg_entry_type type,
+			 const char *dtbo_name);
+static struct dfx_fpga_mgr *get_fpga_mgr(const char *mgr_name);
+static int fpga_mgr_read_attr(const char *mgr_name, const char *attr,
+			      char *buffer, size_t buf_size);
+static int fpga_mgr_write_attr(const char *mgr_name, const char *attr,
+			       const char *src);
+static void fw_path_acquire(const char *file_path);
+static void fw_path_release(bool clear);
+static void uid_cache_invalidate(void);
+static int get_active_uid_list(int *buffer, size_t buf_size);
+static int uid_cache_refresh(void);
+static void package_read_uids(struct dfx_package_node *package_node,
+			      const unsigned char *image, size_t len);
 
 /**
  * strip_trailing() - Remove one trailing character from a string
@@ -188,18 +410,18 @@ static int read_single_line(const char *path,
 {
 	FILE *f = fopen(path, "r");
 	if (!f) {
-		printf("%s: Failed to open `%s` for reading\n", __func__, path);
+		DFX_ERR("%s: Failed to open `%s` for reading", __func__, path);
 		return -1;
 	}
 
 	if (!fgets(buffer, (int) buf_size, f)) {
-		printf("%s: Failed to read from `%s`\n", __func__, path);
+		DFX_ERR("%s: Failed to read from `%s`", __func__, path);
 		fclose(f);
 		return -1;
 	}
 
 	if (fclose(f) != 0) {
-		printf("%s: Failed to close `%s`\n", __func__, path);
+		DFX_ERR("%s: Failed to close `%s`", __func__, path);
 		return -1;
 	}
 
@@ -223,22 +445,22 @@ static int write_string_to_file(const char *path, const char *src)
 {
 	FILE *f = fopen(path, "w");
 	if (!f) {
-		printf("%s: Failed to open `%s` for writing\n", __func__, path);
+		DFX_ERR("%s: Failed to open `%s` for writing", __func__, path);
 		return -1;
 	}
 
 	if (fputs(src, f) == EOF) {
-		printf("%s: Failed to write to `%s`\n", __func__, path);
+		DFX_ERR("%s: Failed to write to `%s`", __func__, path);
 		fclose(f); // attempt to close anyway
 		return -1;
 	}
 
 	if (fclose(f) != 0) {
-		printf("%s: Failed to close `%s` after writing\n", __func__, path);
+		DFX_ERR("%s: Failed to close `%s` after writing", __func__, path);
 		return -1;
 	}
 
-	printf("%s: `%s` written to `%s`\n", __func__, src, path);
+	DFX_DBG("%s: `%s` written to `%s`", __func__, src, path);
 	return 0;
 }
 
@@ -253,11 +475,513 @@ static int write_string_to_file(const char *path, const char *src)
  */
 static void remove_overlay_dir(const char *dir)
 {
+	char attr[MAX_CMD_LEN];
+
+	/*
+	 * configfs drops the attributes together with the directory. In a
+	 * redirected overlay root they are plain files and go first.
+	 */
+	if (dfx_root_redirected(DFX_ROOT_OVERLAYS)) {
+		snprintf(attr, sizeof(attr), "%s/path", dir);
+		unlink(attr);
+		snprintf(attr, sizeof(attr), "%s/status", dir);
+		unlink(attr);
+		snprintf(attr, sizeof(attr), "%s/dtbo", dir);
+		unlink(attr);
+	}
+
 	if (rmdir(dir) != 0) {
-		printf("%s: Failed to remove directory `%s`\n", __func__, dir);
+		DFX_ERR("%s: Failed to remove directory `%s`", __func__, dir);
 	} else {
-		printf("%s: Directory `%s` removed\n", __func__, dir);
+		DFX_DBG("%s: Directory `%s` removed", __func__, dir);
+	}
+	uid_cache_invalidate();
+}
+
+/**
+ * apply_overlay() - apply an overlay of a package in `overlay_dir`
+ *
+ * @package_node:	package the overlay belongs to
+ * @overlay_dir:	configfs overlay directory, already created
+ * @type:		DFX_PKG_ENTRY_IMAGE_DTBO or DFX_PKG_ENTRY_DRIVERS_DTBO
+ * @dtbo_name:		overlay file name, for folder packages
+ *
+ * Folder packages write the overlay file name to the path attribute and
+ * the kernel fetches it through the firmware loader. Container packages
+ * write the overlay itself from the mapping to the dtbo attribute, which
+ * configfs applies when the file is closed.
+ *
+ * Return:	0 on success, -1 on error
+ */
+static int apply_overlay(struct dfx_package_node *package_node,
+			 const char *overlay_dir, enum dfx_pkg_entry_type type,
+			 const char *dtbo_name)
+{
+	const struct dfx_pkg_payload *dtbo;
+	char attr[MAX_CMD_LEN];
+	size_t off;
+	ssize_t n;
+	int fd, ret;
+
+	if (package_node->pkg == NULL)
+		return dfx_set_overlay_path(overlay_dir, dtbo_name);
+
+	dtbo = &package_node->pkg->entry[type];
+	snprintf(attr, sizeof(attr), "%s/dtbo", overlay_dir);
+	fd = open(attr, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		DFX_ERR("%s: Failed to open `%s` for writing", __func__, attr);
+		return -1;
+	}
+	for (off = 0; off < dtbo->size; off += n) {
+		n = write(fd, dtbo->data + off, dtbo->size - off);
+		if (n <= 0) {
+			DFX_ERR("%s: Failed to write to `%s`", __func__, attr);
+			close(fd);
+			uid_cache_invalidate();
+			return -1;
+		}
+	}
+	ret = close(fd);
+	/* The overlay is applied on close, a list read before is stale */
+	uid_cache_invalidate();
+	if (ret) {
+		DFX_ERR("%s: Failed to apply `%s` from `%s`", __func__,
+			dtbo->name, package_node->package_path);
+		return -1;
+	}
+
+	DFX_DBG("%s: `%s` written to `%s`", __func__, dtbo->name, attr);
+	return 0;
+}
+
+/**
+ * dfx_fpga_mgr_name() - derive the FPGA manager name from devpath
+ *
+ * @devpath:	device path passed by the user, e.g. `/dev/fpga1`, `fpga1` or
+ *		`/sys/class/fpga_manager/fpga1`. NULL or empty selects the
+ *		default manager (fpga0).
+ * @name:	buffer to write the manager name into
+ * @size:	length of the provided `name` buffer in bytes
+ *
+ * Return:	0 on success
+ *		-1 on failure
+ */
+int dfx_fpga_mgr_name(const char *devpath, char *name, const size_t size)
+{
+	const char *base;
+	size_t len;
+
+	if (devpath == NULL || devpath[0] == '\0')
+		devpath = DEFAULT_FPGA_MGR;
+
+	len = strlen(devpath);
+	while (len > 1 && devpath[len - 1] == '/')
+		len--;
+
+	base = devpath + len;
+	while (base > devpath && base[-1] != '/')
+		base--;
+
+	len -= (size_t)(base - devpath);
+	if (len == 0 || len >= size) {
+		DFX_ERR("%s: Invalid device path `%s`", __func__, devpath);
+		return -1;
+	}
+
+	memcpy(name, base, len);
+	name[len] = '\0';
+	return 0;
+}
+
+/**
+ * get_fpga_mgr() - look up or register the FPGA manager `mgr_name`
+ *
+ * @mgr_name:	name of the manager in the fpga_manager class (e.g. fpga0)
+ *
+ * Return:	the manager entry on success
+ *		NULL on failure
+ */
+static struct dfx_fpga_mgr *get_fpga_mgr(const char *mgr_name)
+{
+	struct dfx_fpga_mgr *mgr;
+
+	pthread_mutex_lock(&package_list_lock);
+	for (mgr = fpga_mgr_list; mgr != NULL; mgr = mgr->next) {
+		if (!strcmp(mgr->name, mgr_name))
+			goto END;
+	}
+
+	mgr = (struct dfx_fpga_mgr *) calloc(1, sizeof(*mgr));
+	if (mgr == NULL)
+		goto END;
+
+	strncpy(mgr->name, mgr_name, sizeof(mgr->name) - 1);
+	pthread_mutex_init(&mgr->lock, NULL);
+	mgr->next = fpga_mgr_list;
+	fpga_mgr_list = mgr;
+END:
+	pthread_mutex_unlock(&package_list_lock);
+	return mgr;
+}
+
+/**
+ * fpga_mgr_platform() - platform of an FPGA manager
+ *
+ * @mgr:	the manager
+ *
+ * The manager name is read once, not on every init.
+ *
+ * Return:	ZYNQMP_PLATFORM or VERSAL_PLATFORM
+ *		INVALID_PLATFORM if the manager name is not known
+ */
+static int fpga_mgr_platform(struct dfx_fpga_mgr *mgr)
+{
+	int platform;
+
+	platform = __atomic_load_n(&mgr->platform, __ATOMIC_RELAXED);
+	if (platform == INVALID_PLATFORM) {
+		platform = dfx_getplatform(mgr->name);
+		__atomic_store_n(&mgr->platform, platform, __ATOMIC_RELAXED);
+	}
+
+	return platform;
+}
+
+int dfx_fpga_mgr_platform(const char *devpath)
+{
+	char mgr_name[FPGA_MGR_NAME_LEN];
+	struct dfx_fpga_mgr *mgr;
+
+	if (dfx_fpga_mgr_name(devpath, mgr_name, sizeof(mgr_name)))
+		return INVALID_PLATFORM;
+	mgr = get_fpga_mgr(mgr_name);
+	if (mgr == NULL)
+		return INVALID_PLATFORM;
+
+	return fpga_mgr_platform(mgr);
+}
+
+/**
+ * fpga_mgr_read_attr() - read a sysfs attribute of an FPGA manager
+ *
+ * @mgr_name:	name of the manager (e.g. fpga0)
+ * @attr:	attribute name (e.g. state)
+ * @buffer:	buffer to write the data into
+ * @buf_size:	length of the provided `buffer` in bytes
+ *
+ * Return:	0 on success
+ *		-1 on failure
+ */
+static int fpga_mgr_read_attr(const char *mgr_name, const char *attr,
+			      char *buffer, const size_t buf_size)
+{
+	char path[MAX_CMD_LEN];
+
+	snprintf(path, sizeof(path), "%s/%s/%s",
+		 dfx_root(DFX_ROOT_FPGA_MGR), mgr_name, attr);
+	return read_single_line(path, buffer, buf_size);
+}
+
+/**
+ * fpga_mgr_write_attr() - write a string to a sysfs attribute of an FPGA
+ * manager
+ *
+ * @mgr_name:	name of the manager (e.g. fpga0)
+ * @attr:	attribute name (e.g. flags)
+ * @src:	null-terminated string to write
+ *
+ * Return:	0 on success
+ *		-1 on failure
+ */
+static int fpga_mgr_write_attr(const char *mgr_name, const char *attr,
+			       const char *src)
+{
+	char path[MAX_CMD_LEN];
+
+	snprintf(path, sizeof(path), "%s/%s/%s",
+		 dfx_root(DFX_ROOT_FPGA_MGR), mgr_name, attr);
+	return write_string_to_file(path, src);
+}
+
+/**
+ * fw_path_acquire() - point the kernel firmware search path at the parent
+ * directory of `file_path` and hold it there
+ *
+ * @file_path:	the full path to the file the kernel is going to request
+ *
+ * Blocks while other users hold the search path on a different directory.
+ * Every call must be paired with fw_path_release().
+ */
+static void fw_path_acquire(const char *file_path)
+{
+	char path_copy[FIRMWARE_PATH_LEN];
+	char *parent_dir;
+
+	strncpy(path_copy, file_path, sizeof(path_copy) - 1);
+	path_copy[sizeof(path_copy) - 1] = '\0';
+	parent_dir = dirname(path_copy);
+	if (!strcmp(".", parent_dir))
+		parent_dir = "";
+
+	pthread_mutex_lock(&fw_path_lock);
+	while (fw_path_users > 0 && strcmp(fw_path_dir, parent_dir))
+		pthread_cond_wait(&fw_path_cond, &fw_path_lock);
+
+	if (fw_path_users == 0 && strcmp(fw_path_dir, parent_dir)) {
+		dfx_set_firmware_search_path(file_path);
+		strcpy(fw_path_dir, parent_dir);
+	}
+	fw_path_users++;
+	pthread_mutex_unlock(&fw_path_lock);
+}
+
+/**
+ * fw_path_release() - drop a reference taken by fw_path_acquire()
+ *
+ * @clear:	reset the search path to the kernel defaults if this was the
+ *		last user
+ */
+static void fw_path_release(bool clear)
+{
+	pthread_mutex_lock(&fw_path_lock);
+	fw_path_users--;
+	if (fw_path_users == 0) {
+		if (clear && fw_path_dir[0] != '\0') {
+			dfx_set_firmware_search_path("");
+			fw_path_dir[0] = '\0';
+		}
+		pthread_cond_broadcast(&fw_path_cond);
+	}
+	pthread_mutex_unlock(&fw_path_lock);
+}
+
+/**
+ * uid_cache_invalidate() - mark the cached UID list stale
+ *
+ * Called once a write that may load or remove an image has returned,
+ * whatever its result. A list read while the write was in progress was
+ * stored under the previous generation and is read again.
+ */
+static void uid_cache_invalidate(void)
+{
+	__atomic_add_fetch(&uid_cache_gen, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * read_uid_list() - read the whole firmware UID list into `cache`
+ *
+ * @cache:	receives the list, replacing its previous contents
+ *
+ * The attribute is read with as few read() calls as possible rather than
+ * one int at a time.
+ *
+ * Return:	0 on success, negative error code otherwise
+ */
+static int read_uid_list(struct uid_cache *cache)
+{
+	char filename[MAX_CMD_LEN];
+	size_t len = 0, size;
+	struct stat st;
+	int *data;
+	ssize_t n;
+	int fd;
+
+	snprintf(filename, sizeof(filename), "%s/uid-read",
+		 dfx_root(DFX_ROOT_VERSAL_FW));
+	fd = open(filename, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		DFX_ERR("%s: Unable to open file!", __func__);
+		return -DFX_FAIL_TO_OPEN_BIN_FILE;
+	}
+
+	/* sysfs binary attributes report their full size, others report 0 */
+	size = (fstat(fd, &st) == 0 && st.st_size > 0) ? st.st_size : 4096;
+	data = malloc(size);
+	for (;;) {
+		if (data == NULL) {
+			close(fd);
+			return -DFX_INSUFFICIENT_MEM;
+		}
+		n = read(fd, (char *)data + len, size - len);
+		if (n < 0) {
+			DFX_ERR("%s: Unable to read file!", __func__);
+			free(data);
+			close(fd);
+			return -DFX_FAIL_TO_OPEN_BIN_FILE;
+		}
+		if (n == 0)
+			break;
+		len += n;
+		if (len == size) {
+			int *grown = realloc(data, size * 2);
+
+			if (grown == NULL)
+				free(data);
+			data = grown;
+			size *= 2;
+		}
+	}
+	close(fd);
+
+	free(cache->data);
+	cache->data = data;
+	cache->len = len - len % sizeof(int);
+
+	return 0;
+}
+
+/**
+ * uid_cache_refresh() - re-read the UID list if it may have changed
+ *
+ * Must be called with uid_cache_lock held. The index is rebuilt together
+ * with the list.
+ *
+ * Return:	0 on success, negative error code otherwise
+ */
+static int uid_cache_refresh(void)
+{
+	unsigned int gen;
+	int ret;
+
+	gen = __atomic_load_n(&uid_cache_gen, __ATOMIC_ACQUIRE);
+	if (uid_cache.gen == gen)
+		return 0;
+
+	if (dfx_getplatform(DEFAULT_FPGA_MGR) != VERSAL_PLATFORM)
+		return -DFX_INVALID_PLATFORM_ERROR;
+	ret = read_uid_list(&uid_cache);
+	if (ret == 0)
+		ret = dfx_uid_index_build(&uid_cache.index, uid_cache.data,
+					  uid_cache.len);
+	if (ret == 0)
+		uid_cache.gen = gen;
+
+	return ret;
+}
+
+/**
+ * get_active_uid_list() - copy the active UID list into `buffer`
+ *
+ * @buffer:	user buffer
+ * @buf_size:	size of @buffer in bytes
+ *
+ * The firmware is only asked again if an image was loaded or removed since
+ * the list was last read.
+ *
+ * Return:	number of bytes copied on success, negative error code otherwise
+ */
+static int get_active_uid_list(int *buffer, size_t buf_size)
+{
+	int ret;
+
+	pthread_mutex_lock(&uid_cache_lock);
+	ret = uid_cache_refresh();
+	if (ret)
+		goto UNLOCK;
+
+	if (uid_cache.len > buf_size) {
+		ret = -DFX_INSUFFICIENT_MEM;
+		goto UNLOCK;
+	}
+	memcpy(buffer, uid_cache.data, uid_cache.len);
+	ret = uid_cache.len;
+UNLOCK:
+	pthread_mutex_unlock(&uid_cache_lock);
+	return ret;
+}
+
+/**
+ * uid_find() - look up an entry of the active UID tree
+ *
+ * @key:	field to match
+ * @value:	value of the field
+ * @node:	receives the entry
+ *
+ * Return:	0 on success, negative error code otherwise
+ */
+static int uid_find(enum dfx_uid_key key, unsigned int value,
+		    struct dfx_uid_node *node)
+{
+	const struct dfx_uid_node *found;
+	int ret;
+
+	if (node == NULL)
+		return -DFX_INVALID_PARAM;
+
+	pthread_mutex_lock(&uid_cache_lock);
+	ret = uid_cache_refresh();
+	if (ret == 0) {
+		found = dfx_uid_index_find(&uid_cache.index, key, value);
+		if (found != NULL)
+			*node = *found;
+		else
+			ret = -DFX_UID_NOT_FOUND_ERROR;
+	}
+	pthread_mutex_unlock(&uid_cache_lock);
+
+	return ret;
+}
+
+/**
+ * package_uid_check() - match the PDI of a package against the active tree
+ *
+ * @package_node:	package to check
+ *
+ * Return:	see dfx_package_uid_check()
+ */
+static int package_uid_check(struct dfx_package_node *package_node)
+{
+	int ret;
+
+	if (package_node->num_uids == 0)
+		return -DFX_UID_NOT_FOUND_ERROR;
+
+	pthread_mutex_lock(&uid_cache_lock);
+	ret = uid_cache_refresh();
+	if (ret == 0)
+		ret = dfx_uid_index_check(&uid_cache.index, package_node->uids,
+					  package_node->num_uids);
+	pthread_mutex_unlock(&uid_cache_lock);
+
+	return ret;
+}
+
+/**
+ * package_read_uids() - remember the image UIDs of a PDI package
+ *
+ * @package_node:	package being initialized
+ * @image:		image in the dmabuf, synced for CPU access
+ * @len:		length of @image
+ *
+ * Images that are not PDIs, or carry no UIDs, leave the package without
+ * any; the UID checks of dfx_cfg_load() are then skipped for it.
+ */
+static void package_read_uids(struct dfx_package_node *package_node,
+			      const unsigned char *image, size_t len)
+{
+	struct dfx_pdi_layout layout;
+	struct dfx_pdi_meta *meta;
+	unsigned int i;
+	int n = 0;
+
+	meta = malloc(sizeof(*meta));
+	if (meta == NULL)
+		return;
+	if (dfx_pdi_parse(image, len, &layout, meta) == 0)
+		package_node->uids = package_alloc(package_node,
+					DFX_PDI_MAX_IMAGES *
+					sizeof(*package_node->uids));
+	for (i = 0; package_node->uids != NULL && i < meta->num_images &&
+	     i < DFX_PDI_MAX_IMAGES; i++) {
+		if (meta->images[i].uid == 0)
+			continue;
+		package_node->uids[n].uid = meta->images[i].uid;
+		package_node->uids[n].parent_uid = meta->images[i].parent_uid;
+		n++;
 	}
+	package_node->num_uids = n;
+	free(meta);
 }
 
 /**
@@ -266,16 +990,16 @@ static void remove_overlay_dir(const char *dir)
  * @buffer:			buffer to write the state into
  * @buf_size:		length of the provided `buffer` in bytes
  *
- * This static function checks the operational state of the FPGA by reading
- * the state from the sysfs interface.
+ * This static function checks the operational state of the default FPGA
+ * manager (fpga0) by reading the state from the sysfs interface.
  *
  * Return:	number of bytes read on success
  *			-1 on failure
  */
 int dfx_get_fpga_state(char *buffer, const size_t buf_size)
 {
-	const char *state_file_path = "/sys/class/fpga_manager/fpga0/state";
-	return read_single_line(state_file_path, buffer, sizeof(char) * buf_size);
+	return fpga_mgr_read_attr(DEFAULT_FPGA_MGR, "state", buffer,
+				  sizeof(char) * buf_size);
 }
 
 /**
@@ -294,9 +1018,11 @@ int dfx_get_fpga_state(char *buffer, const size_t buf_size)
 int dfx_set_overlay_path(const char *overlay_dir, const char *requested_path)
 {
 	char full_path[256];
+	int ret;
+
 	if (sizeof(full_path) < strlen(overlay_dir) + 6) { // '/' + '\0' + "path"
-		printf("%s: Resulting path `%s` is too long for internal buffer (max: "
-			   "%d)\n",
+		DFX_ERR("%s: Resulting path `%s` is too long for internal buffer (max: "
+			   "%d)",
 			   __func__, overlay_dir, MAX_CMD_LEN);
 		return -1;
 	}
@@ -305,11 +1031,17 @@ int dfx_set_overlay_path(const char *overlay_dir, const char *requested_path)
 	strip_trailing(full_path, '/');
 	strcat(full_path, "/path");
 
-	if (write_string_to_file(full_path, requested_path)) {
-		printf("%s: Failed to apply the overlay - could not write to path file\n",
+	DFX_PROBE2(overlay_path_write_entry, overlay_dir, requested_path);
+	ret = write_string_to_file(full_path, requested_path);
+	/* The write loads the image, a list read before it is stale */
+	uid_cache_invalidate();
+	if (ret) {
+		DFX_ERR("%s: Failed to apply the overlay - could not write to path file",
 			   __func__);
+		DFX_PROBE2(overlay_path_write_return, overlay_dir, -1);
 		return -1;
 	}
+	DFX_PROBE2(overlay_path_write_return, overlay_dir, 0);
 	return 0;
 }
 
@@ -330,10 +1062,14 @@ int dfx_set_overlay_path(const char *overlay_dir, const char *requested_path)
  */
 int dfx_set_fpga_firmware(const char *requested_binary_name)
 {
-	if (write_string_to_file("/sys/class/fpga_manager/fpga0/firmware",
-							 requested_binary_name)) {
-		printf("%s: Failed to write the bitstream ,-"
-			   " could not write to firmware file\n",
+	int ret;
+
+	ret = fpga_mgr_write_attr(DEFAULT_FPGA_MGR, "firmware",
+				  requested_binary_name);
+	uid_cache_invalidate();
+	if (ret) {
+		DFX_ERR("%s: Failed to write the bitstream ,-"
+			   " could not write to firmware file",
 			   __func__);
 		return -1;
 	}
@@ -357,8 +1093,8 @@ int dfx_set_fpga_flags(const int flags)
 {
 	char buf[32];
 	snprintf(buf, sizeof(buf), "%x", flags); // convert to hex
-	if (write_string_to_file("/sys/class/fpga_manager/fpga0/flags", buf)) {
-		printf("%s: Failed to set fpga flags - could not write to flags file\n",
+	if (fpga_mgr_write_attr(DEFAULT_FPGA_MGR, "flags", buf)) {
+		DFX_ERR("%s: Failed to set fpga flags - could not write to flags file",
 			   __func__);
 		return -1;
 	}
@@ -377,8 +1113,8 @@ int dfx_set_fpga_flags(const int flags)
  */
 int dfx_set_fpga_key(const char *key)
 {
-	if (write_string_to_file("/sys/class/fpga_manager/fpga0/key", key)) {
-		printf("%s: Failed to set fpga flags - could not write to flags file\n",
+	if (fpga_mgr_write_attr(DEFAULT_FPGA_MGR, "key", key)) {
+		DFX_ERR("%s: Failed to set fpga flags - could not write to flags file",
 			   __func__);
 		return -1;
 	}
@@ -403,8 +1139,8 @@ int dfx_get_overlay_path(const char *overlay_dir, char *buffer,
 {
 	char full_path[MAX_CMD_LEN];
 	if (sizeof(full_path) < strlen(overlay_dir) + 6) { // + '/' + '\0' + "path"
-		printf("%s: Resulting path `%s` is too long for internal buffer (max: "
-			   "%d)\n",
+		DFX_ERR("%s: Resulting path `%s` is too long for internal buffer (max: "
+			   "%d)",
 			   __func__, overlay_dir, MAX_CMD_LEN);
 		return -1;
 	}
@@ -432,8 +1168,8 @@ int dfx_get_overlay_status(const char *overlay_dir, char *buffer,
 {
 	char full_path[MAX_CMD_LEN];
 	if (sizeof(full_path) < strlen(overlay_dir) + 8) { // '/' + '\0' + "status"
-		printf("%s: Resulting path `%s` is too long for internal buffer (max: "
-			   "%d)\n",
+		DFX_ERR("%s: Resulting path `%s` is too long for internal buffer (max: "
+			   "%d)",
 			   __func__, overlay_dir, MAX_CMD_LEN);
 		return -1;
 	}
@@ -454,8 +1190,11 @@ int dfx_get_overlay_status(const char *overlay_dir, char *buffer,
  *                                fpga-package: /nava/fpga-package1
  *                                                      |--> Bit_file.bin
  *                                                      |--> DT_Overlayfile.dtbo
- * const char *devpath: The dev interface is exposed at /dev/fpga-deviceN.
- *                      where N is the interface-device number.
+ * const char *devpath: The FPGA manager the package is bound to, exposed at
+ *                      /dev/fpgaN where N is the interface-device number.
+ *                      NULL selects /dev/fpga0. Packages on different
+ *                      managers can be loaded concurrently, packages on
+ *                      the same manager are serialized.
  * unsigned long flags: Flags to specify any special instructions for library
  *			to perform.
  * Optional parameters (using variadic arguments):
@@ -469,20 +1208,17 @@ int dfx_cfg_init(const char *dfx_package_path,
                  const char *devpath, unsigned long flags,
                  ...)
 {
+	unsigned long long trace_t0;
 	int ret = 0;
 	va_list args;
 	const char *cma_file = NULL;
 
-#ifdef ENABLE_LIBDFX_TIME
-	struct timeval t1, t0;
-	double time;
-
-	gettimeofday(&t0, NULL);
-#endif
-
+	trace_t0 = dfx_trace_begin();
+	DFX_PROBE1(cfg_init_entry, dfx_package_path);
 	if (dfx_package_path == NULL) {
-		printf("%s: Invalid input args\n", __func__);
-		return -DFX_INVALID_PARAM;
+		DFX_ERR("%s: Invalid input args", __func__);
+		ret = -DFX_INVALID_PARAM;
+		goto END;
 	}
 
 	va_start(args, flags);
@@ -493,17 +1229,128 @@ int dfx_cfg_init(const char *dfx_package_path,
 	va_end(args);
 
 	ret = dfx_cfg_init_common(dfx_package_path, cma_file,  NULL, NULL,
-				  NULL, NULL, devpath, flags);
+				  NULL, NULL, NULL, NULL, devpath, flags);
 
-#ifdef ENABLE_LIBDFX_TIME
-	gettimeofday(&t1, NULL);
-	time = gettime(t0, t1);
-	printf("%s API Time taken: %f Milli Seconds\n\r", __func__, time);
-#endif
+END:
+	DFX_TRACE_CALL_STR(DFX_TRACE_OP_CFG_INIT, trace_t0, 0, ret, flags,
+			   dfx_package_path, devpath, cma_file);
+	DFX_PROBE2(cfg_init_return, dfx_package_path, ret);
 	return ret;
 }
 
-/* Provide a generic interface to the user to specify the required parameters
+/* Packages of a dfx_cfg_init_dir() call, handed out to the workers */
+struct init_dir_job {
+	const struct dfx_catalog_entry *entries;
+	struct dfx_init_result *results;
+	int count;
+	int next;
+	const char *devpath;
+	unsigned long flags;
+};
+
+static void *init_dir_worker(void *arg)
+{
+	struct init_dir_job *job = arg;
+	int i;
+
+	while ((i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) <
+	       job->count)
+		job->results[i].package_id = dfx_cfg_init(job->entries[i].path,
+							  job->devpath,
+							  job->flags, NULL);
+
+	return NULL;
+}
+
+/* This API initializes every package of a library root, see
+ * dfx_catalog_scan(), on up to INIT_DIR_WORKERS threads, so that image
+ * copies and buffer allocations of different packages overlap. The root is
+ * scanned for this call only, the catalog is left as it is.
+ *
+ * const char *root: Library root, Ex: /lib/firmware/xilinx
+ * const char *devpath: FPGA manager of all the packages, see dfx_cfg_init().
+ * unsigned long flags: Flags passed to dfx_cfg_init() for every package.
+ * struct dfx_init_result **results: Receives an array with the name and
+ *				     package_Id, or error code, of each
+ *				     package in file name order. Release it
+ *				     with free().
+ * int *count: Receives the number of entries of *results.
+ *
+ * Return: returns zero if all packages were initialized, the error code of
+ *	   the first package that failed otherwise, or Error code if the root
+ *	   could not be read, in which case *results is NULL.
+ */
+int dfx_cfg_init_dir(const char *root, const char *devpath,
+		     unsigned long flags, struct dfx_init_result **results,
+		     int *count)
+{
+	pthread_t threads[INIT_DIR_WORKERS];
+	struct dfx_catalog_entry *entries;
+	struct init_dir_job job = { 0 };
+	long cpus;
+	int i, n, started = 0, workers, ret = 0;
+
+	if (root == NULL || results == NULL || count == NULL) {
+		DFX_ERR("%s: Invalid input args", __func__);
+		return -DFX_INVALID_PARAM;
+	}
+	*results = NULL;
+	*count = 0;
+
+	n = dfx_catalog_scan_list(root, dfx_fpga_mgr_platform(devpath),
+				  &entries);
+	if (n < 0)
+		return n;
+
+	job.results = calloc(n ? n : 1, sizeof(*job.results));
+	if (job.results == NULL) {
+		DFX_ERR("%s: Failed to allocate %d results", __func__, n);
+		free(entries);
+		return -DFX_INSUFFICIENT_MEM;
+	}
+
+	for (i = 0; i < n; i++)
+		memcpy(job.results[i].name, entries[i].name,
+		       sizeof(job.results[i].name));
+
+	job.entries = entries;
+	job.count = n;
+	job.devpath = devpath;
+	job.flags = flags;
+
+	cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	workers = cpus > 0 && cpus < INIT_DIR_WORKERS ? cpus : INIT_DIR_WORKERS;
+	if (workers > n)
+		workers = n;
+
+	/* The caller is one of the workers, and picks up what others could not */
+	for (i = 1; i < workers; i++) {
+		if (pthread_create(&threads[started], NULL, init_dir_worker,
+				   &job))
+			break;
+		started++;
+	}
+	init_dir_worker(&job);
+	for (i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+
+	for (i = 0; i < n; i++) {
+		if (job.results[i].package_id < 0) {
+			DFX_ERR("%s: `%s` failed: %d", __func__,
+				job.results[i].name, job.results[i].package_id);
+			if (ret == 0)
+				ret = job.results[i].package_id;
+		}
+	}
+
+	free(entries);
+	*results = job.results;
+	*count = n;
+
+	return ret;
+}
+
+/* Provide a generic interface to the user to specify the required parameters
  * for FPGA programming.It takes absolute paths of all individual files as
  * arguments and perform the required init functionality.
  * The calling process must call this API before it performs -load/remove.
@@ -524,8 +1371,8 @@ int dfx_cfg_init(const char *dfx_package_path,
  * Note: If the bitstream is encrypted with the user-key then the user needs to
  * pass relevant aes_key.key file for other use cases user should pass "NULL".
  *
- * char *devpath: The dev interface is exposed at /dev/fpga-deviceN.
- * Where N is the interface-device number.
+ * char *devpath: The FPGA manager the package is bound to, exposed at
+ * /dev/fpgaN where N is the interface-device number. NULL selects /dev/fpga0.
  *
  * Optional parameters (using variadic arguments):
  * char *cma_file: (Optional) Custom CMA file path for DMA buffer allocation.
@@ -541,22 +1388,20 @@ int dfx_cfg_init_file(const char *dfx_bin_file, const char *dfx_dtbo_file,
 		      const char *dfx_driver_dtbo_file, const char *dfx_aes_key_file,
 		      const char *devpath, unsigned long flags, ...)
 {
+	unsigned long long trace_t0;
 	va_list args;
 	int len, ret = 0;
 	const char *cma_file = NULL;
-#ifdef ENABLE_LIBDFX_TIME
-	struct timeval t1, t0;
-	double time;
 
-	gettimeofday(&t0, NULL);
-#endif
+	trace_t0 = dfx_trace_begin();
+	DFX_PROBE1(cfg_init_file_entry, dfx_bin_file);
 	/* Validate Inputs */
 	ret = validate_input_files(dfx_bin_file, dfx_dtbo_file,
 				   dfx_driver_dtbo_file, dfx_aes_key_file,
 				   flags);
 	if (ret) {
-		printf("%s: Invalid input args\n", __func__);
-		return ret;
+		DFX_ERR("%s: Invalid input args", __func__);
+		goto END;
 	}
 
 	va_start(args, flags);
@@ -567,13 +1412,187 @@ int dfx_cfg_init_file(const char *dfx_bin_file, const char *dfx_dtbo_file,
 	va_end(args);
 
 	ret = dfx_cfg_init_common(NULL, cma_file, dfx_bin_file, dfx_dtbo_file,
-				  dfx_driver_dtbo_file, dfx_aes_key_file,
-				  devpath, flags);
-#ifdef ENABLE_LIBDFX_TIME
-	gettimeofday(&t1, NULL);
-	time = gettime(t0, t1);
-	printf("%s API Time taken: %f Milli Seconds\n\r", __func__, time);
-#endif
+				  dfx_driver_dtbo_file, dfx_aes_key_file, NULL,
+				  NULL, devpath, flags);
+END:
+	DFX_TRACE_CALL_STR(DFX_TRACE_OP_CFG_INIT_FILE, trace_t0, 0, ret, flags,
+			   dfx_bin_file, dfx_dtbo_file, dfx_driver_dtbo_file,
+			   dfx_aes_key_file, devpath, cma_file);
+	DFX_PROBE2(cfg_init_file_return, dfx_bin_file, ret);
+	return ret;
+}
+
+/* Provide an interface to the user to initialize a package from images
+ * and overlays it already holds in memory, without writing them to files.
+ * The image is copied into the DMA buffer here, the overlays are copied
+ * into the package and written to configfs on load. The caller may release
+ * its buffers as soon as this API returns.
+ *
+ * const void *image: Bitstream/PDI image. A .bit file is recognised by its
+ *             header, anything else is taken as a .bin on ZynqMP and as
+ *             a PDI on Versal.
+ * size_t image_len: Length of the image in bytes.
+ *
+ * const void *dtbo: Image overlay blob.
+ * size_t dtbo_len: Length of the overlay in bytes.
+ *
+ * const void *drv_dtbo: Drivers overlay blob (or) NULL.
+ * size_t drv_dtbo_len: Length of the drivers overlay, 0 if there is none.
+ *
+ * char *devpath: The FPGA manager the package is bound to, exposed at
+ * /dev/fpgaN where N is the interface-device number. NULL selects /dev/fpga0.
+ *
+ * unsigned long flags: Flags to specify any special instructions for the
+ * library to perform. DFX_ENCRYPTION_USERKEY_EN is not supported, the key
+ * is read from a file, use dfx_cfg_init_file() for such images.
+ *
+ * Optional parameters (using variadic arguments):
+ * char *cma_file: (Optional) Custom CMA file path for DMA buffer allocation.
+ *                 If NULL or not provided, defaults to standard paths:
+ *                 "/dev/dma_heap/reserved" or "/dev/dma_heap/cma_reserved@800000000"
+ *
+ * Return: returns unique package_Id or Error code on failure.
+ */
+int dfx_cfg_init_mem(const void *image, size_t image_len,
+		     const void *dtbo, size_t dtbo_len,
+		     const void *drv_dtbo, size_t drv_dtbo_len,
+		     const char *devpath, unsigned long flags, ...)
+{
+	unsigned long long trace_t0;
+	const char *cma_file = NULL;
+	char lens[3][24];
+	struct dfx_pkg mem;
+	va_list args;
+	int ret;
+
+	trace_t0 = dfx_trace_begin();
+	DFX_PROBE1(cfg_init_mem_entry, image_len);
+	if (image == NULL || image_len == 0 || dtbo == NULL || dtbo_len == 0 ||
+	    (drv_dtbo == NULL && drv_dtbo_len) ||
+	    (drv_dtbo != NULL && drv_dtbo_len == 0)) {
+		DFX_ERR("%s: Invalid input args", __func__);
+		ret = -DFX_INVALID_PARAM;
+		goto END;
+	}
+	if (flags & DFX_ENCRYPTION_USERKEY_EN) {
+		DFX_ERR("%s: User key images need dfx_cfg_init_file()",
+			__func__);
+		ret = -DFX_INVALID_PARAM;
+		goto END;
+	}
+
+	va_start(args, flags);
+
+	// Attempt to fetch next arg (optional cma_file)
+	cma_file = va_arg(args, const char *);
+
+	va_end(args);
+
+	memset(&mem, 0, sizeof(mem));
+	strcpy(mem.name, "mem");
+	mem.entry[DFX_PKG_ENTRY_IMAGE].data = image;
+	mem.entry[DFX_PKG_ENTRY_IMAGE].size = image_len;
+	mem.entry[DFX_PKG_ENTRY_IMAGE_DTBO].data = dtbo;
+	mem.entry[DFX_PKG_ENTRY_IMAGE_DTBO].size = dtbo_len;
+	mem.entry[DFX_PKG_ENTRY_DRIVERS_DTBO].data = drv_dtbo;
+	mem.entry[DFX_PKG_ENTRY_DRIVERS_DTBO].size = drv_dtbo_len;
+
+	ret = dfx_cfg_init_common(NULL, cma_file, NULL, NULL, NULL, NULL, &mem,
+				  NULL, devpath, flags);
+END:
+	if (trace_t0) {
+		snprintf(lens[0], sizeof(lens[0]), "%zu", image_len);
+		snprintf(lens[1], sizeof(lens[1]), "%zu", dtbo_len);
+		snprintf(lens[2], sizeof(lens[2]), "%zu", drv_dtbo_len);
+		DFX_TRACE_CALL_STR(DFX_TRACE_OP_CFG_INIT_MEM, trace_t0, 0, ret,
+				   flags, devpath, cma_file, lens[0], lens[1],
+				   lens[2]);
+	}
+	DFX_PROBE2(cfg_init_mem_return, image_len, ret);
+	return ret;
+}
+
+/* Provide an interface to the user to initialize a package whose image is
+ * already in a dmabuf, written there by a DMA engine or another driver.
+ * The buffer is handed to the FPGA manager as is on every load: the library
+ * allocates no buffer and never reads or copies the image.
+ *
+ * int dmabuf_fd: dmabuf holding the image. The fd is duplicated, the caller
+ *             may close its own fd once this API returns. The buffer stays
+ *             allocated until dfx_cfg_destroy() drops the duplicate, and
+ *             must not be written to while the package is loaded.
+ *
+ * size_t len: Length of the image. The FPGA manager is given the whole
+ *             buffer, so the image must end at its end. On ZynqMP the
+ *             image must already be padded to a multiple of 4 bytes, the
+ *             padding ahead of the data as dfx_cfg_init_file() does it.
+ *
+ * const char *dfx_dtbo_file: Absolute relevant dtbo file path
+ *             -Ex: /lib/firmware/xilinx/example/example.dtbo
+ *
+ * const char *dfx_driver_dtbo_file: Absolute relevant dtbo file path (or) NULL
+ *
+ * char *dfx_aes_key_file: Absolute relevant aes key file path (or) NULL
+ *
+ * char *devpath: The FPGA manager the package is bound to, exposed at
+ * /dev/fpgaN where N is the interface-device number. NULL selects /dev/fpga0.
+ *
+ * unsigned long flags: Flags to specify any special instructions for the
+ * library to perform. DFX_EXTERNAL_CONFIG_EN, DFX_DIGEST_SHA256_EN and
+ * DFX_VERIFY_ON_LOAD_EN are rejected, they need an image the library reads.
+ * DFX_BUFFER_MEMFD marks dmabuf_fd as a plain memfd, which dfx_cfg_load()
+ * does not hand to the FPGA manager.
+ *
+ * Return: returns unique package_Id or Error code on failure.
+ */
+int dfx_cfg_init_dmabuf(int dmabuf_fd, size_t len, const char *dfx_dtbo_file,
+			const char *dfx_driver_dtbo_file,
+			const char *dfx_aes_key_file, const char *devpath,
+			unsigned long flags)
+{
+	struct dma_buffer_info import = { 0 };
+	unsigned long long trace_t0;
+	char len_buf[24];
+	int ret;
+
+	trace_t0 = dfx_trace_begin();
+	DFX_PROBE2(cfg_init_dmabuf_entry, dmabuf_fd, len);
+	if (dmabuf_fd < 0 || len == 0 || dfx_dtbo_file == NULL ||
+	    !file_exists(dfx_dtbo_file) ||
+	    (dfx_driver_dtbo_file != NULL &&
+	     !file_exists(dfx_driver_dtbo_file)) ||
+	    ((flags & DFX_ENCRYPTION_USERKEY_EN) &&
+	     (dfx_aes_key_file == NULL || !file_exists(dfx_aes_key_file)))) {
+		DFX_ERR("%s: Invalid input args", __func__);
+		ret = -DFX_INVALID_PARAM;
+		goto END;
+	}
+	if (flags & (DFX_EXTERNAL_CONFIG_EN | DFX_DIGEST_SHA256_EN |
+		     DFX_VERIFY_ON_LOAD_EN)) {
+		DFX_ERR("%s: flags 0x%lx need an image read by the library",
+			__func__, flags);
+		ret = -DFX_INVALID_PARAM;
+		goto END;
+	}
+
+	import.devfd = -1;
+	import.dma_buffd = dmabuf_fd;
+	import.dma_buflen = len;
+	import.backend = buffer_backend(flags);
+	import.is_imported = 1;
+
+	ret = dfx_cfg_init_common(NULL, NULL, NULL, dfx_dtbo_file,
+				  dfx_driver_dtbo_file, dfx_aes_key_file, NULL,
+				  &import, devpath, flags);
+END:
+	if (trace_t0) {
+		snprintf(len_buf, sizeof(len_buf), "%zu", len);
+		DFX_TRACE_CALL_STR(DFX_TRACE_OP_CFG_INIT_DMABUF, trace_t0, 0,
+				   ret, flags, dfx_dtbo_file,
+				   dfx_driver_dtbo_file, dfx_aes_key_file,
+				   devpath, len_buf);
+	}
+	DFX_PROBE2(cfg_init_dmabuf_return, dmabuf_fd, ret);
 	return ret;
 }
 
@@ -589,109 +1608,316 @@ int dfx_cfg_init_file(const char *dfx_bin_file, const char *dfx_dtbo_file,
 int dfx_cfg_load(int package_id)
 {
 	FPGA_NODE *package_node;
-	int len, fd, buffd, ret = 0, err = 0;
+	struct dfx_fpga_mgr *mgr;
+	struct dfx_load_record rec = { 0 };
+	unsigned long long start, t0, trace_t0;
+	int fd, buffd, ret = 0, err = 0, ktrace, applied;
+	bool configured = false;
 	char path_buf[MAX_CMD_LEN];
-	char *overlay_dir_path;
 	char state_buf[128];
-#ifdef ENABLE_LIBDFX_TIME
-	struct timeval total_t1, total_t0, load_t1, load_t0;
-	double total_time, load_time;
 
-	gettimeofday(&total_t0, NULL);
-#endif
+	package_node = NULL;
+	rec.load_path = -1;
+	start = dfx_stats_now();
+	/* A timed load is recorded once, by dfx_cfg_load_timed() */
+	trace_t0 = timed_load_self == NULL ? dfx_trace_begin() : 0;
+	DFX_PROBE1(cfg_load_entry, package_id);
 	if (package_id < 0) {
-		printf("%s: Invalid package id\n", __func__);
+		DFX_ERR("%s: Invalid package id", __func__);
 		ret = -DFX_INVALID_PACKAGE_ID_ERROR;
 		goto END;
 	}
 
 	package_node = get_package(package_id);
 	if (package_node == NULL) {
-		printf("%s: fail to get package_node\n", __func__);
+		DFX_ERR("%s: fail to get package_node", __func__);
 		ret = -DFX_GET_PACKAGE_ERROR;
 		goto END;
 	}
 
-	if (!(package_node->flags & DFX_EXTERNAL_CONFIG_EN)) {
-		fd = open("/dev/fpga0", O_RDWR);
+	if (package_node->flags &
+	    (DFX_UID_SKIP_ACTIVE_EN | DFX_UID_CHECK_PARENT_EN)) {
+		ret = package_uid_check(package_node);
+		if (ret == 1 && (package_node->flags & DFX_UID_SKIP_ACTIVE_EN)) {
+			DFX_INFO("%s: package %d is already active", __func__,
+				 package_id);
+			ret = 0;
+			goto END;
+		}
+		if (ret == -(int)DFX_UID_PARENT_ERROR &&
+		    (package_node->flags & DFX_UID_CHECK_PARENT_EN)) {
+			DFX_ERR("%s: parent of package %d is not active",
+				__func__, package_id);
+			goto END;
+		}
+		ret = 0;
+	}
+
+	/* Serialize against other packages bound to the same FPGA manager */
+	mgr = package_node->mgr;
+	pthread_mutex_lock(&mgr->lock);
+	ktrace = dfx_ktrace_begin();
+
+	if (timed_load_self != NULL && timed_load_abandoned(timed_load_self)) {
+		DFX_INFO("%s: package %d is past its deadline, not loaded",
+			 __func__, package_id);
+		ret = -DFX_LOAD_DEADLINE_ERROR;
+		goto UNLOCK;
+	}
+
+	if ((package_node->flags & DFX_LOAD_MASK) == DFX_LOAD_AUTO &&
+	    package_node->load_path == DFX_LOAD_PATH_FIRMWARE)
+		package_auto_promote(package_node, &rec);
+	if (!(package_node->flags & DFX_EXTERNAL_CONFIG_EN))
+		rec.load_path = package_node->load_path;
+
+	t0 = dfx_stats_now();
+	if (!(package_node->flags & DFX_EXTERNAL_CONFIG_EN) &&
+	    package_node->load_path == DFX_LOAD_PATH_FIRMWARE) {
+		/* The FPGA manager fetches the image when the overlay is applied */
+		snprintf(path_buf, sizeof(path_buf), "%x",
+			 package_node->flags & ~DFX_LIBRARY_FLAGS_MASK);
+		fpga_mgr_write_attr(mgr->name, "flags", path_buf);
+		if (package_node->flags & DFX_ENCRYPTION_USERKEY_EN) {
+			fpga_mgr_write_attr(mgr->name, "key",
+					    package_node->aes_key);
+		}
+	} else if (!(package_node->flags & DFX_EXTERNAL_CONFIG_EN)) {
+		snprintf(path_buf, sizeof(path_buf), "%s/%s",
+			 dfx_root(DFX_ROOT_DEV), mgr->name);
+		fd = open(path_buf, O_RDWR);
 		if (fd < 0) {
-			printf("%s: Cannot open device file...\n", __func__);
+			DFX_ERR("%s: Cannot open device file...", __func__);
 			ret = -DFX_FAIL_TO_OPEN_DEV_NODE;
-			goto END;
+			goto UNLOCK;
 		}
-		dfx_set_fpga_flags(package_node->flags);
+		snprintf(path_buf, sizeof(path_buf), "%x",
+			 package_node->flags & ~DFX_LIBRARY_FLAGS_MASK);
+		fpga_mgr_write_attr(mgr->name, "flags", path_buf);
 		if (package_node->flags & DFX_ENCRYPTION_USERKEY_EN) {
-			dfx_set_fpga_key(package_node->aes_key);
+			fpga_mgr_write_attr(mgr->name, "key",
+					    package_node->aes_key);
 		}
 
-        buffd = package_node->dmabuf_info->dma_buffd;
-        /* Send dmabuf-fd to the FPGA Manager */
-        ioctl(fd, DFX_IOCTL_LOAD_DMA_BUFF, &buffd);
+		if (package_node->flags & DFX_VERIFY_ON_LOAD_EN) {
+			t0 = dfx_stats_now();
+			ret = verify_dmabuf(package_node);
+			t0 = dfx_stats_phase_end(&rec, DFX_PHASE_VERIFY, t0);
+			if (ret) {
+				close(fd);
+				goto UNLOCK;
+			}
+		}
+
+        buffd = package_node->dma_buffd;
+	/* A memfd only stands in for a dmabuf, the manager cannot DMA from it */
+	if (package_node->dmabuf_info->backend != DMA_BUFFER_MEMFD) {
+		/* Send dmabuf-fd to the FPGA Manager */
+		DFX_PROBE2(ioctl_load_dma_buff_entry, package_id, buffd);
+		err = ioctl(fd, DFX_IOCTL_LOAD_DMA_BUFF, &buffd);
+		DFX_PROBE2(ioctl_load_dma_buff_return, package_id, err);
+		if (err < 0)
+			err = errno;
+	}
         close(fd);
+	t0 = dfx_stats_phase_end(&rec, DFX_PHASE_IOCTL, t0);
+	if (err) {
+		DFX_ERR("%s: Failed to hand the dmabuf to `%s`: %s", __func__,
+			mgr->name, strerror(err));
+		ret = -DFX_IMAGE_CONFIG_ERROR;
+		goto UNLOCK;
+	}
     }
 
-	snprintf(path_buf, sizeof(path_buf), "%s/%s_image_%lu", DTBO_ROOT_DIR,
-			 package_node->package_name, package_node->package_id);
-
-	dfx_set_firmware_search_path(package_node->load_image_path);
+	fw_path_acquire(package_node->load_image_path);
 
-	len = strlen(path_buf) + 1;
-	overlay_dir_path = (char *) calloc(len, sizeof(char));
-	strncpy(overlay_dir_path, path_buf, len);
-	package_node->load_image_overlay_pck_path = overlay_dir_path;
+	t0 = dfx_stats_now();
 	if (mkdir(package_node->load_image_overlay_pck_path, 0755)) {
-		printf("%s: Failed to create overlay dir `%s`\n", __func__,
+		DFX_ERR("%s: Failed to create overlay dir `%s`", __func__,
 			   package_node->load_image_overlay_pck_path);
-		return -1;
+		fw_path_release(false);
+		ret = -DFX_IMAGE_CONFIG_ERROR;
+		goto UNLOCK;
 	}
-	printf("%s: Created overlay at `%s`\n", __func__,
+	DFX_INFO("%s: Created overlay at `%s`", __func__,
 		   package_node->load_image_overlay_pck_path);
+	t0 = dfx_stats_phase_end(&rec, DFX_PHASE_OVERLAY_MKDIR, t0);
 
-
-#ifdef ENABLE_LIBDFX_TIME
-	gettimeofday(&load_t0, NULL);
-#endif
 	// Trigger overlay load
-	dfx_set_overlay_path(package_node->load_image_overlay_pck_path,
-						 package_node->load_image_dtbo_name);
-#ifdef ENABLE_LIBDFX_TIME
-	gettimeofday(&load_t1, NULL);
-#endif
+	applied = apply_overlay(package_node,
+				package_node->load_image_overlay_pck_path,
+				DFX_PKG_ENTRY_IMAGE_DTBO,
+				package_node->load_image_dtbo_name);
+	t0 = dfx_stats_phase_end(&rec, DFX_PHASE_OVERLAY_APPLY, t0);
 	// check FPGA state is operating
 	if (!(package_node->flags & DFX_EXTERNAL_CONFIG_EN)) {
-		dfx_get_fpga_state(state_buf, sizeof(state_buf));
+		fpga_mgr_read_attr(mgr->name, "state", state_buf,
+				   sizeof(state_buf));
+		t0 = dfx_stats_phase_end(&rec, DFX_PHASE_STATE_CHECK, t0);
+		DFX_PROBE2(state_readback, package_id, (const char *)state_buf);
 		if (strcmp(state_buf, "operating") != 0) {
-			err = dfx_get_error(path_buf);
+			err = dfx_get_error(state_buf);
+			rec.fw_error = err;
 			remove_overlay_dir(package_node->load_image_overlay_pck_path);
-			printf("%s: Image configuration failed with error: 0x%x\n", __func__,
+			DFX_ERR("%s: Image configuration failed with error: 0x%x", __func__,
 				   err);
 			if (package_node->xilplatform == ZYNQMP_PLATFORM)
 				zynqmp_print_err_msg(err);
-			dfx_set_firmware_search_path("");
+			fw_path_release(true);
 			ret = -DFX_IMAGE_CONFIG_ERROR;
-			goto END;
+			goto UNLOCK;
 		}
 	}
 
 	// Check that the overlay path is still written
-	dfx_get_overlay_path(package_node->load_image_overlay_pck_path, state_buf,
-						 sizeof(state_buf));
-	if (strcmp(state_buf, package_node->load_image_dtbo_name) != 0) {
-		printf("%s: Image configuration failed\n", __func__);
+	if (package_node->pkg == NULL) {
+		dfx_get_overlay_path(package_node->load_image_overlay_pck_path,
+				     state_buf, sizeof(state_buf));
+		applied = strcmp(state_buf, package_node->load_image_dtbo_name);
+	}
+	dfx_stats_phase_end(&rec, DFX_PHASE_STATE_CHECK, t0);
+	if (applied) {
+		DFX_ERR("%s: Image configuration failed", __func__);
 		remove_overlay_dir(package_node->load_image_overlay_pck_path);
-		dfx_set_firmware_search_path("");
+		fw_path_release(true);
 		ret = -DFX_IMAGE_CONFIG_ERROR;
+	} else {
+		fw_path_release(false);
+		configured = true;
+	}
+
+	if (rec.load_path == DFX_LOAD_PATH_FIRMWARE && ret == 0) {
+		package_node->fw_loads++;
+		package_node->fw_load_ns += dfx_stats_now() - start;
 	}
 
+UNLOCK:
+	if (ktrace)
+		dfx_ktrace_end(&rec, start);
+	pthread_mutex_unlock(&mgr->lock);
 END:
-#ifdef ENABLE_LIBDFX_TIME
-	gettimeofday(&total_t1, NULL);
-	total_time = gettime(total_t0, total_t1);
-	load_time =  gettime(load_t0, load_t1);
-	printf("%s: Image load time from pre-allocated buffer: %f Milli Seconds\n\r",
-	       __func__, load_time);
-	printf("%s API Total time taken: %f Milli Seconds\n\r", __func__, total_time);
-#endif
+	rec.result = ret;
+	dfx_stats_phase_end(&rec, DFX_PHASE_LOAD, start);
+	dfx_stats_commit(package_node ? &package_node->stats : NULL, &rec, 1);
+	if (configured)
+		dfx_stats_ring_add(&package_node->load_history,
+				   rec.phase_ns[DFX_PHASE_LOAD]);
+	DFX_WATCH_NOTIFY(DFX_WATCH_LOAD,
+			 package_node ? package_node->mgr->name : NULL,
+			 package_id, ret);
+	DFX_TRACE_CALL(DFX_TRACE_OP_CFG_LOAD, trace_t0, package_id, ret, 0);
+	DFX_PROBE2(cfg_load_return, package_id, ret);
+	return ret;
+}
+
+/* This API is dfx_cfg_load() with an upper bound on the time it takes.
+ *
+ * It returns DFX_LOAD_DEADLINE_ERROR right away, without doing anything,
+ * if the deadline has passed or the median of the last successful loads
+ * of the package does not fit before it. Otherwise the load runs on a
+ * separate thread and the call returns when the load finishes or at the
+ * deadline, whichever comes first.
+ *
+ * A load still waiting for the FPGA manager at the deadline is cancelled.
+ * One that has started keeps running: its result is reported in
+ * dfx_get_stats() last_load and by DFX_WATCH_LOAD, and a failure removes
+ * its overlay as it does for dfx_cfg_load(). dfx_cfg_remove() and further
+ * loads on the same FPGA manager wait for it, and dfx_cfg_destroy() of the
+ * package waits until it returns.
+ *
+ * int package_id: Unique package_id value which was returned by dfx_cfg_init.
+ * unsigned long long deadline_ns: Absolute CLOCK_MONOTONIC time, in ns.
+ *
+ * Return: returns zero on success or Error code on failure.
+ */
+int dfx_cfg_load_timed(int package_id, unsigned long long deadline_ns)
+{
+	struct dfx_package_node *package_node;
+	unsigned long long now, expected, trace_t0;
+	struct timed_load *job;
+	pthread_condattr_t cattr;
+	pthread_attr_t tattr;
+	pthread_t thread;
+	struct timespec ts;
+	char budget[24];
+	int ret;
+
+	trace_t0 = dfx_trace_begin();
+	DFX_PROBE2(cfg_load_timed_entry, package_id, deadline_ns);
+	package_node = get_package_timed(package_id);
+	if (package_id <= 0 || package_node == NULL) {
+		DFX_ERR("%s: Invalid package id %d", __func__, package_id);
+		ret = -DFX_INVALID_PACKAGE_ID_ERROR;
+		goto END;
+	}
+
+	expected = dfx_stats_ring_median(&package_node->load_history,
+					 TIMED_LOAD_HISTORY);
+	now = dfx_stats_now();
+	if (now + expected > deadline_ns) {
+		DFX_INFO("%s: package %d needs %llu us, %lld us left", __func__,
+			 package_id, expected / 1000,
+			 ((long long)deadline_ns - (long long)now) / 1000);
+		dfx_stats_deadline_miss(&package_node->stats);
+		put_package_timed(package_node);
+		ret = -DFX_LOAD_DEADLINE_ERROR;
+		goto END;
+	}
+
+	job = calloc(1, sizeof(*job));
+	if (job == NULL) {
+		put_package_timed(package_node);
+		ret = -DFX_INSUFFICIENT_MEM;
+		goto END;
+	}
+	job->package_node = package_node;
+	job->package_id = package_id;
+	pthread_mutex_init(&job->lock, NULL);
+	pthread_condattr_init(&cattr);
+	pthread_condattr_setclock(&cattr, CLOCK_MONOTONIC);
+	pthread_cond_init(&job->cond, &cattr);
+	pthread_condattr_destroy(&cattr);
+
+	pthread_attr_init(&tattr);
+	pthread_attr_setdetachstate(&tattr, PTHREAD_CREATE_DETACHED);
+	ret = pthread_create(&thread, &tattr, timed_load_worker, job);
+	pthread_attr_destroy(&tattr);
+	if (ret) {
+		DFX_ERR("%s: Failed to start the load thread", __func__);
+		timed_load_free(job);
+		put_package_timed(package_node);
+		ret = -DFX_INSUFFICIENT_MEM;
+		goto END;
+	}
+
+	ts.tv_sec = deadline_ns / 1000000000ULL;
+	ts.tv_nsec = deadline_ns % 1000000000ULL;
+	pthread_mutex_lock(&job->lock);
+	while (!job->done &&
+	       pthread_cond_timedwait(&job->cond, &job->lock, &ts) != ETIMEDOUT)
+		;
+	if (job->done) {
+		ret = job->ret;
+		pthread_mutex_unlock(&job->lock);
+		timed_load_free(job);
+		goto END;
+	}
+	/* The package is valid until the load thread sees this */
+	dfx_stats_deadline_miss(&package_node->stats);
+	job->abandoned = true;
+	pthread_mutex_unlock(&job->lock);
+
+	DFX_WARN("%s: package %d missed its deadline", __func__, package_id);
+	ret = -DFX_LOAD_DEADLINE_ERROR;
+END:
+	/* The deadline is kept relative to the call, the clock is per boot */
+	if (trace_t0) {
+		snprintf(budget, sizeof(budget), "%lld",
+			 (long long)(deadline_ns - trace_t0));
+		DFX_TRACE_CALL_STR(DFX_TRACE_OP_CFG_LOAD_TIMED, trace_t0,
+				   package_id, ret, 0, budget);
+	}
+	DFX_PROBE2(cfg_load_timed_return, package_id, ret);
 	return ret;
 }
 
@@ -703,26 +1929,23 @@ END:
  */
 int dfx_cfg_drivers_load(int package_id)
 {
+	unsigned long long trace_t0;
 	FPGA_NODE *package_node;
-	char path_buf[MAX_CMD_LEN];
-	int len, ret = 0;
-	char *overlay_dir_path;
+	struct dfx_fpga_mgr *mgr;
+	int ret = 0, applied;
 	char state_buf[128] = {};
-#ifdef ENABLE_LIBDFX_TIME
-	struct timeval t1, t0;
-	double time;
 
-	gettimeofday(&t0, NULL);
-#endif
+	trace_t0 = dfx_trace_begin();
+	DFX_PROBE1(cfg_drivers_load_entry, package_id);
 	if (package_id < 0) {
-		printf("%s: Invalid package id\n", __func__);
+		DFX_ERR("%s: Invalid package id", __func__);
 		ret = -DFX_INVALID_PACKAGE_ID_ERROR;
 		goto END;
 	}
 
 	package_node = get_package(package_id);
 	if (package_node == NULL) {
-		printf("%s: fail to get package_node\n", __func__);
+		DFX_ERR("%s: fail to get package_node", __func__);
 		ret = -DFX_GET_PACKAGE_ERROR;
 		goto END;
 	}
@@ -732,43 +1955,44 @@ int dfx_cfg_drivers_load(int package_id)
 		goto END;
 	}
 
-	dfx_set_firmware_search_path(package_node->load_drivers_dtbo_path);
-
-	snprintf(path_buf, sizeof(path_buf),
-			 "%s/%s_driver_%lu",
-			 DTBO_ROOT_DIR,
-			 package_node->package_name,
-			 package_node->package_id);
-	len = (int)strlen(path_buf) + 1;
-	overlay_dir_path = (char *) calloc((len), sizeof(char));
-	strncpy(overlay_dir_path, path_buf, len);
-	package_node->load_drivers_overlay_pck_path = overlay_dir_path;
+	mgr = package_node->mgr;
+	pthread_mutex_lock(&mgr->lock);
+	fw_path_acquire(package_node->load_drivers_dtbo_path);
 
-	if (mkdir(package_node->load_image_overlay_pck_path, 0755)) {
-		printf("%s: Failed to create overlay dir `%s`\n",
-			   __func__, package_node->load_image_overlay_pck_path);
-		return -1;
+	if (mkdir(package_node->load_drivers_overlay_pck_path, 0755)) {
+		DFX_ERR("%s: Failed to create overlay dir `%s`",
+			   __func__, package_node->load_drivers_overlay_pck_path);
+		fw_path_release(false);
+		ret = -DFX_IMAGE_CONFIG_ERROR;
+		goto UNLOCK;
 	}
 
-	dfx_set_overlay_path(package_node->load_drivers_overlay_pck_path,
-						 package_node->load_drivers_dtbo_name);
+	applied = apply_overlay(package_node,
+				package_node->load_drivers_overlay_pck_path,
+				DFX_PKG_ENTRY_DRIVERS_DTBO,
+				package_node->load_drivers_dtbo_name);
 
 	// Check that the overlay path is still written
-	dfx_get_overlay_path(package_node->load_image_overlay_pck_path, state_buf,
-						 sizeof(state_buf));
-	if (strcmp(state_buf, package_node->load_image_dtbo_name) != 0) {
-		printf("%s: Drivers DTBO config failed\n", __func__);
-		remove_overlay_dir(package_node->load_image_overlay_pck_path);
-		dfx_set_firmware_search_path("");
+	if (package_node->pkg == NULL) {
+		dfx_get_overlay_path(package_node->load_drivers_overlay_pck_path,
+				     state_buf, sizeof(state_buf));
+		applied = strcmp(state_buf,
+				 package_node->load_drivers_dtbo_name);
+	}
+	if (applied) {
+		DFX_ERR("%s: Drivers DTBO config failed", __func__);
+		remove_overlay_dir(package_node->load_drivers_overlay_pck_path);
+		fw_path_release(true);
 		ret = -DFX_DRIVER_CONFIG_ERROR;
+	} else {
+		fw_path_release(false);
 	}
 
+UNLOCK:
+	pthread_mutex_unlock(&mgr->lock);
 END:
-#ifdef ENABLE_LIBDFX_TIME
-	gettimeofday(&t1, NULL);
-	time = gettime(t0, t1);
-	printf("%s API Time taken: %f Milli Seconds\n\r", __func__, time);
-#endif
+	DFX_TRACE_CALL(DFX_TRACE_OP_CFG_DRIVERS_LOAD, trace_t0, package_id, ret, 0);
+	DFX_PROBE2(cfg_drivers_load_return, package_id, ret);
 	return ret;
 }
 
@@ -780,29 +2004,29 @@ END:
  */
 int dfx_cfg_remove(int package_id)
 {
-	FPGA_NODE *package_node;
+	FPGA_NODE *package_node = NULL;
 	char command[MAX_CMD_LEN];
+	unsigned long long t0, trace_t0;
 	int ret = 0;
 	DIR *FD;
-#ifdef ENABLE_LIBDFX_TIME
-	struct timeval t1, t0;
-	double time;
 
-	gettimeofday(&t0, NULL);
-#endif
+	trace_t0 = dfx_trace_begin();
+	DFX_PROBE1(cfg_remove_entry, package_id);
 	if (package_id < 0) {
-		printf("%s: Invalid package id\n", __func__);
+		DFX_ERR("%s: Invalid package id", __func__);
 		ret = -DFX_INVALID_PACKAGE_ID_ERROR;
 		goto END;
 	}
 
 	package_node = get_package(package_id);
 	if (package_node == NULL) {
-		printf("%s: fail to get package_node\n", __func__);
+		DFX_ERR("%s: fail to get package_node", __func__);
 		ret = -DFX_GET_PACKAGE_ERROR;
 		goto END;
 	}
 
+	pthread_mutex_lock(&package_node->mgr->lock);
+	t0 = dfx_stats_now();
 	if (package_node->load_drivers_overlay_pck_path != NULL) {
 		FD = opendir(package_node->load_drivers_overlay_pck_path);
 		if (FD) {
@@ -818,13 +2042,16 @@ int dfx_cfg_remove(int package_id)
 			remove_overlay_dir(package_node->load_image_overlay_pck_path);
 		}
 	}
+	dfx_stats_record(&package_node->stats, DFX_PHASE_TEARDOWN,
+			 dfx_stats_now() - t0);
+	pthread_mutex_unlock(&package_node->mgr->lock);
 
 END:
-#ifdef ENABLE_LIBDFX_TIME
-	gettimeofday(&t1, NULL);
-	time = gettime(t0, t1);
-	printf("%s API Time taken: %f Milli Seconds\n\r", __func__, time);
-#endif
+	DFX_WATCH_NOTIFY(DFX_WATCH_REMOVE,
+			 package_node ? package_node->mgr->name : NULL,
+			 package_id, ret);
+	DFX_TRACE_CALL(DFX_TRACE_OP_CFG_REMOVE, trace_t0, package_id, ret, 0);
+	DFX_PROBE2(cfg_remove_return, package_id, ret);
 	return ret;
 }
 
@@ -839,42 +2066,315 @@ int dfx_cfg_destroy(int package_id)
 {
 	FPGA_NODE *package_node;
 	char command[MAX_CMD_LEN];
+	unsigned long long t0, trace_t0;
 	int ret = 0;
-#ifdef ENABLE_LIBDFX_TIME
-	struct timeval t1, t0;
-	double time;
 
-	gettimeofday(&t0, NULL);
-#endif
+	trace_t0 = dfx_trace_begin();
+	DFX_PROBE1(cfg_destroy_entry, package_id);
 	if (package_id < 0) {
-		printf("%s: Invalid package id\n", __func__);
+		DFX_ERR("%s: Invalid package id", __func__);
 		ret = -DFX_INVALID_PACKAGE_ID_ERROR;
 		goto END;
 	}
 
+	/* Waits for a prefetch of this package to finish */
+	prefetch_cancel(package_id);
+
 	package_node = get_package(package_id);
 	if (package_node == NULL) {
-		printf("%s: fail to get package_node\n", __func__);
+		DFX_ERR("%s: fail to get package_node", __func__);
 		ret = -DFX_GET_PACKAGE_ERROR;
 		goto END;
 	}
 
-	if (!(package_node->flags & DFX_EXTERNAL_CONFIG_EN)) {
+	/* Waits for a timed load that went on past its deadline */
+	package_wait_idle(package_node);
+
+	if (package_node->dmabuf_info != NULL) {
 		/* This call will do the following things
 		 * unmap the buffer properly
 		 * close the buffer fd (Free the Dmabuf memory)
 		 * Finally, close the client fd
 		 */
+		pthread_mutex_lock(&package_node->mgr->lock);
+		t0 = dfx_stats_now();
 		close_dma_buffer(package_node->dmabuf_info);
+		if (!package_node->dmabuf_info->is_imported &&
+		    package_node->dmabuf_info->backend == DMA_BUFFER_DMA_HEAP)
+			dfx_stats_cma(NULL,
+				-(long long)package_node->dmabuf_info->dma_buflen);
+		dfx_stats_record(NULL, DFX_PHASE_TEARDOWN,
+				 dfx_stats_now() - t0);
+		pthread_mutex_unlock(&package_node->mgr->lock);
+	}
+
+	if (package_node->prefetch_bytes) {
+		pthread_mutex_lock(&prefetch_lock);
+		prefetch_used -= package_node->prefetch_bytes;
+		pthread_mutex_unlock(&prefetch_lock);
 	}
 
 	ret = destroy_package(package_node->package_id);
 END:
-#ifdef ENABLE_LIBDFX_TIME
-	gettimeofday(&t1, NULL);
-	time = gettime(t0, t1);
-	printf("%s API Time taken: %f Milli Seconds\n\r", __func__, time);
-#endif
+	DFX_TRACE_CALL(DFX_TRACE_OP_CFG_DESTROY, trace_t0, package_id, ret, 0);
+	DFX_PROBE2(cfg_destroy_return, package_id, ret);
+	return ret;
+}
+
+/* This API tells the library that a package is expected to be loaded in
+ * @expected_ms milliseconds. A background thread running at idle I/O
+ * priority reads the image into the page cache shortly before, and stages
+ * the dmabuf of a DFX_LOAD_AUTO package that still uses the firmware
+ * loader, within the budget set by dfx_set_prefetch_budget(). It never
+ * waits for a load in progress. A later hint for the same package replaces
+ * the earlier one if it is due sooner. Hints for packages that already have
+ * their image in a dmabuf are accepted and ignored.
+ *
+ * int package_id: Unique package_id value which was returned by dfx_cfg_init.
+ * unsigned int expected_ms: Time until the expected dfx_cfg_load() call.
+ *
+ * Return: returns zero on success or Error code on failure.
+ */
+int dfx_cfg_hint(int package_id, unsigned int expected_ms)
+{
+	unsigned long long due, trace_t0;
+	int i, ret = 0;
+
+	trace_t0 = dfx_trace_begin();
+	DFX_PROBE2(cfg_hint_entry, package_id, expected_ms);
+	if (package_id <= 0 || get_package(package_id) == NULL) {
+		DFX_ERR("%s: Invalid package id %d", __func__, package_id);
+		ret = -DFX_INVALID_PACKAGE_ID_ERROR;
+		goto END;
+	}
+
+	pthread_once(&prefetch_once, prefetch_start);
+	due = dfx_stats_now() + expected_ms * 1000000ULL;
+
+	pthread_mutex_lock(&prefetch_lock);
+	if (!prefetch_running) {
+		DFX_ERR("%s: No prefetch thread", __func__);
+		ret = -DFX_INSUFFICIENT_MEM;
+		goto UNLOCK;
+	}
+	for (i = 0; i < prefetch_len; i++) {
+		if (prefetch_queue[i].package_id == package_id) {
+			if (due < prefetch_queue[i].due_ns)
+				prefetch_queue[i].due_ns = due;
+			goto WAKE;
+		}
+	}
+	if (prefetch_len == PREFETCH_QUEUE_LEN) {
+		DFX_ERR("%s: %d hints are already queued", __func__,
+			PREFETCH_QUEUE_LEN);
+		ret = -DFX_INSUFFICIENT_MEM;
+		goto UNLOCK;
+	}
+	prefetch_queue[prefetch_len].package_id = package_id;
+	prefetch_queue[prefetch_len].due_ns = due;
+	prefetch_len++;
+WAKE:
+	pthread_cond_signal(&prefetch_cond);
+UNLOCK:
+	pthread_mutex_unlock(&prefetch_lock);
+END:
+	DFX_TRACE_CALL(DFX_TRACE_OP_CFG_HINT, trace_t0, package_id, ret,
+		       expected_ms);
+	DFX_PROBE2(cfg_hint_return, package_id, ret);
+	return ret;
+}
+
+/* This API sets how much dmabuf memory dfx_cfg_hint() may stage ahead of
+ * loads, 64 MiB by default. Buffers already staged are kept, they count
+ * against the budget until their package is destroyed.
+ *
+ * size_t bytes: New budget, 0 limits prefetching to the page cache.
+ *
+ * Return: returns zero.
+ */
+int dfx_set_prefetch_budget(size_t bytes)
+{
+	pthread_mutex_lock(&prefetch_lock);
+	prefetch_budget = bytes;
+	pthread_mutex_unlock(&prefetch_lock);
+
+	return 0;
+}
+
+/* This API copies the latency statistics of a package, or the library-wide
+ * statistics, into the user provided structure.
+ *
+ * int package_id: Unique package_id value which was returned by dfx_cfg_init,
+ *                 or 0 for the statistics accumulated over all packages
+ *                 (including destroyed ones).
+ * struct dfx_stats *stats: User buffer address.
+ *
+ * Return: returns zero on success or Error code on failure.
+ */
+int dfx_get_stats(int package_id, struct dfx_stats *stats)
+{
+	FPGA_NODE *package_node = NULL;
+
+	if (stats == NULL || package_id < 0) {
+		DFX_ERR("%s: Invalid input args", __func__);
+		return -DFX_INVALID_PARAM;
+	}
+
+	if (package_id > 0) {
+		package_node = get_package(package_id);
+		if (package_node == NULL) {
+			DFX_ERR("%s: fail to get package_node", __func__);
+			return -DFX_GET_PACKAGE_ERROR;
+		}
+	}
+
+	dfx_stats_copy(package_node ? &package_node->stats : NULL, stats);
+
+	return 0;
+}
+
+/* This API returns the digest of the image held in the dmabuf of a package.
+ * The digest is computed while dfx_cfg_init*() copies the image, so it
+ * covers exactly the bytes that will be handed to the FPGA manager.
+ *
+ * int package_id: Unique package_id value which was returned by dfx_cfg_init.
+ * struct dfx_package_digest *digest: User buffer address.
+ *
+ * Return: returns zero on success or Error code on failure.
+ */
+int dfx_get_package_digest(int package_id, struct dfx_package_digest *digest)
+{
+	FPGA_NODE *package_node;
+
+	if (digest == NULL || package_id <= 0) {
+		DFX_ERR("%s: Invalid input args", __func__);
+		return -DFX_INVALID_PARAM;
+	}
+
+	package_node = get_package(package_id);
+	if (package_node == NULL) {
+		DFX_ERR("%s: fail to get package_node", __func__);
+		return -DFX_GET_PACKAGE_ERROR;
+	}
+
+	*digest = package_node->digest;
+
+	return 0;
+}
+
+/* This API returns the format and size of the image of a package. For .bit
+ * images the header is parsed at init time: its design name, part, date and
+ * time fields are returned here, and it is stripped so that only the
+ * configuration data, converted to .bin byte order, reaches the dmabuf.
+ *
+ * int package_id: Unique package_id value which was returned by dfx_cfg_init.
+ * struct dfx_package_info *info: User buffer address.
+ *
+ * Return: returns zero on success or Error code on failure.
+ */
+int dfx_get_package_info(int package_id, struct dfx_package_info *info)
+{
+	FPGA_NODE *package_node;
+
+	if (info == NULL || package_id <= 0) {
+		DFX_ERR("%s: Invalid input args", __func__);
+		return -DFX_INVALID_PARAM;
+	}
+
+	package_node = get_package(package_id);
+	if (package_node == NULL) {
+		DFX_ERR("%s: fail to get package_node", __func__);
+		return -DFX_GET_PACKAGE_ERROR;
+	}
+
+	*info = package_node->info;
+
+	return 0;
+}
+
+/* This API copies the metadata of a package initialized from a .dfxpkg
+ * container: the "key=value" lines stored by dfx_pack. The copy is
+ * null-terminated and truncated to fit.
+ *
+ * int package_id: Unique package_id value which was returned by dfx_cfg_init.
+ * char *buffer: User buffer address.
+ * size_t buf_size: User buffer size.
+ *
+ * Return: Number of bytes of metadata, 0 if the package has none,
+ *         or Error code on failure.
+ */
+int dfx_get_package_meta(int package_id, char *buffer, size_t buf_size)
+{
+	const struct dfx_pkg_payload *meta;
+	FPGA_NODE *package_node;
+	size_t len = 0;
+
+	if (buffer == NULL || buf_size == 0 || package_id <= 0) {
+		DFX_ERR("%s: Invalid input args", __func__);
+		return -DFX_INVALID_PARAM;
+	}
+
+	package_node = get_package(package_id);
+	if (package_node == NULL) {
+		DFX_ERR("%s: fail to get package_node", __func__);
+		return -DFX_GET_PACKAGE_ERROR;
+	}
+
+	if (package_node->pkg != NULL) {
+		meta = &package_node->pkg->entry[DFX_PKG_ENTRY_META];
+		len = meta->size < buf_size ? meta->size : buf_size - 1;
+		if (len)
+			memcpy(buffer, meta->data, len);
+	}
+	buffer[len] = '\0';
+
+	return len;
+}
+
+/* This API decodes the PDI meta header of the image held in the dmabuf of a
+ * package, without touching the file or the firmware again.
+ *
+ * int package_id: Unique package_id value which was returned by dfx_cfg_init.
+ * struct dfx_pdi_meta *meta: User buffer address.
+ *
+ * Return: returns zero on success or Error code on failure.
+ */
+int dfx_get_package_pdi_meta(int package_id, struct dfx_pdi_meta *meta)
+{
+	struct dfx_pdi_layout layout;
+	struct dma_buffer_info *info;
+	FPGA_NODE *package_node;
+	size_t len;
+	int ret;
+
+	if (meta == NULL || package_id <= 0) {
+		DFX_ERR("%s: Invalid input args", __func__);
+		return -DFX_INVALID_PARAM;
+	}
+
+	package_node = get_package(package_id);
+	if (package_node == NULL) {
+		DFX_ERR("%s: fail to get package_node", __func__);
+		return -DFX_GET_PACKAGE_ERROR;
+	}
+
+	info = package_node->dmabuf_info;
+	len = package_node->digest.length;
+	if (info == NULL || len == 0) {
+		DFX_ERR("%s: package has no image in a dmabuf", __func__);
+		return -DFX_INVALID_PARAM;
+	}
+
+	if (sync_dma_buffer(info, DMA_BUF_SYNC_START | DMA_BUF_SYNC_READ)) {
+		DFX_ERR("%s: sync start failed", __func__);
+		return -DFX_DMABUF_ALLOC_ERROR;
+	}
+	ret = dfx_pdi_parse((const unsigned char *)info->dma_buffer +
+			    (info->dma_buflen - len), len, &layout, meta);
+	sync_dma_buffer(info, DMA_BUF_SYNC_END | DMA_BUF_SYNC_READ);
+	if (ret)
+		DFX_ERR("%s: package image is not a valid PDI", __func__);
+
 	return ret;
 }
 
@@ -888,298 +2388,564 @@ END:
  */
 int dfx_get_active_uid_list(int *buffer)
 {
-	const char* filename = "/sys/devices/platform/firmware:versal-firmware/uid-read";
-	int platform, ret = 0, count = 0;
-	FILE* fd;
-#ifdef ENABLE_LIBDFX_TIME
-	struct timeval t1, t0;
-	double time;
-
-	gettimeofday(&t0, NULL);
-#endif
-	platform = dfx_getplatform();
-	if (platform != VERSAL_PLATFORM) {
-		ret = -DFX_INVALID_PLATFORM_ERROR;
-		goto END;
-	}
+	unsigned long long trace_t0;
+	int ret;
 
-	fd = fopen(filename, "rb");
-	if (!fd) {
-		printf("Unable to open file!");
-		ret = -DFX_FAIL_TO_OPEN_BIN_FILE;
+	trace_t0 = dfx_trace_begin();
+	DFX_PROBE1(get_active_uid_list_entry, buffer);
+	ret = get_active_uid_list(buffer, SIZE_MAX);
+	DFX_TRACE_CALL(DFX_TRACE_OP_GET_ACTIVE_UID_LIST, trace_t0, 0, ret, 0);
+	DFX_PROBE2(get_active_uid_list_return, buffer, ret);
+	return ret;
+}
+
+/* This API populates buffer with {Node ID, Unique ID, Parent Unique ID, Function ID}
+ * for each applicable NodeID in the system, like dfx_get_active_uid_list(),
+ * but never writes more than buf_size bytes.
+ *
+ * The list is read from the firmware in bulk and cached. The cache is
+ * dropped when an image is loaded or removed through libdfx, or by
+ * dfx_invalidate_cache(), so polling it is cheap.
+ *
+ * buffer: User buffer address
+ * buf_size: User buffer size, in bytes.
+ *
+ * Return: Number of bytes copied in case of success.
+ *         or Negative value on failure.
+ */
+int dfx_get_active_uid_list_buf(int *buffer, size_t buf_size)
+{
+	unsigned long long trace_t0;
+	int ret;
+
+	trace_t0 = dfx_trace_begin();
+	DFX_PROBE1(get_active_uid_list_entry, buffer);
+	if (buffer == NULL) {
+		ret = -DFX_INVALID_PARAM;
 		goto END;
 	}
+	ret = get_active_uid_list(buffer, buf_size);
+END:
+	DFX_TRACE_CALL(DFX_TRACE_OP_GET_ACTIVE_UID_LIST, trace_t0, 0, ret,
+		       buf_size);
+	DFX_PROBE2(get_active_uid_list_return, buffer, ret);
+	return ret;
+}
+
+/* This API drops the cached UID list, PDI meta headers and FPGA manager
+ * platforms. Use it after the FPGA state was changed behind the library's
+ * back, e.g. by another process.
+ */
+void dfx_invalidate_cache(void)
+{
+	struct dfx_fpga_mgr *mgr;
+
+	uid_cache_invalidate();
+	dfx_pdi_cache_flush();
+
+	pthread_mutex_lock(&package_list_lock);
+	for (mgr = fpga_mgr_list; mgr != NULL; mgr = mgr->next)
+		__atomic_store_n(&mgr->platform, INVALID_PLATFORM,
+				 __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&package_list_lock);
+}
+
+/* This API copies the active UID tree: one entry per image loaded, with
+ * links to its parent and children. The tree is indexed once per change of
+ * the UID list, see dfx_get_active_uid_list_buf().
+ *
+ * struct dfx_uid_node *nodes: User buffer address.
+ * int max_nodes: Number of entries nodes can hold.
+ *
+ * Return: Number of entries in the tree, which may exceed max_nodes,
+ *         or Negative value on failure.
+ */
+int dfx_uid_tree(struct dfx_uid_node *nodes, int max_nodes)
+{
+	int ret;
 
-	while(!feof(fd)) {
-		fread(&buffer[count], sizeof(int), 1,fd);
-		count++;
+	if (nodes == NULL && max_nodes > 0)
+		return -DFX_INVALID_PARAM;
+
+	pthread_mutex_lock(&uid_cache_lock);
+	ret = uid_cache_refresh();
+	if (ret == 0) {
+		ret = uid_cache.index.count;
+		if (max_nodes > ret)
+			max_nodes = ret;
+		if (max_nodes > 0)
+			memcpy(nodes, uid_cache.index.nodes,
+			       max_nodes * sizeof(*nodes));
 	}
+	pthread_mutex_unlock(&uid_cache_lock);
 
-	fclose(fd);
-	ret = (count - 1) *  sizeof(int);
-END:
-#ifdef ENABLE_LIBDFX_TIME
-	gettimeofday(&t1, NULL);
-	time = gettime(t0, t1);
-	printf("%s API Time taken: %f Milli Seconds\n\r", __func__, time);
-#endif
 	return ret;
 }
 
+/* These APIs look up the entry of the active UID tree with the given UID,
+ * function ID, or node ID. The node ID names the region, so
+ * dfx_uid_find_region() reports the RM that occupies it. Lookups are hash
+ * table probes; the firmware is only read if the list changed.
+ *
+ * struct dfx_uid_node *node: User buffer address.
+ *
+ * Return: returns zero on success, DFX_UID_NOT_FOUND_ERROR if there is no
+ *         such entry, or another Error code on failure.
+ */
+int dfx_uid_find(unsigned int uid, struct dfx_uid_node *node)
+{
+	return uid_find(DFX_UID_KEY_UID, uid, node);
+}
+
+int dfx_uid_find_function(unsigned int function_id, struct dfx_uid_node *node)
+{
+	return uid_find(DFX_UID_KEY_FUNCTION_ID, function_id, node);
+}
+
+int dfx_uid_find_region(unsigned int node_id, struct dfx_uid_node *node)
+{
+	return uid_find(DFX_UID_KEY_NODE_ID, node_id, node);
+}
+
+/* This API matches the image UIDs of a PDI package, read when the package
+ * was initialized, against the active UID tree.
+ *
+ * int package_id: Unique package_id value which was returned by dfx_cfg_init.
+ *
+ * Return: 1 if every image of the package is already active,
+ *         0 if the package can be loaded,
+ *         -DFX_UID_PARENT_ERROR if the parent of one of its images is not
+ *         active, -DFX_UID_NOT_FOUND_ERROR if the package has no image UIDs,
+ *         or another Error code on failure.
+ */
+int dfx_package_uid_check(int package_id)
+{
+	FPGA_NODE *package_node;
+
+	if (package_id <= 0) {
+		DFX_ERR("%s: Invalid input args", __func__);
+		return -DFX_INVALID_PARAM;
+	}
+
+	package_node = get_package(package_id);
+	if (package_node == NULL) {
+		DFX_ERR("%s: fail to get package_node", __func__);
+		return -DFX_GET_PACKAGE_ERROR;
+	}
+
+	return package_uid_check(package_node);
+}
+
 /* This API populates buffer with meta-header info related to the user
- * provided PDI.
+ * provided PDI: the image header table, followed by the image headers and
+ * then the partition headers, as raw 32-bit words. The headers are read
+ * from the file directly and cached until the file changes;
+ * dfx_get_pdi_meta() returns them decoded.
  *
  * binfile: PDI Image.
  * buffer: User buffer address
- * buf_size : User buffer size.
+ * buf_size : User buffer size, in ints.
  *
- * Return: Number of bytes read from the firmware in case of success.
+ * Return: Number of bytes of meta-header copied in case of success.
  *         or Negative value on failure.
  */
 int dfx_get_meta_header(char *binfile, int *buffer, int buf_size)
 {
-	const char* filename = "/sys/devices/platform/firmware:versal-firmware/meta-header-read";
-	char command[2048], *token, *tmp, *tmp1;
-	int platform, ret = 0, count = 0;
-	FILE* fd;
-	DIR *FD;
-#ifdef ENABLE_LIBDFX_TIME
-	struct timeval t1, t0;
-	double time;
-
-	gettimeofday(&t0, NULL);
-#endif
-	platform = dfx_getplatform();
-	if (platform != VERSAL_PLATFORM) {
-		ret = -DFX_INVALID_PLATFORM_ERROR;
+	unsigned long long trace_t0;
+	int ret;
+
+	trace_t0 = dfx_trace_begin();
+	DFX_PROBE1(get_meta_header_entry, binfile);
+	if (binfile == NULL || buffer == NULL || buf_size <= 0) {
+		ret = -DFX_INVALID_PARAM;
 		goto END;
 	}
 
-	fd = fopen(binfile, "rb");
-	if (!fd) {
-		printf("Unable to open binary file!");
-		ret = -DFX_FAIL_TO_OPEN_BIN_FILE;
-		goto END;
+	ret = dfx_pdi_read_file(binfile, NULL, buffer,
+				(size_t)buf_size * sizeof(int));
+END:
+	DFX_TRACE_CALL_STR(DFX_TRACE_OP_GET_META_HEADER, trace_t0, 0, ret,
+			   buf_size, binfile);
+	DFX_PROBE2(get_meta_header_return, binfile, ret);
+	return ret;
+}
+
+static int read_package_container(struct dfx_package_node *package_node,
+				  const char *path)
+{
+	const struct dfx_pkg_payload *entry;
+	char buf[MAX_CMD_LEN], *name;
+	struct dfx_pkg *pkg;
+	size_t len;
+	int ret;
+
+	pkg = package_alloc(package_node, sizeof(*pkg));
+	if (pkg == NULL)
+		return -DFX_INSUFFICIENT_MEM;
+	ret = dfx_pkg_open(path, pkg);
+	if (ret)
+		return ret;
+	package_node->pkg = pkg;
+	package_node->package_path = package_strdup(package_node, path);
+
+	/* Unnamed containers are named after the file */
+	if (pkg->name[0] != '\0') {
+		package_node->package_name = package_strdup(package_node,
+							    pkg->name);
+	} else {
+		name = strrchr(path, '/');
+		name = name ? name + 1 : (char *)path;
+		package_node->package_name = package_strndup(package_node, name,
+					strlen(name) - strlen(DFX_PKG_SUFFIX));
 	}
-	fclose(fd);
 
-	dfx_set_firmware_search_path(binfile);
-	tmp = strdup(binfile);
-	while((token = strsep(&tmp, "/")))
-		tmp1 = token;
+	/*
+	 * The paths all name the container: they are only used to select the
+	 * firmware search path, the payloads are read from the mapping.
+	 */
+	package_node->load_image_path = package_node->package_path;
+	entry = &pkg->entry[DFX_PKG_ENTRY_IMAGE];
+	if (entry->data != NULL)
+		package_node->load_image_name = package_strdup(package_node,
+							       entry->name);
+
+	entry = &pkg->entry[DFX_PKG_ENTRY_IMAGE_DTBO];
+	package_node->load_image_dtbo_path = package_node->package_path;
+	package_node->load_image_dtbo_name = package_strdup(package_node,
+							    entry->name);
+
+	entry = &pkg->entry[DFX_PKG_ENTRY_DRIVERS_DTBO];
+	if (entry->data != NULL) {
+		package_node->load_drivers_dtbo_path =
+			package_node->package_path;
+		package_node->load_drivers_dtbo_name =
+			package_strdup(package_node, entry->name);
+		if (package_node->load_drivers_dtbo_name == NULL)
+			return -DFX_INSUFFICIENT_MEM;
+	}
 
-	snprintf(command, sizeof(command), "echo %s > /sys/devices/platform/firmware:versal-firmware/firmware", tmp1);
-	system(command);
+	/* The key itself is not stored in the container, only where it is */
+	entry = &pkg->entry[DFX_PKG_ENTRY_KEY_REF];
+	if (entry->data != NULL) {
+		len = strlen(path);
+		while (len > 0 && path[len - 1] != '/')
+			len--;
+		if (entry->size && entry->data[0] == '/')
+			len = 0;
+		if (len + entry->size >= sizeof(buf)) {
+			DFX_ERR("%s: key reference too long", __func__);
+			return -DFX_READ_PACKAGE_ERROR;
+		}
+		memcpy(buf, path, len);
+		memcpy(buf + len, entry->data, entry->size);
+		buf[len + entry->size] = '\0';
+		strip_trailing(buf, '\n');
+		package_node->load_aes_file_path = package_strdup(package_node,
+								  buf);
+		name = strrchr(buf, '/');
+		package_node->load_aes_file_name = package_strdup(package_node,
+							name ? name + 1 : buf);
+		if (package_node->load_aes_file_path == NULL ||
+		    package_node->load_aes_file_name == NULL)
+			return -DFX_INSUFFICIENT_MEM;
+	}
 
-	free(tmp);
+	if (package_node->package_path == NULL ||
+	    package_node->package_name == NULL ||
+	    package_node->load_image_dtbo_name == NULL)
+		return -DFX_INSUFFICIENT_MEM;
 
-	fd = fopen(filename, "rb");
-	if (!fd) {
-		printf("Unable to open sysfs binary file!");
-		ret = -DFX_FAIL_TO_OPEN_BIN_FILE;
-		goto END;
+	return 0;
+}
+
+/**
+ * read_package_mem() - set up a package from caller buffers
+ *
+ * @package_node:	package being initialized
+ * @mem:		payloads built by dfx_cfg_init_mem(), unmapped
+ *
+ * The package is handled like a container without a mapping. The overlays
+ * are copied into the package arena, since they are applied at every load;
+ * the image is only referenced until dfx_package_load_dmabuf() has copied
+ * it. The format of the image is not named by a file, it is a .bit if it
+ * carries the .bit preamble and the native format of the platform
+ * otherwise.
+ *
+ * Return:	0 on success, negative error code otherwise
+ */
+static int read_package_mem(struct dfx_package_node *package_node,
+			    const struct dfx_pkg *mem)
+{
+	const struct dfx_pkg_payload *image = &mem->entry[DFX_PKG_ENTRY_IMAGE];
+	struct dfx_pkg_payload *entry;
+	struct dfx_pkg *pkg;
+	unsigned char *data;
+	const char *name;
+	int type;
+
+	pkg = package_alloc(package_node, sizeof(*pkg));
+	if (pkg == NULL)
+		return -DFX_INSUFFICIENT_MEM;
+	*pkg = *mem;
+	package_node->pkg = pkg;
+
+	for (type = DFX_PKG_ENTRY_IMAGE_DTBO; type < DFX_PKG_ENTRY_MAX; type++) {
+		entry = &pkg->entry[type];
+		if (entry->data == NULL)
+			continue;
+		data = package_alloc(package_node, entry->size);
+		if (data == NULL)
+			return -DFX_INSUFFICIENT_MEM;
+		memcpy(data, entry->data, entry->size);
+		entry->data = data;
 	}
 
-	while(!feof(fd)) {
-		if(buf_size < count) {
-			count = -DFX_INSUFFICIENT_MEM;
-			break;
+	if (dfx_bit_is_bit(image->data, image->size))
+		name = "image.bit";
+	else if (package_node->xilplatform == VERSAL_PLATFORM)
+		name = "image.pdi";
+	else
+		name = "image.bin";
+	strcpy(pkg->entry[DFX_PKG_ENTRY_IMAGE].name, name);
+	strcpy(pkg->entry[DFX_PKG_ENTRY_IMAGE_DTBO].name, "image.dtbo");
+
+	/* Empty paths leave the firmware search path alone */
+	package_node->package_path = package_strdup(package_node, "");
+	package_node->package_name = package_strdup(package_node, pkg->name);
+	package_node->load_image_path = package_node->package_path;
+	package_node->load_image_name = package_strdup(package_node, name);
+	package_node->load_image_dtbo_path = package_node->package_path;
+	package_node->load_image_dtbo_name = package_strdup(package_node,
+							    "image.dtbo");
+	if (pkg->entry[DFX_PKG_ENTRY_DRIVERS_DTBO].data != NULL) {
+		strcpy(pkg->entry[DFX_PKG_ENTRY_DRIVERS_DTBO].name,
+		       "drivers.dtbo");
+		package_node->load_drivers_dtbo_path =
+			package_node->package_path;
+		package_node->load_drivers_dtbo_name =
+			package_strdup(package_node, "drivers.dtbo");
+		if (package_node->load_drivers_dtbo_name == NULL)
+			return -DFX_INSUFFICIENT_MEM;
+	}
+
+	if (package_node->package_path == NULL ||
+	    package_node->package_name == NULL ||
+	    package_node->load_image_name == NULL ||
+	    package_node->load_image_dtbo_name == NULL)
+		return -DFX_INSUFFICIENT_MEM;
+
+	return 0;
+}
+
+static int read_package_folder(struct dfx_package_node *package_node)
+{
+	int bin_count = 0, dtbo_count = 0, driver_dtbo_count = 0, nky_count = 0;
+	const char *pck;
+	char **path, **name;
+	struct dirent *dir;
+	size_t len;
+	DIR *FD;
+
+	FD = opendir(package_node->package_path);
+	if (FD) {
+		while ((dir = readdir(FD)) != NULL) {
+			switch (dfx_pkg_file_type(dir->d_name,
+						  package_node->xilplatform)) {
+			case DFX_PKG_ENTRY_IMAGE:
+				path = &package_node->load_image_path;
+				name = &package_node->load_image_name;
+				bin_count++;
+				break;
+			case DFX_PKG_ENTRY_IMAGE_DTBO:
+				path = &package_node->load_image_dtbo_path;
+				name = &package_node->load_image_dtbo_name;
+				dtbo_count++;
+				break;
+			case DFX_PKG_ENTRY_DRIVERS_DTBO:
+				path = &package_node->load_drivers_dtbo_path;
+				name = &package_node->load_drivers_dtbo_name;
+				driver_dtbo_count++;
+				break;
+			case DFX_PKG_ENTRY_KEY_REF:
+				path = &package_node->load_aes_file_path;
+				name = &package_node->load_aes_file_name;
+				nky_count++;
+				break;
+			default:
+				continue;
+			}
+
+			*path = package_path_join(package_node,
+						  package_node->package_path,
+						  dir->d_name);
+			*name = package_strdup(package_node, dir->d_name);
+			if (*path == NULL || *name == NULL) {
+				closedir(FD);
+				return -DFX_INSUFFICIENT_MEM;
+			}
 		}
+		closedir(FD);
+	}
 
-		fread(&buffer[count], sizeof(int), 1,fd);
-		count++;
+	if (bin_count > 1) {
+		DFX_ERR("libdfx: Error: %s* has multiple Bitstream files!",
+		        package_node->package_path);
+		return -DFX_DUPLICATE_FIRMWARE_ERROR;
 	}
 
-	fclose(fd);
-	closedir(FD);
+	if (dtbo_count > 1) {
+		DFX_ERR("libdfx: Error: %s* has multiple overlay files!",
+		        package_node->package_path);
+		return -DFX_DUPLICATE_DTBO_ERROR;
+	}
 
-	ret = count * sizeof(int);
-END:
-#ifdef ENABLE_LIBDFX_TIME
-	gettimeofday(&t1, NULL);
-	time = gettime(t0, t1);
-	printf("%s API Time taken: %f Milli Seconds\n\r", __func__, time);
-#endif
-	dfx_set_firmware_search_path("");
-	return ret;
+	if (driver_dtbo_count > 1) {
+		DFX_WARN("libdfx: warning: %s* has multiple Drivers overlay files(Deferred probe)!",
+		         package_node->package_path);
+		return -DFX_DUPLICATE_DRIVERS_DTBO_ERROR;
+	}
+
+	if (nky_count > 1) {
+		DFX_WARN("libdfx: warning: %s* has multiple AES key files!",
+		         package_node->package_path);
+		return -DFX_DUPLICATE_AES_KEY_ERROR;
+	}
+
+	if (package_node->load_image_dtbo_path == NULL) {
+		DFX_ERR("%s: Invalid package", __func__);
+		return -DFX_READ_PACKAGE_ERROR;
+	}
+
+	/* The package is named after its folder, package_path ends with '/' */
+	len = strlen(package_node->package_path) - 1;
+	pck = package_node->package_path + len;
+	while (pck > package_node->package_path && pck[-1] != '/')
+		pck--;
+	package_node->package_name = package_strndup(package_node, pck,
+				package_node->package_path + len - pck);
+	if (package_node->package_name == NULL)
+		return -DFX_INSUFFICIENT_MEM;
+
+	return 0;
+}
+
+/**
+ * package_alloc() - carve memory out of the arena of a package
+ *
+ * @package_node:	package that owns the memory
+ * @size:		bytes needed
+ *
+ * The memory is released with the package by destroy_package(), there is
+ * no way to free it earlier.
+ *
+ * Return:	zeroed memory aligned for any type, NULL if out of memory
+ */
+static void *package_alloc(struct dfx_package_node *package_node, size_t size)
+{
+	struct package_chunk *chunk;
+	size_t len;
+	void *ptr;
+
+	size = (size + sizeof(max_align_t) - 1) & ~(sizeof(max_align_t) - 1);
+	if (size > package_node->arena_left) {
+		len = size > PACKAGE_ARENA_LEN ? size : PACKAGE_ARENA_LEN;
+		chunk = calloc(1, sizeof(*chunk) + len);
+		if (chunk == NULL)
+			return NULL;
+		chunk->next = package_node->chunks;
+		package_node->chunks = chunk;
+		package_node->arena = chunk->data;
+		package_node->arena_left = len;
+	}
+
+	ptr = package_node->arena;
+	package_node->arena += size;
+	package_node->arena_left -= size;
+
+	return ptr;
+}
+
+static char *package_strndup(struct dfx_package_node *package_node,
+			     const char *src, size_t len)
+{
+	char *str = package_alloc(package_node, len + 1);
+
+	if (str != NULL)
+		memcpy(str, src, len);
+
+	return str;
 }
 
-static int read_package_folder(struct dfx_package_node *package_node)
+static char *package_strdup(struct dfx_package_node *package_node,
+			    const char *src)
 {
-	int bin_count = 0, dtbo_count = 0, driver_dtbo_count = 0, nky_count = 0;
-	char command[MAX_CMD_LEN];
-	struct dirent *dir;
-	int len, pcklen;
-	char *bin = ".bin";
-	char *pdi = ".pdi";
-	char *extension;
-	char *file_name;
-	char *str;
-	DIR *FD;
-
-	if (package_node->xilplatform == VERSAL_PLATFORM)
-		extension = pdi;
-	else
-		extension = bin;
+	return package_strndup(package_node, src, strlen(src));
+}
 
-	pcklen = strlen(package_node->package_path);
+/* Returns @dir followed by @name, @dir ends with a '/' */
+static char *package_path_join(struct dfx_package_node *package_node,
+			       const char *dir, const char *name)
+{
+	size_t dir_len = strlen(dir), len = strlen(name);
+	char *str = package_alloc(package_node, dir_len + len + 1);
 
-	FD = opendir(package_node->package_path);
-	if (FD) {
-		while ((dir = readdir(FD)) != NULL) {
-			len = strlen(dir->d_name);
-			file_name = (char *) calloc((len + 1), sizeof(char));
-			strlwr(file_name, dir->d_name);
-			if (len > 4) {
-				if (!strcmp(file_name + (len - 4), extension)) {
-					str = (char *) calloc(
-							(len + pcklen + 1),
-							sizeof(char));
-					strcpy(str, package_node->package_path);
-					strcat(str, dir->d_name);
-					package_node->load_image_path = str;
-					str = (char *) calloc((len + 1),
-								sizeof(char));
-					strcpy(str, dir->d_name);
-					package_node->load_image_name = str;
-					bin_count++;
-				} else if ((!strcmp(file_name + (len - 4),
-					   ".bit")) && package_node->xilplatform
-					   == ZYNQMP_PLATFORM) {
-					str = (char *) calloc(
-							(len + pcklen + 1),
-							sizeof(char));
-					strcpy(str, package_node->package_path);
-					strcat(str, dir->d_name);
-					package_node->load_image_path = str;
-					str = (char *) calloc((len + 1),
-							sizeof(char));
-					strcpy(str, dir->d_name);
-					package_node->load_image_name = str;
-					bin_count++;
-				} else if (!strcmp(file_name + (len - 7),
-								"_i.dtbo")) {
-					str = (char *) calloc(
-							(len + pcklen + 1),
-							sizeof(char));
-					strcpy(str, package_node->package_path);
-					strcat(str, dir->d_name);
-					package_node->load_image_dtbo_path =
-									str;
-					str = (char *) calloc((len + 1),
-								sizeof(char));
-					strcpy(str, dir->d_name);
-					package_node->load_image_dtbo_name =
-									str;
-					dtbo_count++;
-				} else if (!strcmp(file_name + (len - 7),
-					   "_d.dtbo")) {
-					str = (char *) calloc(
-							(len + pcklen + 1),
-							sizeof(char));
-					strcpy(str, package_node->package_path);
-					strcat(str, dir->d_name);
-					package_node->load_drivers_dtbo_path =
-									str;
-					str = (char *) calloc((len + 1),
-								sizeof(char));
-					strcpy(str, dir->d_name);
-					package_node->load_drivers_dtbo_name =
-									str;
-					driver_dtbo_count++;
-				} else if (!strcmp(file_name + (len - 5),
-								".dtbo")) {
-					str = (char *) calloc(
-							(len + pcklen + 1),
-							sizeof(char));
-					strcpy(str, package_node->package_path);
-					strcat(str, dir->d_name);
-					package_node->load_image_dtbo_path =
-									str;
-					str = (char *) calloc((len + 1),
-					sizeof(char));
-					strcpy(str, dir->d_name);
-					package_node->load_image_dtbo_name =
-									str;
-					dtbo_count++;
-				} else if (!strcmp(file_name + (len - 4),
-								".nky")) {
-					str = (char *) calloc(
-							(len + pcklen + 1),
-							sizeof(char));
-					strcpy(str, package_node->package_path);
-					strcat(str, dir->d_name);
-					package_node->load_aes_file_path = str;
-					str = (char *) calloc((len + 1),
-							sizeof(char));
-					strcpy(str, dir->d_name);
-					package_node->load_aes_file_name = str;
-					nky_count++;
-				}
-			}
-			free(file_name);
-		}
-		closedir(FD);
+	if (str != NULL) {
+		memcpy(str, dir, dir_len);
+		memcpy(str + dir_len, name, len);
 	}
 
-	if (bin_count > 1) {
-		printf("libdfx: Error: %s* has multiple Bitstream files!\n",
-		       package_node->package_path);
-		return -DFX_DUPLICATE_FIRMWARE_ERROR;
-	}
+	return str;
+}
 
-	if (dtbo_count > 1) {
-		printf("libdfx: Error: %s* has multiple overlay files!\n",
-		       package_node->package_path);
-		return -DFX_DUPLICATE_DTBO_ERROR;
-	}
+/* Names the configfs overlay directories once, so that loads format nothing */
+static int package_set_overlay_paths(struct dfx_package_node *package_node)
+{
+	char path_buf[MAX_CMD_LEN];
 
-	if (driver_dtbo_count > 1) {
-		printf("libdfx: warning: %s* has multiple Drivers overlay files(Deferred probe)!\n",
-		       package_node->package_path);
-		return -DFX_DUPLICATE_DRIVERS_DTBO_ERROR;
-	}
+	snprintf(path_buf, sizeof(path_buf), "%s/%s_image_%lu",
+		 dfx_root(DFX_ROOT_OVERLAYS), package_node->package_name,
+		 package_node->package_id);
+	package_node->load_image_overlay_pck_path =
+		package_strdup(package_node, path_buf);
+	if (package_node->load_image_overlay_pck_path == NULL)
+		return -DFX_INSUFFICIENT_MEM;
 
-	if (nky_count > 1) {
-		printf("libdfx: warning: %s* has multiple AES key files!\n",
-		       package_node->package_path);
-		return -DFX_DUPLICATE_AES_KEY_ERROR;
-	}
+	if (package_node->load_drivers_dtbo_path == NULL)
+		return 0;
 
-	if (package_node->load_image_dtbo_path != NULL) {
-		len = strlen(package_node->load_image_dtbo_path);
-		str = (char *) calloc((len + 1), sizeof(char));
-		strcpy(str, package_node->load_image_dtbo_path);
-		dirname(str);
-		snprintf(command, sizeof(command), "%s", basename(str));
-		free(str);
-		len = strlen(command) + 1;
-		str = (char *) calloc((len), sizeof(char));
-		strncpy(str, command, len);
-		package_node->package_name = str;
-	} else {
-		printf("%s: Invalid package\n", __func__);
-		return -DFX_READ_PACKAGE_ERROR;
-	}
+	snprintf(path_buf, sizeof(path_buf), "%s/%s_driver_%lu",
+		 dfx_root(DFX_ROOT_OVERLAYS), package_node->package_name,
+		 package_node->package_id);
+	package_node->load_drivers_overlay_pck_path =
+		package_strdup(package_node, path_buf);
+	if (package_node->load_drivers_overlay_pck_path == NULL)
+		return -DFX_INSUFFICIENT_MEM;
 
 	return 0;
 }
 
 static struct dfx_package_node *create_package()
 {
-	FPGA_NODE *package_node;
+	FPGA_NODE *package_node, *temp_node;
 	DIR *FD;
 
-	FD = opendir(DTBO_ROOT_DIR);
+	FD = opendir(dfx_root(DFX_ROOT_OVERLAYS));
 	if (FD)
 		closedir(FD);
 	else {
 		return 0;
 	}
 
+	package_node = aligned_alloc(CACHE_LINE_SIZE,
+				     sizeof(FPGA_NODE) + PACKAGE_ARENA_LEN);
+	if (package_node == NULL)
+		return NULL;
+	memset(package_node, 0, sizeof(FPGA_NODE) + PACKAGE_ARENA_LEN);
+	package_node->arena = (unsigned char *)(package_node + 1);
+	package_node->arena_left = PACKAGE_ARENA_LEN;
+
+	pthread_mutex_lock(&package_list_lock);
 	temp_node = first_node;
-	package_node = (FPGA_NODE *) calloc(1, sizeof(FPGA_NODE));
-	package_node->next = NULL;
 	if (first_node == NULL) {
 		package_node->package_id = 1;
 		first_node = package_node;
@@ -1194,12 +2960,16 @@ static struct dfx_package_node *create_package()
 			temp_node = temp_node->next;
 		}
 	}
+	pthread_mutex_unlock(&package_list_lock);
 
 	return package_node;
 }
 
 static struct dfx_package_node *get_package(int package_id)
 {
+	FPGA_NODE *temp_node;
+
+	pthread_mutex_lock(&package_list_lock);
 	temp_node = first_node;
 
 	while (temp_node != NULL) {
@@ -1208,18 +2978,57 @@ static struct dfx_package_node *get_package(int package_id)
 			break;
 		temp_node = temp_node->next;
 	}
+	pthread_mutex_unlock(&package_list_lock);
+
+	return temp_node;
+}
+
+/* get_package() for a timed load, counted until put_package_timed() */
+static struct dfx_package_node *get_package_timed(int package_id)
+{
+	FPGA_NODE *temp_node;
+
+	pthread_mutex_lock(&package_list_lock);
+	for (temp_node = first_node; temp_node != NULL;
+	     temp_node = temp_node->next) {
+		if (temp_node->package_id == (unsigned long)package_id) {
+			temp_node->timed_loads++;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&package_list_lock);
 
 	return temp_node;
 }
 
+static void put_package_timed(struct dfx_package_node *package_node)
+{
+	pthread_mutex_lock(&package_list_lock);
+	if (--package_node->timed_loads == 0)
+		pthread_cond_broadcast(&package_idle_cond);
+	pthread_mutex_unlock(&package_list_lock);
+}
+
+/* Waits until no timed load uses @package_node */
+static void package_wait_idle(struct dfx_package_node *package_node)
+{
+	pthread_mutex_lock(&package_list_lock);
+	while (package_node->timed_loads)
+		pthread_cond_wait(&package_idle_cond, &package_list_lock);
+	pthread_mutex_unlock(&package_list_lock);
+}
+
 static int destroy_package(int package_id)
 {
-	FPGA_NODE *package_node = NULL;
+	FPGA_NODE *package_node = NULL, *temp_node;
 
+	pthread_mutex_lock(&package_list_lock);
 	temp_node = first_node;
 
-	if (first_node == NULL)
+	if (first_node == NULL) {
+		pthread_mutex_unlock(&package_list_lock);
 		return -DFX_DESTROY_PACKAGE_ERROR;
+	}
 
 	if (first_node->package_id == package_id) {
 		if (first_node->next != NULL)
@@ -1237,33 +3046,20 @@ static int destroy_package(int package_id)
 			temp_node = temp_node->next;
 		}
 	}
+	/* Unlinked, so no timed load can start; wait for those running */
+	while (package_node != NULL && package_node->timed_loads)
+		pthread_cond_wait(&package_idle_cond, &package_list_lock);
+	pthread_mutex_unlock(&package_list_lock);
 
 	if (package_node != NULL) {
-		if (package_node->package_name != NULL)
-			free(package_node->package_name);
-		if (package_node->package_path != NULL)
-			free(package_node->package_path);
-		if (package_node->load_image_name != NULL)
-			free(package_node->load_image_name);
-		if (package_node->load_image_path != NULL)
-			free(package_node->load_image_path);
-		if (package_node->load_image_dtbo_name != NULL)
-			free(package_node->load_image_dtbo_name);
-		if (package_node->load_image_dtbo_path != NULL)
-			free(package_node->load_image_dtbo_path);
-		if (package_node->load_drivers_dtbo_name != NULL)
-			free(package_node->load_drivers_dtbo_name);
-		if (package_node->load_drivers_dtbo_path != NULL)
-			free(package_node->load_drivers_dtbo_path);
-		if (package_node->load_image_overlay_pck_path != NULL)
-			free(package_node->load_image_overlay_pck_path);
-		if (package_node->load_drivers_overlay_pck_path != NULL)
-			free(package_node->load_drivers_overlay_pck_path);
-		if (package_node->dmabuf_info != NULL)
-			free(package_node->dmabuf_info);
-		if (package_node->aes_key != NULL)
-			free(package_node->aes_key);
+		struct package_chunk *chunk, *next;
 
+		if (package_node->pkg != NULL)
+			dfx_pkg_close(package_node->pkg);
+		for (chunk = package_node->chunks; chunk != NULL; chunk = next) {
+			next = chunk->next;
+			free(chunk);
+		}
 		free(package_node);
 	} else
 		return -DFX_DESTROY_PACKAGE_ERROR;
@@ -1281,26 +3077,82 @@ static int dfx_get_error(const char *state_buf)
 	return (int) strtol(state_buf, NULL, 0);
 }
 
+/* Maps the DFX_BUFFER_* field of the package flags to a backend */
+static enum dma_buffer_backend buffer_backend(int flags)
+{
+	switch (flags & DFX_BUFFER_MASK) {
+	case DFX_BUFFER_UDMABUF:
+		return DMA_BUFFER_UDMABUF;
+	case DFX_BUFFER_MEMFD:
+		return DMA_BUFFER_MEMFD;
+	case DFX_BUFFER_DMA_HEAP:
+		return DMA_BUFFER_DMA_HEAP;
+	}
+
+	return DMA_BUFFER_BACKEND_MAX;
+}
+
 static int dfx_package_load_dmabuf(struct dfx_package_node *package_node,
-				   const char *cma_file)
+				   const char *cma_file,
+				   struct dfx_load_record *rec)
 {
 	int word_align = 0, index, fd, ret;
-	struct dma_buf_sync sync = { 0 };
+	const struct dfx_pkg_payload *image = NULL;
+	const unsigned char *src = NULL;
 	struct dma_buffer_info info;
+	struct dfx_sha256 sha;
+	unsigned long long t0;
+	unsigned long bit_len;
 	long fileLen, count;
+	uint32_t crc = 0, raw_crc = 0;
+	bool check_raw;
 	char *dma_buf;
 	FILE *fp;
 
-	fp = fopen(package_node->load_image_path, "rb");
+	t0 = dfx_stats_now();
+	if (package_node->pkg != NULL) {
+		/* Container images are copied straight out of the mapping */
+		image = &package_node->pkg->entry[DFX_PKG_ENTRY_IMAGE];
+		if (image->data == NULL) {
+			DFX_ERR("%s: `%s` has no image", __func__,
+				package_node->package_path);
+			return -DFX_READ_PACKAGE_ERROR;
+		}
+		src = image->data;
+		fp = fmemopen((void *)src, image->size, "rb");
+	} else {
+		fp = fopen(package_node->load_image_path, "rb");
+	}
 	if (fp == NULL) {
-		printf("%s: File open failed\n", __func__);
+		DFX_ERR("%s: File open failed", __func__);
 		return -1;
 	}
+	t0 = dfx_stats_phase_end(rec, DFX_PHASE_FILE_OPEN, t0);
 
 	//Get Bitstream/PDI Image Size
-	fseek(fp, 0, SEEK_END);
-	fileLen = ftell(fp);
-	fseek(fp, 0, SEEK_SET);
+	package_node->info.format = dfx_image_format(image ? image->name :
+					package_node->load_image_path);
+	if (package_node->info.format == DFX_IMAGE_BIT) {
+		/* Strip the header, the data is converted to .bin order below */
+		if (dfx_bit_parse_header(fp, &package_node->info, &bit_len) ||
+		    (image && bit_len > image->size -
+				       package_node->info.header_size)) {
+			DFX_ERR("%s: Invalid .bit header in `%s`", __func__,
+				package_node->load_image_path);
+			fclose(fp);
+			return -DFX_READ_PACKAGE_ERROR;
+		}
+		fileLen = bit_len;
+		if (src != NULL)
+			src += package_node->info.header_size;
+	} else if (image != NULL) {
+		fileLen = image->size;
+	} else {
+		fseek(fp, 0, SEEK_END);
+		fileLen = ftell(fp);
+		fseek(fp, 0, SEEK_SET);
+	}
+	package_node->info.image_size = fileLen;
 
 	if (package_node->xilplatform == ZYNQMP_PLATFORM) {
 		word_align = fileLen % FPGA_WORD_SIZE;
@@ -1310,10 +3162,17 @@ static int dfx_package_load_dmabuf(struct dfx_package_node *package_node,
 		fileLen = fileLen + word_align;
 	}
 
-	package_node->dmabuf_info = (struct dma_buffer_info *) calloc(1,
-					sizeof(struct dma_buffer_info));
+	if (package_node->dmabuf_info == NULL)
+		package_node->dmabuf_info = package_alloc(package_node,
+					sizeof(*package_node->dmabuf_info));
+	if (package_node->dmabuf_info == NULL) {
+		ret = -DFX_INSUFFICIENT_MEM;
+		goto err_update;
+	}
+	memset(package_node->dmabuf_info, 0, sizeof(*package_node->dmabuf_info));
 	package_node->dmabuf_info->dma_buflen = fileLen;
 	package_node->dmabuf_info->cma_file = cma_file;
+	package_node->dmabuf_info->backend = buffer_backend(package_node->flags);
 
 	/* This call will do the following things
 	 *   1. Allocate memory from the DMA pool and return a valid buffer fd
@@ -1321,41 +3180,94 @@ static int dfx_package_load_dmabuf(struct dfx_package_node *package_node,
 	 */
 	ret = export_dma_buffer(package_node->dmabuf_info);
 	if (ret < 0) {
-		printf("%s: DMA buffer alloc failed\n", __func__);
+		DFX_ERR("%s: DMA buffer alloc failed", __func__);
 		goto err_update;
 	}
+	package_node->dma_buffd = package_node->dmabuf_info->dma_buffd;
+	t0 = dfx_stats_phase_end(rec, DFX_PHASE_CMA_ALLOC, t0);
 
 	/* DO Memory access synchronization */
-	sync.flags = DMA_BUF_SYNC_START | DMA_BUF_SYNC_RW;
-	ret = ioctl(package_node->dmabuf_info->dma_buffd,
-		    DMA_BUF_IOCTL_SYNC, &sync);
+	ret = sync_dma_buffer(package_node->dmabuf_info,
+			      DMA_BUF_SYNC_START | DMA_BUF_SYNC_RW);
 	if (ret) {
-		printf("%s: sync start failed\n", __func__);
+		DFX_ERR("%s: sync start failed", __func__);
 		goto unmap_buf;
 	}
-
-	/* Copy Bitfile/PDI image into the Dmabuf */
-	if (word_align) {
-		dma_buf = (char *) package_node->dmabuf_info->dma_buffer;
-		for (index = 0; index < word_align; index++)
-			dma_buf[index] = FPGA_DUMMY_BYTE;
-		fileLen = fileLen - word_align;
-		count = fread(&dma_buf[index], 1, fileLen, fp);
-	} else
-		count = fread((char *) package_node->dmabuf_info->dma_buffer, 1,
-			      fileLen, fp);
+	t0 = dfx_stats_phase_end(rec, DFX_PHASE_SYNC, t0);
+
+	/* Copy Bitfile/PDI image into the Dmabuf, digesting it on the way */
+	DFX_PROBE2(copy_start, package_node->package_id, fileLen);
+	if (package_node->flags & DFX_DIGEST_SHA256_EN)
+		dfx_sha256_init(&sha);
+	dma_buf = (char *) package_node->dmabuf_info->dma_buffer;
+	for (index = 0; index < word_align; index++)
+		dma_buf[index] = FPGA_DUMMY_BYTE;
+	fileLen = fileLen - word_align;
+	/*
+	 * The container CRC covers the payload as stored: for a .bit image
+	 * the header, then the data before the swap, then anything after it.
+	 * Memory packages are not mapped and carry no CRC.
+	 */
+	check_raw = image != NULL && package_node->pkg->map != NULL &&
+		    package_node->info.format == DFX_IMAGE_BIT;
+	if (check_raw)
+		raw_crc = dfx_crc32c(0, image->data,
+				     package_node->info.header_size);
+	if (src != NULL) {
+		dfx_digest_copy(&dma_buf[word_align], src, fileLen,
+				package_node->info.format == DFX_IMAGE_BIT, &crc,
+				check_raw ? &raw_crc : NULL,
+				(package_node->flags & DFX_DIGEST_SHA256_EN) ?
+				&sha : NULL);
+		count = fileLen;
+		if (check_raw)
+			raw_crc = dfx_crc32c(raw_crc, src + fileLen,
+					     image->size -
+					     package_node->info.header_size -
+					     fileLen);
+	} else {
+		count = dfx_digest_read(fp, &dma_buf[word_align], fileLen,
+					package_node->info.format ==
+					DFX_IMAGE_BIT, &crc,
+					(package_node->flags & DFX_DIGEST_SHA256_EN) ?
+					&sha : NULL);
+	}
+	DFX_PROBE2(copy_end, package_node->package_id, count);
 	if (count != fileLen) {
-		printf("%s: Image copy failed\n", __func__);
+		DFX_ERR("%s: Image copy failed", __func__);
 		goto unmap_buf;
 	}
-
-	sync.flags = DMA_BUF_SYNC_END | DMA_BUF_SYNC_RW;
-	ret = ioctl(package_node->dmabuf_info->dma_buffd,
-		    DMA_BUF_IOCTL_SYNC, &sync);
+	if (image != NULL && package_node->pkg->map != NULL &&
+	    (check_raw ? raw_crc : crc) != image->crc32c) {
+		DFX_ERR("%s: `%s` image is corrupted", __func__,
+			package_node->package_path);
+		close_dma_buffer(package_node->dmabuf_info);
+		fclose(fp);
+		return -DFX_IMAGE_DIGEST_ERROR;
+	}
+	package_node->digest.length = count;
+	package_node->digest.crc32c = crc;
+	if (package_node->flags & DFX_DIGEST_SHA256_EN) {
+		dfx_sha256_final(&sha, package_node->digest.sha256);
+		package_node->digest.has_sha256 = 1;
+	}
+	if (package_node->xilplatform == VERSAL_PLATFORM &&
+	    package_node->info.format != DFX_IMAGE_BIT)
+		package_read_uids(package_node,
+				  (const unsigned char *)&dma_buf[word_align],
+				  count);
+	t0 = dfx_stats_phase_end(rec, DFX_PHASE_COPY, t0);
+
+	ret = sync_dma_buffer(package_node->dmabuf_info,
+			      DMA_BUF_SYNC_END | DMA_BUF_SYNC_RW);
 	if (ret) {
-		printf("%s: sync end failed\n", __func__);
+		DFX_ERR("%s: sync end failed", __func__);
 		goto unmap_buf;
 	}
+	dfx_stats_phase_end(rec, DFX_PHASE_SYNC, t0);
+	if (package_node->dmabuf_info->backend == DMA_BUFFER_DMA_HEAP)
+		dfx_stats_cma(&package_node->stats,
+			      package_node->dmabuf_info->dma_buflen);
 
 	fclose(fp);
 
@@ -1369,16 +3281,467 @@ err_update:
 
 }
 
-static int dfx_getplatform(void)
+/**
+ * package_choose_path() - pick how the image of a package reaches the FPGA
+ *
+ * @package_node:	package being initialized, image not read yet
+ * @cma_file:		heap given to the init call, kept for a later
+ *			DFX_LOAD_AUTO promotion
+ *
+ * Sets package_node->load_path from the DFX_LOAD_* field of the flags. The
+ * firmware loader needs the image as a file the kernel can read as is, and
+ * leaves nothing to digest or verify.
+ *
+ * Return:	0 on success, negative error code otherwise
+ */
+static int package_choose_path(struct dfx_package_node *package_node,
+			       const char *cma_file)
+{
+	int strategy = package_node->flags & DFX_LOAD_MASK;
+	enum dfx_image_format format;
+	long long cma_free;
+	struct stat st;
+	bool loadable;
+
+	if (strategy != DFX_LOAD_PRELOAD && strategy != DFX_LOAD_FIRMWARE &&
+	    strategy != DFX_LOAD_AUTO) {
+		DFX_ERR("%s: Invalid load strategy 0x%x", __func__, strategy);
+		return -DFX_INVALID_PARAM;
+	}
+
+	package_node->load_path = DFX_LOAD_PATH_DMABUF;
+	if (strategy == DFX_LOAD_PRELOAD)
+		return 0;
+
+	format = dfx_image_format(package_node->load_image_name);
+	loadable = package_node->pkg == NULL &&
+		   package_node->load_image_name != NULL &&
+		   (format == DFX_IMAGE_BIN || format == DFX_IMAGE_PDI) &&
+		   !(package_node->flags &
+		     (DFX_DIGEST_SHA256_EN | DFX_VERIFY_ON_LOAD_EN)) &&
+		   !stat(package_node->load_image_path, &st);
+	if (strategy == DFX_LOAD_FIRMWARE && !loadable) {
+		DFX_ERR("%s: `%s` cannot be loaded by the firmware loader",
+			__func__, package_node->package_name);
+		return -DFX_INVALID_PARAM;
+	}
+	if (strategy == DFX_LOAD_AUTO) {
+		if (!loadable)
+			return 0;
+		cma_free = dma_buffer_cma_free();
+		if (st.st_size >= AUTO_PRELOAD_MIN &&
+		    (cma_free < 0 || st.st_size <= cma_free / 2))
+			return 0;
+		if (cma_file != NULL) {
+			package_node->cma_file = package_strdup(package_node,
+								cma_file);
+			if (package_node->cma_file == NULL)
+				return -DFX_INSUFFICIENT_MEM;
+		}
+	}
+
+	package_node->load_path = DFX_LOAD_PATH_FIRMWARE;
+	package_node->info.format = format;
+	package_node->info.image_size = st.st_size;
+	DFX_DBG("%s: `%s` is loaded by the firmware loader", __func__,
+		package_node->package_name);
+
+	return 0;
+}
+
+/**
+ * package_auto_promote() - move a DFX_LOAD_AUTO package to a dmabuf
+ *
+ * @package_node:	package about to be loaded, FPGA manager lock held
+ * @rec:		record of the load, charged with the copy
+ *
+ * Promotes the package once it is loaded often or its firmware loads are
+ * slow, and there is CMA to spare. A failed allocation leaves the package
+ * on the firmware loader, see package_stage_dmabuf() for the retries.
+ */
+static void package_auto_promote(struct dfx_package_node *package_node,
+				 struct dfx_load_record *rec)
+{
+	unsigned long long now = dfx_stats_now();
+	bool hot, slow;
+
+	if (package_node->hot_loads == 0 ||
+	    now - package_node->hot_start > AUTO_HOT_WINDOW_NS) {
+		package_node->hot_start = now;
+		package_node->hot_loads = 0;
+	}
+	package_node->hot_loads++;
+
+	hot = package_node->hot_loads >= AUTO_HOT_LOADS;
+	slow = package_node->fw_loads &&
+	       package_node->fw_load_ns / package_node->fw_loads >
+	       AUTO_SLOW_LOAD_NS;
+	if ((hot || slow) && !package_stage_dmabuf(package_node, rec))
+		DFX_INFO("%s: `%s` moved to a dmabuf after %u loads", __func__,
+			 package_node->package_name, package_node->hot_loads);
+}
+
+/**
+ * package_stage_dmabuf() - copy the image of a firmware loader package into
+ *			    a dmabuf
+ *
+ * @package_node:	DFX_LOAD_AUTO package, FPGA manager lock held
+ * @rec:		receives the durations of the allocation and copy
+ *
+ * Keeps half of the free CMA for others. A failed allocation leaves the
+ * package on the firmware loader, and is not retried until more CMA is
+ * free than at the time it failed.
+ *
+ * Return:	0 if the package now loads from a dmabuf, negative error
+ *		code otherwise
+ */
+static int package_stage_dmabuf(struct dfx_package_node *package_node,
+				struct dfx_load_record *rec)
+{
+	long long cma_free;
+
+	cma_free = dma_buffer_cma_free();
+	if (cma_free >= 0 &&
+	    package_node->info.image_size > (unsigned long long)cma_free / 2)
+		return -DFX_DMABUF_ALLOC_ERROR;
+	if (package_node->stage_failed &&
+	    cma_free <= package_node->stage_cma_free)
+		return -DFX_DMABUF_ALLOC_ERROR;
+
+	package_node->dmabuf_info = package_node->stage_info;
+	if (dfx_package_load_dmabuf(package_node, package_node->cma_file,
+				    rec)) {
+		DFX_WARN("%s: `%s` stays on the firmware loader", __func__,
+			 package_node->package_name);
+		package_node->stage_info = package_node->dmabuf_info;
+		package_node->dmabuf_info = NULL;
+		package_node->stage_failed = true;
+		package_node->stage_cma_free = cma_free;
+		return -DFX_DMABUF_ALLOC_ERROR;
+	}
+
+	package_node->stage_failed = false;
+	package_node->load_path = DFX_LOAD_PATH_DMABUF;
+	dfx_stats_promote(&package_node->stats);
+	/* Loads over the firmware loader say nothing about the new path */
+	dfx_stats_ring_reset(&package_node->load_history);
+
+	return 0;
+}
+
+/**
+ * prefetch_package() - prepare a package for a load expected at @due_ns
+ *
+ * @package_node:	hinted package, kept alive by prefetch_active
+ * @due_ns:		expected load time
+ *
+ * Warms the page cache with the image, then copies it into a dmabuf if the
+ * package is DFX_LOAD_AUTO and the budget allows. The FPGA manager lock is
+ * only tried, a load holding it is not delayed; past @due_ns, or once
+ * the package is being destroyed, the dmabuf is left to the load.
+ */
+static void prefetch_package(struct dfx_package_node *package_node,
+			     unsigned long long due_ns)
+{
+	struct dfx_load_record rec = { 0 };
+	struct timespec retry = { 0, PREFETCH_RETRY_NS };
+	unsigned long size;
+	int fd;
+
+	fd = open(package_node->load_image_path, O_RDONLY | O_CLOEXEC);
+	if (fd >= 0) {
+		posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+		close(fd);
+	}
+
+	if ((package_node->flags & DFX_LOAD_MASK) != DFX_LOAD_AUTO)
+		return;
+
+	size = package_node->info.image_size;
+	pthread_mutex_lock(&prefetch_lock);
+	if (prefetch_used + size > prefetch_budget) {
+		pthread_mutex_unlock(&prefetch_lock);
+		DFX_DBG("%s: `%s` exceeds the prefetch budget", __func__,
+			package_node->package_name);
+		return;
+	}
+	prefetch_used += size;
+	pthread_mutex_unlock(&prefetch_lock);
+
+	while (pthread_mutex_trylock(&package_node->mgr->lock)) {
+		if (dfx_stats_now() >= due_ns ||
+		    __atomic_load_n(&prefetch_cancelled, __ATOMIC_RELAXED))
+			goto RELEASE;
+		nanosleep(&retry, NULL);
+	}
+	if (package_node->load_path == DFX_LOAD_PATH_FIRMWARE &&
+	    !package_stage_dmabuf(package_node, &rec)) {
+		package_node->prefetch_bytes = size;
+		pthread_mutex_unlock(&package_node->mgr->lock);
+		dfx_stats_record(&package_node->stats, DFX_PHASE_CMA_ALLOC,
+				 rec.phase_ns[DFX_PHASE_CMA_ALLOC]);
+		dfx_stats_record(&package_node->stats, DFX_PHASE_COPY,
+				 rec.phase_ns[DFX_PHASE_COPY]);
+		DFX_INFO("%s: `%s` staged in a dmabuf", __func__,
+			 package_node->package_name);
+		return;
+	}
+	pthread_mutex_unlock(&package_node->mgr->lock);
+
+RELEASE:
+	pthread_mutex_lock(&prefetch_lock);
+	prefetch_used -= size;
+	pthread_mutex_unlock(&prefetch_lock);
+}
+
+static void *prefetch_worker(void *arg)
+{
+	struct dfx_package_node *package_node;
+	unsigned long long now, due, wake;
+	struct timespec ts;
+	int i, next;
+
+	(void)arg;
+
+	/* Below foreground loads, for both the disk and the CPU */
+	syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0,
+		IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+	setpriority(PRIO_PROCESS, syscall(SYS_gettid), 19);
+
+	pthread_mutex_lock(&prefetch_lock);
+	for (;;) {
+		if (prefetch_len == 0) {
+			pthread_cond_wait(&prefetch_cond, &prefetch_lock);
+			continue;
+		}
+
+		next = 0;
+		for (i = 1; i < prefetch_len; i++)
+			if (prefetch_queue[i].due_ns < prefetch_queue[next].due_ns)
+				next = i;
+		now = dfx_stats_now();
+		due = prefetch_queue[next].due_ns;
+		if (due > now + PREFETCH_HORIZON_NS) {
+			wake = due - PREFETCH_HORIZON_NS;
+			ts.tv_sec = wake / 1000000000ULL;
+			ts.tv_nsec = wake % 1000000000ULL;
+			pthread_cond_timedwait(&prefetch_cond, &prefetch_lock,
+					       &ts);
+			continue;
+		}
+
+		prefetch_active = prefetch_queue[next].package_id;
+		prefetch_queue[next] = prefetch_queue[--prefetch_len];
+		pthread_mutex_unlock(&prefetch_lock);
+
+		package_node = get_package(prefetch_active);
+		if (package_node != NULL && package_node->dmabuf_info == NULL &&
+		    package_node->load_path == DFX_LOAD_PATH_FIRMWARE)
+			prefetch_package(package_node, due);
+
+		pthread_mutex_lock(&prefetch_lock);
+		prefetch_active = 0;
+		pthread_cond_broadcast(&prefetch_cond);
+	}
+
+	return NULL;
+}
+
+/* pthread_once() routine of dfx_cfg_hint() */
+static void prefetch_start(void)
+{
+	pthread_condattr_t attr;
+	pthread_attr_t tattr;
+	pthread_t thread;
+
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&prefetch_cond, &attr);
+	pthread_condattr_destroy(&attr);
+
+	pthread_attr_init(&tattr);
+	pthread_attr_setdetachstate(&tattr, PTHREAD_CREATE_DETACHED);
+	prefetch_running = !pthread_create(&thread, &tattr, prefetch_worker,
+					   NULL);
+	pthread_attr_destroy(&tattr);
+}
+
+/* Drops the hints for @package_id and waits out a prefetch in progress */
+static void prefetch_cancel(int package_id)
+{
+	int i;
+
+	pthread_mutex_lock(&prefetch_lock);
+	for (i = 0; i < prefetch_len; ) {
+		if (prefetch_queue[i].package_id == package_id)
+			prefetch_queue[i] = prefetch_queue[--prefetch_len];
+		else
+			i++;
+	}
+	if (prefetch_active == package_id) {
+		__atomic_store_n(&prefetch_cancelled, 1, __ATOMIC_RELAXED);
+		while (prefetch_active == package_id)
+			pthread_cond_wait(&prefetch_cond, &prefetch_lock);
+		__atomic_store_n(&prefetch_cancelled, 0, __ATOMIC_RELAXED);
+	}
+	pthread_mutex_unlock(&prefetch_lock);
+}
+
+static void timed_load_free(struct timed_load *job)
+{
+	pthread_cond_destroy(&job->cond);
+	pthread_mutex_destroy(&job->lock);
+	free(job);
+}
+
+/* Whether the caller of a timed load has given up on it */
+static bool timed_load_abandoned(struct timed_load *job)
+{
+	bool abandoned;
+
+	pthread_mutex_lock(&job->lock);
+	abandoned = job->abandoned;
+	pthread_mutex_unlock(&job->lock);
+
+	return abandoned;
+}
+
+static void *timed_load_worker(void *arg)
+{
+	struct timed_load *job = arg;
+	bool abandoned;
+	int ret;
+
+	timed_load_self = job;
+	ret = dfx_cfg_load(job->package_id);
+	put_package_timed(job->package_node);
+
+	pthread_mutex_lock(&job->lock);
+	job->ret = ret;
+	job->done = true;
+	abandoned = job->abandoned;
+	pthread_cond_signal(&job->cond);
+	pthread_mutex_unlock(&job->lock);
+
+	if (abandoned) {
+		if (ret != -(int)DFX_LOAD_DEADLINE_ERROR)
+			DFX_INFO("%s: package %d finished past its deadline: %d",
+				 __func__, job->package_id, ret);
+		timed_load_free(job);
+	}
+
+	return NULL;
+}
+
+/**
+ * import_dmabuf() - take a reference on a caller dmabuf holding the image
+ *
+ * @package_node:	package being initialized
+ * @import:		fd and image length given to dfx_cfg_init_dmabuf()
+ *
+ * The fd is duplicated, the caller keeps its own. The buffer is neither
+ * mapped nor read: the package has no digest and no PDI metadata.
+ *
+ * Return:	0 on success, negative error code otherwise
+ */
+static int import_dmabuf(struct dfx_package_node *package_node,
+			 const struct dma_buffer_info *import)
+{
+	struct dma_buffer_info *info;
+	off_t size;
+
+	if (package_node->xilplatform == ZYNQMP_PLATFORM &&
+	    import->dma_buflen % FPGA_WORD_SIZE) {
+		DFX_ERR("%s: ZynqMP images must be padded to %u bytes",
+			__func__, FPGA_WORD_SIZE);
+		return -DFX_INVALID_PARAM;
+	}
+
+	/* dmabufs report their size through lseek(), other fds may not */
+	size = lseek(import->dma_buffd, 0, SEEK_END);
+	if (size >= 0 && (unsigned long)size < import->dma_buflen) {
+		DFX_ERR("%s: image of %lu bytes in a buffer of %lld", __func__,
+			import->dma_buflen, (long long)size);
+		return -DFX_INVALID_PARAM;
+	}
+
+	info = package_alloc(package_node, sizeof(*info));
+	if (info == NULL)
+		return -DFX_INSUFFICIENT_MEM;
+	*info = *import;
+	info->dma_buffd = fcntl(import->dma_buffd, F_DUPFD_CLOEXEC, 0);
+	if (info->dma_buffd < 0) {
+		DFX_ERR("%s: Failed to duplicate dmabuf fd %d", __func__,
+			import->dma_buffd);
+		return -DFX_DMABUF_ALLOC_ERROR;
+	}
+	package_node->dmabuf_info = info;
+	package_node->dma_buffd = info->dma_buffd;
+	package_node->info.image_size = info->dma_buflen;
+
+	return 0;
+}
+
+/**
+ * verify_dmabuf() - check the dmabuf of a package against its digest
+ *
+ * @package_node: package whose image was copied by dfx_package_load_dmabuf()
+ *
+ * Catches CMA corruption before a bad image reaches the FPGA manager, where
+ * it would only show up as a failed configuration.
+ *
+ * Return:	0 if the contents match, negative error code otherwise
+ */
+static int verify_dmabuf(struct dfx_package_node *package_node)
+{
+	struct dma_buffer_info *info = package_node->dmabuf_info;
+	struct dfx_package_digest *digest = &package_node->digest;
+	unsigned char sha256[DFX_SHA256_LEN];
+	const unsigned char *image;
+	struct dfx_sha256 sha;
+	uint32_t crc;
+	int ret = 0;
+
+	if (sync_dma_buffer(info, DMA_BUF_SYNC_START | DMA_BUF_SYNC_READ)) {
+		DFX_ERR("%s: sync start failed", __func__);
+		return -DFX_DMABUF_ALLOC_ERROR;
+	}
+
+	image = (const unsigned char *)info->dma_buffer +
+		(info->dma_buflen - digest->length);
+	crc = dfx_crc32c(0, image, digest->length);
+	if (crc != digest->crc32c) {
+		DFX_ERR("%s: CRC32C mismatch: 0x%08x, expected 0x%08x",
+			__func__, crc, digest->crc32c);
+		ret = -DFX_IMAGE_DIGEST_ERROR;
+	} else if (digest->has_sha256) {
+		dfx_sha256_init(&sha);
+		dfx_sha256_update(&sha, image, digest->length);
+		dfx_sha256_final(&sha, sha256);
+		if (memcmp(sha256, digest->sha256, sizeof(sha256))) {
+			DFX_ERR("%s: SHA-256 mismatch", __func__);
+			ret = -DFX_IMAGE_DIGEST_ERROR;
+		}
+	}
+
+	sync_dma_buffer(info, DMA_BUF_SYNC_END | DMA_BUF_SYNC_READ);
+
+	return ret;
+}
+
+static int dfx_getplatform(const char *mgr_name)
 {
 	char *zynqmpstr = "Xilinx ZynqMP FPGA Manager";
 	char *Versalstr = "Xilinx Versal FPGA Manager";
 	char fpstr[PLATFORM_STR_LEN];
+	char path[MAX_CMD_LEN];
 	FILE *fptr;
 
-	fptr = fopen("/sys/class/fpga_manager/fpga0/name", "r");
+	snprintf(path, sizeof(path), "%s/%s/name",
+		 dfx_root(DFX_ROOT_FPGA_MGR), mgr_name);
+	fptr = fopen(path, "r");
 	if (fptr == NULL) {
-		printf("Error! opening the platform file");
+		DFX_ERR("Error! opening the platform file");
 		return INVALID_PLATFORM;
 	}
 
@@ -1413,9 +3776,19 @@ static int find_key(struct dfx_package_node *package_node)
 	int len;
 	char line[MAX_CMD_LEN];
 	int find_result = 0;
-	FILE *fp = fopen(package_node->load_aes_file_path, "r");
+	FILE *fp;
+
+	if (package_node->load_aes_file_path == NULL)
+		return -DFX_AESKEY_READ_ERROR;
+	fp = fopen(package_node->load_aes_file_path, "r");
+	if (fp == NULL)
+		return -DFX_AESKEY_READ_ERROR;
 
-	package_node->aes_key = (char *) calloc(MAX_AES_KEY_LEN, sizeof(char));
+	package_node->aes_key = package_alloc(package_node, MAX_AES_KEY_LEN + 1);
+	if (package_node->aes_key == NULL) {
+		fclose(fp);
+		return -DFX_INSUFFICIENT_MEM;
+	}
 	while (fgets(line, sizeof(line), fp) != NULL) {
 		if (strstr(line, "Key") != NULL) {
 			len = strlen(line) - lengthOfLastWord2(line);
@@ -1427,54 +3800,42 @@ static int find_key(struct dfx_package_node *package_node)
 		}
 	}
 
-	//Close the file if still open.
-	if (fp)
-		fclose(fp);
+	fclose(fp);
 
-	if (find_result == 0) {
-		free(package_node->aes_key);
+	if (find_result == 0)
 		return -DFX_AESKEY_READ_ERROR;
-	}
 
 	return 0;
 }
 
-static inline void strlwr(char *destination, const char *source)
-{
-	while (*source) {
-		*destination = tolower((unsigned char)*source);
-		source++;
-		destination++;
-	}
-}
-
 static void zynqmp_print_err_msg(int err)
 {
-	int i, err_found = 0;
+	const char *stage = NULL, *detail = NULL;
+	int i;
 
 	if ((err & 0xFF) == XFPGA_VALIDATE_ERROR)
-		printf("Error: Image validation");
+		stage = "Image validation";
 	if ((err & 0xFF) == XFPGA_PRE_CONFIG_ERROR)
-		printf("Error: Image Pre-configuration");
+		stage = "Image Pre-configuration";
 	if ((err & 0xFF) == XFPGA_WRITE_BITSTREAM_ERROR)
-                printf("Error: Image write:");
+		stage = "Image write:";
 	if ((err & 0xFF) == XFPGA_POST_CONFIG_ERROR)
-                printf("Error: Image Post-configuration");
+		stage = "Image Post-configuration";
 	if ((err & 0xFF) == XFPGA_OPS_NOT_IMPLEMENTED)
-                printf("Error: Operation not supported");
+		stage = "Operation not supported";
 	if ((err & 0xFF) == XFPGA_INVALID_PARAM)
-                printf("Error: Invalid input parameters");
+		stage = "Invalid input parameters";
 
 	for (i = 0; i < ZYNQMP_MAX_ERR; i++) {
 		if (zynqmp_err[i].err_code == (err >> 8) & 0xFF) {
-			printf(": %s\r\n", zynqmp_err[i].err_str);
-			err_found++;
+			detail = zynqmp_err[i].err_str;
 			break;
 		}
 	}
 
-	if ((!err_found) && (err & 0xFF))
-		printf("\r\n");
+	if (stage != NULL || detail != NULL)
+		DFX_ERR("Error: %s%s%s", stage ? stage : "",
+			detail ? ": " : "", detail ? detail : "");
 }
 
 static int dfx_cfg_init_common(const char *dfx_package_path,
@@ -1482,83 +3843,137 @@ static int dfx_cfg_init_common(const char *dfx_package_path,
 			       const char *dfx_dtbo_file,
 			       const char *dfx_driver_dtbo_file,
 			       const char *dfx_aes_key_file,
+			       const struct dfx_pkg *mem,
+			       const struct dma_buffer_info *import,
 			       const char *devpath,
 			       unsigned long flags)
 {
 	FPGA_NODE *package_node;
+	struct dfx_fpga_mgr *mgr;
+	struct dfx_load_record rec = { 0 };
+	unsigned long long start = dfx_stats_now();
+	char mgr_name[FPGA_MGR_NAME_LEN];
 	int err, ret = 0;
 	int platform;
 	size_t len;
 
-	platform = dfx_getplatform();
+	if (dfx_fpga_mgr_name(devpath, mgr_name, sizeof(mgr_name))) {
+		ret = -DFX_INVALID_PARAM;
+		goto END;
+	}
+
+	mgr = get_fpga_mgr(mgr_name);
+	if (mgr == NULL) {
+		DFX_ERR("%s: fail to register fpga manager `%s`", __func__,
+		        mgr_name);
+		ret = -DFX_CREATE_PACKAGE_ERROR;
+		goto END;
+	}
+
+	platform = fpga_mgr_platform(mgr);
 	if (platform == INVALID_PLATFORM) {
-		printf("%s: fpga manager not enabled in the kernel Image\r\n", __func__);
+		DFX_ERR("%s: fpga manager not enabled in the kernel Image", __func__);
 		ret = -DFX_INVALID_PLATFORM_ERROR;
 		goto END;
 	}
 
 	package_node = create_package();
 	if (package_node == NULL) {
-		printf("%s: create_package failed\r\n", __func__);
+		DFX_ERR("%s: create_package failed", __func__);
 		ret = -DFX_CREATE_PACKAGE_ERROR;
 		goto END;
 	}
 
 	package_node->xilplatform = platform;
 	package_node->flags = flags;
+	package_node->mgr = mgr;
 
-	if (dfx_package_path == NULL) {
+	if (mem != NULL) {
+		ret = read_package_mem(package_node, mem);
+		if (ret) {
+			DFX_ERR("%s: package read failed", __func__);
+			goto destroy_package;
+		}
+	} else if (dfx_package_path == NULL) {
 		ret = read_package_byname(package_node, dfx_bin_file,
 					  dfx_dtbo_file, dfx_driver_dtbo_file,
 					  dfx_aes_key_file);
 		if (ret) {
-			printf("%s: package read failed\r\n", __func__);
+			DFX_ERR("%s: package read failed", __func__);
+			goto destroy_package;
+		}
+	} else if (dfx_pkg_is_container(dfx_package_path)) {
+		ret = read_package_container(package_node, dfx_package_path);
+		if (ret) {
+			DFX_ERR("%s: package read failed", __func__);
 			goto destroy_package;
 		}
 	} else {
-		/*Update package path */
+		/*Update package path, with one trailing '/' */
 		len = strlen(dfx_package_path);
-		if (dfx_package_path[len-1] != '/') {
-			/* one for extra char, one for trailing zero */
-			package_node->package_path = (char *)malloc(len + 1 + 1);
-			strcpy(package_node->package_path, dfx_package_path);
-			package_node->package_path[len] = '/';
-			package_node->package_path[len + 1] = '\0';
-		} else {
-			package_node->package_path = (char *)malloc(len + 1);
-			strcpy(package_node->package_path, dfx_package_path);
+		package_node->package_path = package_path_join(package_node,
+				dfx_package_path,
+				dfx_package_path[len - 1] != '/' ? "/" : "");
+		if (package_node->package_path == NULL) {
+			ret = -DFX_INSUFFICIENT_MEM;
+			goto destroy_package;
 		}
 
 		ret = read_package_folder(package_node);
 		if (ret) {
-			printf("%s: package read failed\r\n", __func__);
+			DFX_ERR("%s: package read failed", __func__);
 			goto destroy_package;
 		}
 	}
 
+	ret = package_set_overlay_paths(package_node);
+	if (ret)
+		goto destroy_package;
+
 	if (flags & DFX_ENCRYPTION_USERKEY_EN) {
 		ret = find_key(package_node);
 		if (ret) {
-			printf("%s: fail to get key info\r\n", __func__);
+			DFX_ERR("%s: fail to get key info", __func__);
 			goto destroy_package;
 		}
 	}
 
-	if (!(flags & DFX_EXTERNAL_CONFIG_EN)) {
-		ret = dfx_package_load_dmabuf(package_node, cma_file);
-		if (ret) {
-			printf("%s: load dmabuf failed\r\n", __func__);
+	if (import != NULL) {
+		ret = import_dmabuf(package_node, import);
+		if (ret)
+			goto destroy_package;
+	} else if (!(flags & DFX_EXTERNAL_CONFIG_EN)) {
+		ret = package_choose_path(package_node, cma_file);
+		if (ret)
 			goto destroy_package;
+		if (package_node->load_path == DFX_LOAD_PATH_DMABUF) {
+			ret = dfx_package_load_dmabuf(package_node, cma_file,
+						      &rec);
+			if (ret) {
+				DFX_ERR("%s: load dmabuf failed", __func__);
+				goto destroy_package;
+			}
 		}
 	}
 
+	/* A memory image belongs to the caller, it is not read after init */
+	if (mem != NULL)
+		memset(&package_node->pkg->entry[DFX_PKG_ENTRY_IMAGE], 0,
+		       sizeof(struct dfx_pkg_payload));
+
+	dfx_stats_phase_end(&rec, DFX_PHASE_INIT, start);
+	dfx_stats_commit(&package_node->stats, &rec, 0);
+
 	return package_node->package_id;
 
 destroy_package:
 	err = destroy_package(package_node->package_id);
 	if (err)
-		printf("%s:Destroy package failed \r\n", __func__);
+		DFX_ERR("%s:Destroy package failed ", __func__);
 END:
+	rec.result = ret;
+	dfx_stats_phase_end(&rec, DFX_PHASE_INIT, start);
+	dfx_stats_commit(NULL, &rec, 0);
 	return ret;
 }
 
@@ -1567,68 +3982,68 @@ static int read_package_byname(struct dfx_package_node *package_node,
 			       const char *dfx_driver_dtbo_file,
 			       const char *dfx_aes_key_file)
 {
-	int ret;
-	char *str;
-	char slen;
-
-	if(dfx_bin_file != NULL) {
-		package_node->load_image_path = strdup(dfx_bin_file);
-		str = strdup(get_file_name_from_path(package_node->load_image_path));
-		package_node->load_image_name = str;
-		dfx_set_firmware_search_path(dfx_bin_file);
-	} else {
+	const char *name;
+
+	if (dfx_dtbo_file == NULL)
 		return -DFX_READ_PACKAGE_ERROR;
-	}
 
-	if (dfx_dtbo_file != NULL) {
-		package_node->load_image_dtbo_path = strdup(dfx_dtbo_file);
-		str = strdup(get_file_name_from_path(package_node->load_image_dtbo_path));
-		package_node->load_image_dtbo_name = str;
-		slen = strlen(str) - 4;
-		str = strndup(package_node->load_image_dtbo_name, slen);
-		str[slen - 1] = '\0';
-		package_node->package_name = str;
-		dfx_set_firmware_search_path(dfx_dtbo_file);
+	/* Without an image file the search path follows the overlay */
+	if (dfx_bin_file != NULL) {
+		package_node->load_image_path = package_strdup(package_node,
+							       dfx_bin_file);
+		package_node->load_image_name = package_strdup(package_node,
+					get_file_name_from_path(dfx_bin_file));
+		if (package_node->load_image_name == NULL)
+			return -DFX_INSUFFICIENT_MEM;
 	} else {
-		return -DFX_READ_PACKAGE_ERROR;
+		package_node->load_image_path = package_strdup(package_node,
+							       dfx_dtbo_file);
 	}
 
-	if(dfx_driver_dtbo_file != NULL) {
-		package_node->load_drivers_dtbo_path = strdup(dfx_driver_dtbo_file);
-		str = strdup(get_file_name_from_path(package_node->load_drivers_dtbo_path));
-		package_node->load_drivers_dtbo_name = str;
-		dfx_set_firmware_search_path(dfx_driver_dtbo_file);
-	} else {
-		package_node->load_drivers_dtbo_path = NULL;
-		package_node->load_drivers_dtbo_name = NULL;
+	/* The package is named after the dtbo file, without ".dtbo" */
+	package_node->load_image_dtbo_path = package_strdup(package_node,
+							    dfx_dtbo_file);
+	name = get_file_name_from_path(dfx_dtbo_file);
+	package_node->load_image_dtbo_name = package_strdup(package_node, name);
+	package_node->package_name = package_strndup(package_node, name,
+						     strlen(name) - 5);
+
+	if (dfx_driver_dtbo_file != NULL) {
+		package_node->load_drivers_dtbo_path =
+			package_strdup(package_node, dfx_driver_dtbo_file);
+		package_node->load_drivers_dtbo_name =
+			package_strdup(package_node,
+				get_file_name_from_path(dfx_driver_dtbo_file));
+		if (package_node->load_drivers_dtbo_path == NULL ||
+		    package_node->load_drivers_dtbo_name == NULL)
+			return -DFX_INSUFFICIENT_MEM;
 	}
 
 	if (dfx_aes_key_file != NULL) {
-		package_node->load_aes_file_path = strdup(dfx_aes_key_file);
-		str = strdup(get_file_name_from_path(package_node->load_aes_file_path));
-		package_node->load_aes_file_name = str;
-	} else {
-		package_node->load_aes_file_path = NULL;
-		package_node->load_aes_file_name = NULL;
+		package_node->load_aes_file_path =
+			package_strdup(package_node, dfx_aes_key_file);
+		package_node->load_aes_file_name =
+			package_strdup(package_node,
+				get_file_name_from_path(dfx_aes_key_file));
+		if (package_node->load_aes_file_path == NULL ||
+		    package_node->load_aes_file_name == NULL)
+			return -DFX_INSUFFICIENT_MEM;
 	}
 
+	if (package_node->load_image_path == NULL ||
+	    package_node->load_image_dtbo_path == NULL ||
+	    package_node->load_image_dtbo_name == NULL ||
+	    package_node->package_name == NULL)
+		return -DFX_INSUFFICIENT_MEM;
+
 	return 0;
 }
 
-static char *get_file_name_from_path(char *full_path)
+static const char *get_file_name_from_path(const char *full_path)
 {
-	char *ssc;
-	int l = 0;
-	char *path = full_path;
-
-	ssc = strstr(path, "/");
-	do{
-		l = strlen(ssc) + 1;
-		path = &path[strlen(path)-l+2];
-		ssc = strstr(path, "/");
-	}while(ssc);
+	const char *name = strrchr(full_path, '/');
 
-	return path;
+	return name ? name + 1 : full_path;
 }
 
 /**
@@ -1647,21 +4062,20 @@ int dfx_set_firmware_search_path(const char *file_path)
 	char *parent_dir;
 	int fd = -1;
 	int rc = -1;
-	const char *lookup_control =
-		"/sys/module/firmware_class/parameters/path";
+	const char *lookup_control = dfx_root(DFX_ROOT_FW_SEARCH_PATH);
 
 	if (!file_path) {
-		printf("%s: ERROR: path provided is NULL\n", __func__);
+		DFX_ERR("%s: ERROR: path provided is NULL", __func__);
 		goto END;
 	}
 
 	if (strlen(file_path) >= sizeof(path_copy)) {
-		printf("%s: WARN: path provided is too long, truncating\n", __func__);
+		DFX_WARN("%s: WARN: path provided is too long, truncating", __func__);
 	}
 
 	strlcpy(path_copy, file_path, sizeof(path_copy));
 	if (file_path[0]) {
-		printf("%s: Setting lookup path for `%s`\n", __func__, file_path);
+		DFX_DBG("%s: Setting lookup path for `%s`", __func__, file_path);
 	}
 
 	// derive parent directory
@@ -1672,13 +4086,13 @@ int dfx_set_firmware_search_path(const char *file_path)
 
 	fd = open(lookup_control, O_WRONLY);
 	if (fd < 0) {
-		printf("%s: ERROR: failed to open firmware path parameter\n", __func__);
+		DFX_ERR("%s: ERROR: failed to open firmware path parameter", __func__);
 		goto END;
 	}
 
-	printf("%s: Writing `%s` to %s\n", __func__, parent_dir, lookup_control);
+	DFX_DBG("%s: Writing `%s` to %s", __func__, parent_dir, lookup_control);
 	if (write(fd, parent_dir, strlen(parent_dir)) < 0) {
-		printf("%s: ERROR: failed to write firmware lookup path\n", __func__);
+		DFX_ERR("%s: ERROR: failed to write firmware lookup path", __func__);
 		goto END;
 	}
 
@@ -1691,11 +4105,11 @@ int dfx_set_firmware_search_path(const char *file_path)
 		}
 
 	if (rc < 0) {
-		printf("%s: WARN: Failed to set firmware search path. "
+		DFX_WARN("%s: WARN: Failed to set firmware search path. "
 			   "Success only possible if the requested files live in "
 			   "defaults.\nSee "
 			   "https://docs.kernel.org/driver-api/firmware/"
-			   "fw_search_path.html for more information\n",
+			   "fw_search_path.html for more information",
 			   __func__);
 	}
 
@@ -1727,38 +4141,38 @@ static int validate_input_files(const char *dfx_bin_file,
 	if ((strcmp(dfx_bin_file + (len - 4), ".bit")) &&
 	    (strcmp(dfx_bin_file + (len - 4), ".bin")) &&
             (strcmp(dfx_bin_file + (len - 4), ".pdi"))) {
-		printf("%s: Invalid bitstream file extension\r\n", __func__);
-		printf("%s: File extension should be .bit (or) .bin (or) .pdi\n", __func__);
+		DFX_ERR("%s: Invalid bitstream file extension", __func__);
+		DFX_ERR("%s: File extension should be .bit (or) .bin (or) .pdi", __func__);
 		return -DFX_INVALID_PARAM;
 	}
 
 	if (!file_exists(dfx_bin_file)) {
-		printf("%s: User provided bitstream file doesn't exist\r\n", __func__);
+		DFX_ERR("%s: User provided bitstream file doesn't exist", __func__);
 		return -DFX_INVALID_PARAM;
 	}
 
 	len = strlen(dfx_dtbo_file);
 	if (strcmp(dfx_dtbo_file + (len - 5), ".dtbo")) {
-		printf("%s: Invalid Overlay file extension\r\n", __func__);
-		printf("%s: File extension should be .dtbo\n", __func__);
+		DFX_ERR("%s: Invalid Overlay file extension", __func__);
+		DFX_ERR("%s: File extension should be .dtbo", __func__);
 		return -DFX_INVALID_PARAM;
 	}
 
 	if (!file_exists(dfx_dtbo_file)) {
-		printf("%s: User provided Overlay file doesn't exist\r\n", __func__);
+		DFX_ERR("%s: User provided Overlay file doesn't exist", __func__);
 		return -DFX_INVALID_PARAM;
 	}
 
 	if (dfx_driver_dtbo_file != NULL) {
 		len = strlen(dfx_driver_dtbo_file);
 		if (strcmp(dfx_driver_dtbo_file + (len - 5), ".dtbo")) {
-			printf("%s: Invalid PL IP's Overlay file extension\r\n", __func__);
-			printf("%s: File extension should be .dtbo\n", __func__);
+			DFX_ERR("%s: Invalid PL IP's Overlay file extension", __func__);
+			DFX_ERR("%s: File extension should be .dtbo", __func__);
 			return -DFX_INVALID_PARAM;
 		}
 
 		if (!file_exists(dfx_driver_dtbo_file)) {
-			printf("%s: User provided PL IP's Overlay file doesn't exist\r\n", __func__);
+			DFX_ERR("%s: User provided PL IP's Overlay file doesn't exist", __func__);
 			return -DFX_INVALID_PARAM;
 		}
 	}
@@ -1766,13 +4180,13 @@ static int validate_input_files(const char *dfx_bin_file,
 	if (flags & DFX_ENCRYPTION_USERKEY_EN) {
 		len = strlen(dfx_aes_key_file);
 		if (strcmp(dfx_aes_key_file + (len - 4), ".nky")) {
-			printf("%s: Invalid AES key file extension\r\n", __func__);
-			printf("%s: File extension should be .nky\n", __func__);
+			DFX_ERR("%s: Invalid AES key file extension", __func__);
+			DFX_ERR("%s: File extension should be .nky", __func__);
 			return -DFX_INVALID_PARAM;
 		}
 
 		if (!file_exists(dfx_aes_key_file)) {
-			printf("%s: User provided AES key file doesn't exist\r\n", __func__);
+			DFX_ERR("%s: User provided AES key file doesn't exist", __func__);
 			return -DFX_INVALID_PARAM;
 		}
 	}
@@ -1780,9 +4194,3 @@ static int validate_input_files(const char *dfx_bin_file,
 	return 0;
 }
 
-#ifdef ENABLE_LIBDFX_TIME
-static inline double gettime(struct timeval  t0, struct timeval t1)
-{
-	return ((t1.tv_sec - t0.tv_sec) * 1000.0f + (t1.tv_usec -t0.tv_usec) / 1000.0f);
-}
-#endif